@@ -493,6 +493,440 @@ static void test_content(test_batch_runner *runner, cmark_node_type type,
 static void parser(test_batch_runner *runner) {
   test_md_to_html(runner, "No newline", "<p>No newline</p>\n",
                   "document without trailing newline");
+  test_md_to_html(runner, "<http://example.com",
+                  "<p>&lt;http://example.com</p>\n",
+                  "autolink cut off at end of input");
+  test_md_to_html(runner, "```", "<pre><code></code></pre>\n",
+                  "code fence at end of input");
+
+  FILE *fp = tmpfile();
+  if (fp) {
+    static const char markdown[] = "skipped\n# Title\n\nbody\nline";
+    fwrite(markdown, 1, sizeof(markdown) - 1, fp);
+    fseek(fp, 8, SEEK_SET);
+    cmark_node *doc = cmark_parse_file(fp, CMARK_OPT_DEFAULT);
+    char *html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+    STR_EQ(runner, html, "<h1>Title</h1>\n<p>body\nline</p>\n",
+           "parse file from current position");
+    free(html);
+    cmark_node_free(doc);
+    fclose(fp);
+  }
+}
+
+static void parser_pool(test_batch_runner *runner) {
+  cmark_parser_pool *pool = cmark_parser_pool_new(CMARK_OPT_DEFAULT);
+  cmark_parser *parser, *second;
+  cmark_node *doc;
+  char *html;
+
+  parser = cmark_parser_pool_checkout(pool);
+  cmark_parser_feed(parser, "[a]\n\n[a]: /url\n", 15);
+  doc = cmark_parser_finish(parser);
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "<p><a href=\"/url\">a</a></p>\n",
+         "pooled parser parses");
+  free(html);
+  cmark_node_free(doc);
+  cmark_parser_pool_return(pool, parser);
+
+  second = cmark_parser_pool_checkout(pool);
+  OK(runner, second == parser, "returned parser is reused");
+  cmark_parser_feed(second, "[a]\n", 4);
+  doc = cmark_parser_finish(second);
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "<p>[a]</p>\n",
+         "references do not carry over to the next document");
+  free(html);
+  cmark_node_free(doc);
+
+  // Return a parser in the middle of a document.
+  cmark_parser_feed(second, "> unfinished", 12);
+  cmark_parser_pool_return(pool, second);
+
+  parser = cmark_parser_pool_checkout(pool);
+  cmark_parser_feed(parser, "# Title\n", 8);
+  doc = cmark_parser_finish(parser);
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "<h1>Title</h1>\n",
+         "unfinished document is discarded on return");
+  free(html);
+  cmark_node_free(doc);
+
+  second = cmark_parser_pool_checkout(pool);
+  OK(runner, second != parser, "busy parser is not handed out twice");
+  cmark_parser_pool_return(pool, second);
+  cmark_parser_pool_return(pool, parser);
+
+  cmark_parser_pool_free(pool);
+
+#ifdef HAVE_BUILTIN_EXTENSIONS
+  pool = cmark_parser_pool_new(CMARK_OPT_DEFAULT);
+  OK(runner,
+     cmark_parser_pool_attach_syntax_extension(
+         pool, cmark_find_syntax_extension("tilde_strikethrough")),
+     "extension attached to pool");
+  parser = cmark_parser_pool_checkout(pool);
+  OK(runner,
+     !cmark_parser_pool_attach_syntax_extension(
+         pool, cmark_find_syntax_extension("piped-tables")),
+     "extensions cannot be attached after checkout");
+  cmark_parser_feed(parser, "~~x~~\n", 6);
+  doc = cmark_parser_finish(parser);
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "<p><del>x</del></p>\n",
+         "pooled parser has the pool's extensions");
+  free(html);
+  cmark_node_free(doc);
+  cmark_parser_pool_return(pool, parser);
+  cmark_parser_pool_free(pool);
+#endif
+}
+
+static void parser_stats(test_batch_runner *runner) {
+  static const char markdown[] = "# Title\n"
+                                 "\n"
+                                 "> *a* **b** [x]\n"
+                                 "\n"
+                                 "[x]: /url\n";
+  cmark_parser_stats stats;
+  cmark_parser *parser;
+  cmark_node *doc;
+  char *html;
+
+  parser = cmark_parser_new(CMARK_OPT_DEFAULT);
+  OK(runner, !cmark_parser_get_stats(parser, &stats),
+     "no stats without the instrumented allocator");
+  cmark_parser_free(parser);
+
+  parser = cmark_parser_new_with_mem(CMARK_OPT_DEFAULT,
+                                     cmark_get_instrumented_mem_allocator());
+  cmark_parser_feed(parser, markdown, sizeof(markdown) - 1);
+  doc = cmark_parser_finish(parser);
+  OK(runner, cmark_parser_get_stats(parser, &stats), "stats are collected");
+
+  INT_EQ(runner, (int)stats.nodes[CMARK_NODE_HEADING], 1, "heading count");
+  INT_EQ(runner, (int)stats.nodes[CMARK_NODE_EMPH], 1, "emph count");
+  INT_EQ(runner, (int)stats.nodes[CMARK_NODE_STRONG], 1, "strong count");
+  INT_EQ(runner, (int)stats.nodes[CMARK_NODE_LINK], 1, "link count");
+  INT_EQ(runner, (int)stats.nodes_total, 13, "total node count");
+  INT_EQ(runner, (int)stats.reference_definitions, 1,
+         "reference definition count");
+  INT_EQ(runner, (int)stats.delimiters_peak, 4, "delimiter stack peak");
+  INT_EQ(runner, stats.max_depth, 4, "max depth");
+  OK(runner, stats.allocations > 0, "allocations are counted");
+  OK(runner, stats.bytes_live > 0 && stats.bytes_live <= stats.bytes_peak &&
+             stats.bytes_peak <= stats.bytes_allocated,
+     "byte counts are consistent");
+  {
+    size_t allocations = 0, bytes = 0;
+    int site;
+
+    for (site = 0; site <= CMARK_ALLOC_LAST; site++) {
+      allocations += stats.site_allocations[site];
+      bytes += stats.site_bytes[site];
+    }
+    OK(runner, allocations == stats.allocations && bytes == stats.bytes_allocated,
+       "every allocation is attributed to a site");
+  }
+  OK(runner, stats.site_allocations[CMARK_ALLOC_NODE] > 0 &&
+             stats.site_allocations[CMARK_ALLOC_STRBUF] > 0 &&
+             stats.site_allocations[CMARK_ALLOC_DELIMITER] > 0 &&
+             stats.site_allocations[CMARK_ALLOC_REFERENCE] > 0,
+     "allocation sites are tagged");
+  INT_EQ(runner, (int)stats.node_allocations[CMARK_NODE_HEADING], 1,
+         "heading allocations");
+  INT_EQ(runner, (int)stats.node_allocations[CMARK_NODE_LINK], 1,
+         "link allocations");
+
+  // Memory from the instrumented allocator is plain heap memory.
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  free(html);
+  cmark_node_free(doc);
+
+  cmark_parser_feed(parser, "plain\n", 6);
+  doc = cmark_parser_finish(parser);
+  cmark_parser_get_stats(parser, &stats);
+  INT_EQ(runner, (int)stats.nodes_total, 3, "stats are per document");
+  INT_EQ(runner, (int)stats.reference_definitions, 0,
+         "references are per document");
+  cmark_node_free(doc);
+  cmark_parser_free(parser);
+}
+
+static cmark_node *parse_with_limits(cmark_parser *parser, const char *text,
+                                     const cmark_parser_limits *limits) {
+  cmark_parser_set_limits(parser, limits);
+  cmark_parser_feed(parser, text, strlen(text));
+  return cmark_parser_finish(parser);
+}
+
+static void parser_limits(test_batch_runner *runner) {
+  cmark_parser_limits limits;
+  cmark_parser_stats stats;
+  cmark_parser *parser = cmark_parser_new(CMARK_OPT_DEFAULT);
+  static char input[1000 * 6 + 1];
+  cmark_node *doc;
+  char *html;
+  int i;
+
+  for (i = 0; i < 1000; i++)
+    memcpy(input + i * 6, "para\n\n", 6);
+
+  memset(&limits, 0, sizeof(limits));
+  limits.max_nodes = 10;
+  doc = parse_with_limits(parser, input, &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser), CMARK_PARSER_ERROR_NODE_LIMIT,
+         "node limit is reported");
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html + strlen(html) - 12, "<p>para</p>\n",
+         "text before the node limit is kept");
+  OK(runner, strlen(html) == 11 * strlen("<p>para</p>\n"),
+     "parsing stops at the node limit");
+  free(html);
+  cmark_node_free(doc);
+
+  doc = parse_with_limits(parser, "para\n", &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser), CMARK_PARSER_OK,
+         "limits apply to each document");
+  cmark_node_free(doc);
+
+  memset(&limits, 0, sizeof(limits));
+  limits.max_depth = 2;
+  doc = parse_with_limits(parser, "> > > deep\n", &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser),
+         CMARK_PARSER_ERROR_DEPTH_LIMIT, "depth limit is reported");
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html,
+         "<blockquote>\n<blockquote>\n</blockquote>\n</blockquote>\n",
+         "nodes below the depth limit are dropped");
+  free(html);
+  cmark_node_free(doc);
+
+  limits.max_depth = 3;
+  doc = parse_with_limits(parser, "> a\n> b\n\nc\n", &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser), CMARK_PARSER_OK,
+         "nodes at the depth limit are kept");
+  cmark_node_free(doc);
+
+  doc = parse_with_limits(parser, "> a *b*\n\nc\n", &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser),
+         CMARK_PARSER_ERROR_DEPTH_LIMIT, "inline depth limit is reported");
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html,
+         "<blockquote>\n<p>a <em></em></p>\n</blockquote>\n<p>c</p>\n",
+         "inlines below the depth limit are dropped");
+  free(html);
+  cmark_node_free(doc);
+
+  memset(&limits, 0, sizeof(limits));
+  limits.max_delimiters = 10;
+  doc = parse_with_limits(parser, "*a* *b* *c* *d* *e* *f* *g*\n", &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser),
+         CMARK_PARSER_ERROR_DELIMITER_LIMIT, "delimiter limit is reported");
+  cmark_node_free(doc);
+  cmark_parser_free(parser);
+
+  parser = cmark_parser_new_with_mem(CMARK_OPT_DEFAULT,
+                                     cmark_get_instrumented_mem_allocator());
+  memset(&limits, 0, sizeof(limits));
+  limits.max_bytes = 4096;
+  doc = parse_with_limits(parser, input, &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser),
+         CMARK_PARSER_ERROR_MEMORY_LIMIT, "memory limit is reported");
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  OK(runner, strlen(html) < strlen(input),
+     "parsing stops at the memory limit");
+  free(html);
+  cmark_node_free(doc);
+
+  // The blocks past the depth limit are never made.
+  for (i = 0; i < 1000; i++)
+    memcpy(input + i * 2, "> ", 2);
+  memcpy(input + 2000, "x\n\npara\n", 9);
+  memset(&limits, 0, sizeof(limits));
+  limits.max_depth = 10;
+  doc = parse_with_limits(parser, input, &limits);
+  INT_EQ(runner, cmark_parser_get_error(parser),
+         CMARK_PARSER_ERROR_DEPTH_LIMIT, "block depth limit is reported");
+  cmark_parser_get_stats(parser, &stats);
+  INT_EQ(runner, (int)stats.node_allocations[CMARK_NODE_BLOCK_QUOTE], 11,
+         "parsing stops at the depth limit");
+  OK(runner, stats.max_depth <= 10, "depth of the document is limited");
+  cmark_node_free(doc);
+  cmark_parser_free(parser);
+}
+
+static void parser_profiler(test_batch_runner *runner) {
+  static const char markdown[] = "[a] *b*\n\n[a]: /url\n";
+  cmark_parser *parser = cmark_parser_new(CMARK_OPT_DEFAULT);
+  cmark_profile profile;
+  cmark_phase_timing *feed, *finalize, *inlines;
+  cmark_node *doc, *node;
+  uint64_t before, after;
+  char *html;
+
+  doc = cmark_parse_document(markdown, sizeof(markdown) - 1, CMARK_OPT_DEFAULT);
+  OK(runner, !cmark_node_get_profile(doc, &profile),
+     "no profile without a profiler");
+  INT_EQ(runner, (int)profile.phases[CMARK_PHASE_FEED].count, 0,
+         "missing profile is zeroed");
+  cmark_node_free(doc);
+
+  cmark_parser_set_profiler(parser, true);
+  before = cmark_profile_clock();
+  cmark_parser_feed(parser, markdown, 10);
+  cmark_parser_feed(parser, markdown + 10, sizeof(markdown) - 11);
+  doc = cmark_parser_finish(parser);
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  after = cmark_profile_clock();
+  free(html);
+
+  OK(runner, cmark_node_get_profile(doc, &profile), "document has a profile");
+  feed = &profile.phases[CMARK_PHASE_FEED];
+  finalize = &profile.phases[CMARK_PHASE_FINALIZE];
+  inlines = &profile.phases[CMARK_PHASE_INLINES];
+  INT_EQ(runner, (int)feed->count, 2, "each feed is timed");
+  INT_EQ(runner, (int)finalize->count, 1, "finish is timed");
+  INT_EQ(runner, (int)inlines->count, 1, "inline parsing is timed");
+  INT_EQ(runner, (int)profile.phases[CMARK_PHASE_REFERENCES].count, 1,
+         "reference lookups are timed");
+  INT_EQ(runner, (int)profile.phases[CMARK_PHASE_CONSOLIDATE].count, 1,
+         "consolidation is timed");
+  INT_EQ(runner, (int)profile.phases[CMARK_PHASE_RENDER_HTML].count, 1,
+         "rendering is timed");
+  INT_EQ(runner, (int)profile.phases[CMARK_PHASE_RENDER_XML].count, 0,
+         "renderers that did not run are not");
+  OK(runner,
+     before <= feed->first_start_ns && feed->first_start_ns <= feed->last_end_ns &&
+         feed->last_end_ns <= finalize->first_start_ns &&
+         profile.phases[CMARK_PHASE_RENDER_HTML].last_end_ns <= after,
+     "timestamps are ordered");
+  OK(runner,
+     finalize->first_start_ns <= inlines->first_start_ns &&
+         inlines->last_end_ns <= finalize->last_end_ns &&
+         inlines->total_ns <= finalize->total_ns,
+     "inline parsing nests in finish");
+
+  html = cmark_render_commonmark(doc, CMARK_OPT_DEFAULT, 0);
+  free(html);
+  cmark_node_get_profile(doc, &profile);
+  INT_EQ(runner, (int)profile.phases[CMARK_PHASE_RENDER_COMMONMARK].count, 1,
+         "later renders are added to the profile");
+  cmark_node_free(doc);
+
+  doc = cmark_parser_finish(parser);
+  cmark_node_get_profile(doc, &profile);
+  INT_EQ(runner, (int)profile.phases[CMARK_PHASE_FEED].count, 0,
+         "each document has a profile of its own");
+  cmark_node_free(doc);
+
+  doc = cmark_node_new(CMARK_NODE_PARAGRAPH);
+  OK(runner, !cmark_node_get_profile(doc, &profile),
+     "only documents have profiles");
+  cmark_node_free(doc);
+
+  // A node made a document has none of the data of its old type.
+  doc = cmark_parse_document("# hi\n", 5, CMARK_OPT_DEFAULT);
+  node = cmark_node_first_child(doc);
+  cmark_node_unlink(node);
+  cmark_node_free(doc);
+  OK(runner, cmark_node_set_type(node, CMARK_NODE_DOCUMENT),
+     "heading made a document");
+  OK(runner, !cmark_node_get_profile(node, &profile),
+     "retyped document has no profile");
+  html = cmark_render_html(node, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "hi", "retyped document renders");
+  free(html);
+  cmark_node_free(node);
+
+  cmark_parser_free(parser);
+}
+
+static void builtin_extensions(test_batch_runner *runner) {
+#ifdef HAVE_BUILTIN_EXTENSIONS
+  cmark_syntax_extension *ext;
+  cmark_parser *parser;
+  cmark_node *doc;
+  char *html;
+
+  cmark_register_builtin_extensions();
+  cmark_register_builtin_extensions();
+
+  ext = cmark_find_syntax_extension("tilde_strikethrough");
+  OK(runner, ext != NULL, "built-in extension is registered");
+  if (ext == NULL)
+    return;
+
+  parser = cmark_parser_new(CMARK_OPT_DEFAULT);
+  cmark_parser_attach_syntax_extension(parser, ext);
+
+  // The parser's reference keeps the extension alive after the registry
+  // has let go of it.
+  cmark_deinit();
+
+  cmark_parser_feed(parser, "~~gone~~\n", 9);
+  doc = cmark_parser_finish(parser);
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "<p><del>gone</del></p>\n",
+         "built-in extension is usable");
+  free(html);
+  cmark_node_free(doc);
+  cmark_parser_free(parser);
+#else
+  (void)runner;
+#endif
+}
+
+// Turns a 'z' at the start of a run of text into inline code.
+static cmark_node *match_z(cmark_syntax_extension *self, cmark_parser *parser,
+                           cmark_node *parent, unsigned char character,
+                           cmark_inline_parser *inline_parser) {
+  cmark_node *node;
+
+  (void)self;
+  (void)parser;
+  (void)parent;
+  if (character != 'z')
+    return NULL;
+  cmark_inline_parser_advance_offset(inline_parser);
+  node = cmark_node_new(CMARK_NODE_CODE);
+  cmark_node_set_literal(node, "z");
+  return node;
+}
+
+static delimiter *insert_nothing(cmark_syntax_extension *self,
+                                 cmark_parser *parser,
+                                 cmark_inline_parser *inline_parser,
+                                 delimiter *opener, delimiter *closer) {
+  (void)self;
+  (void)parser;
+  (void)inline_parser;
+  (void)opener;
+  return closer->next;
+}
+
+static void inline_extension_without_chars(test_batch_runner *runner) {
+  cmark_syntax_extension *ext = cmark_syntax_extension_new("z");
+  cmark_parser *parser = cmark_parser_new(CMARK_OPT_DEFAULT);
+  cmark_node *doc;
+  char *html;
+
+  // Without special characters, it is tried wherever text starts.
+  ext->match_inline = match_z;
+  ext->insert_inline_from_delim = insert_nothing;
+  cmark_parser_attach_syntax_extension(parser, ext);
+  cmark_parser_feed(parser, "z *z* az\\\nz\n", 12);
+  doc = cmark_parser_finish(parser);
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html,
+         "<p><code>z</code> <em><code>z</code></em> az<br />\n"
+         "<code>z</code></p>\n",
+         "extension without special characters is tried");
+  free(html);
+  cmark_node_free(doc);
+  cmark_parser_free(parser);
+  cmark_syntax_extension_free(ext);
 }
 
 static void render_html(test_batch_runner *runner) {
@@ -520,6 +954,28 @@ static void render_html(test_batch_runner *runner) {
   free(html);
 
   cmark_node_free(doc);
+
+  static const char list_markdown[] = "## Items\n"
+                                      "\n"
+                                      "-12. foo\n"
+                                      "13. bar\n";
+  doc = cmark_parse_document(list_markdown, sizeof(list_markdown) - 1,
+                             CMARK_OPT_DEFAULT);
+  html = cmark_render_html(doc, CMARK_OPT_SOURCEPOS);
+  STR_EQ(runner, html, "<h2 data-sourcepos=\"1:1-1:8\">Items</h2>\n"
+                       "<p data-sourcepos=\"3:1-4:7\">-12. foo\n13. bar</p>\n",
+         "render sourcepos");
+  free(html);
+  cmark_node_free(doc);
+
+  cmark_node *list = cmark_node_new(CMARK_NODE_LIST);
+  cmark_node_set_list_type(list, CMARK_ORDERED_LIST);
+  cmark_node_set_list_start(list, 1234567890);
+  html = cmark_render_html(list, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "<ol start=\"1234567890\">\n</ol>\n",
+         "render large list start");
+  free(html);
+  cmark_node_free(list);
 }
 
 static void render_xml(test_batch_runner *runner) {
@@ -692,6 +1148,280 @@ static void render_commonmark(test_batch_runner *runner) {
   cmark_node_free(doc);
 }
 
+static void serialization(test_batch_runner *runner) {
+  static const char markdown[] = "Title\n"
+                                 "=====\n"
+                                 "\n"
+                                 "3. a\n"
+                                 "4. b *c* [d](/u \"t\") `e`\n"
+                                 "\n"
+                                 "```py\n"
+                                 "code\n"
+                                 "```\n"
+                                 "\n"
+                                 "<div>x</div>\n"
+                                 "\n"
+                                 "| a | b |\n"
+                                 "|---|---|\n"
+                                 "| c | ~~d~~ |\n";
+  int options = CMARK_OPT_SOURCEPOS;
+  cmark_parser *parser = cmark_parser_new(options);
+  cmark_node *doc, *copy, *view;
+  unsigned char *data, *bad;
+  size_t len, len_with_child;
+  char *expected_xml, *expected_html, *xml, *html;
+
+#ifdef HAVE_BUILTIN_EXTENSIONS
+  cmark_register_builtin_extensions();
+  cmark_parser_attach_syntax_extension(
+      parser, cmark_find_syntax_extension("piped-tables"));
+  cmark_parser_attach_syntax_extension(
+      parser, cmark_find_syntax_extension("tilde_strikethrough"));
+#endif
+  cmark_parser_feed(parser, markdown, sizeof(markdown) - 1);
+  doc = cmark_parser_finish(parser);
+  cmark_parser_free(parser);
+  cmark_node_set_html_attrs(cmark_node_first_child(doc), "id=\"title\"");
+
+  data = cmark_node_serialize(doc, &len);
+  OK(runner, data != NULL && len > 0, "serialize");
+  expected_xml = cmark_render_xml(doc, options);
+  expected_html = cmark_render_html(doc, options);
+  cmark_node_free(doc);
+
+  copy = cmark_node_deserialize(data, len);
+  OK(runner, copy != NULL, "deserialize");
+  xml = cmark_render_xml(copy, options);
+  STR_EQ(runner, xml, expected_xml, "deserialized tree as XML");
+  free(xml);
+  html = cmark_render_html(copy, options);
+  STR_EQ(runner, html, expected_html, "deserialized tree as HTML");
+  free(html);
+  cmark_node_free(copy);
+
+  bad = (unsigned char *)malloc(len);
+  memcpy(bad, data, len);
+  view = cmark_node_deserialize_view(data, len);
+  OK(runner, view != NULL, "deserialize as a view");
+  html = cmark_render_html(view, options);
+  STR_EQ(runner, html, expected_html, "view as HTML");
+  free(html);
+  // The heading's text
+  OK(runner,
+     cmark_node_set_literal(
+         cmark_node_first_child(cmark_node_first_child(view)), "Changed"),
+     "set a literal in a view");
+  STR_EQ(runner,
+         cmark_node_get_literal(
+             cmark_node_first_child(cmark_node_first_child(view))),
+         "Changed", "literal of a view");
+  cmark_node_free(view);
+  OK(runner, memcmp(bad, data, len) == 0, "a view leaves its data alone");
+
+  OK(runner, cmark_node_deserialize(bad, len - 1) == NULL,
+     "truncated data is rejected");
+  bad[4] = 2;
+  OK(runner, cmark_node_deserialize(bad, len) == NULL,
+     "other versions are rejected");
+  memcpy(bad, data, len);
+  bad[0] = 'X';
+  OK(runner, cmark_node_deserialize(bad, len) == NULL,
+     "bad magic is rejected");
+  OK(runner, cmark_node_deserialize(NULL, 0) == NULL, "NULL is rejected");
+  free(bad);
+
+  free(expected_xml);
+  free(expected_html);
+  free(data);
+
+  // A tree whose second node names a parent that comes after it.
+  doc = cmark_node_new(CMARK_NODE_DOCUMENT);
+  bad = cmark_node_serialize(doc, &len);
+  free(bad);
+  cmark_node_append_child(doc, cmark_node_new(CMARK_NODE_PARAGRAPH));
+  data = cmark_node_serialize(doc, &len_with_child);
+  cmark_node_free(doc);
+  copy = cmark_node_deserialize(data, len_with_child);
+  OK(runner, copy != NULL, "tree without text");
+  cmark_node_free(copy);
+  data[len + 2] = 9; // after its type and the set of fields it has
+  OK(runner, cmark_node_deserialize(data, len_with_child) == NULL,
+     "forward parent is rejected");
+  free(data);
+}
+
+static void flat_tree(test_batch_runner *runner) {
+  static const char markdown[] = "# Title\n"
+                                 "\n"
+                                 "- a *b* [c](/u \"t\")\n"
+                                 "- `d`\n"
+                                 "\n"
+                                 "```py\n"
+                                 "code\n"
+                                 "```\n";
+  cmark_node *doc = cmark_parse_document(markdown, sizeof(markdown) - 1,
+                                         CMARK_OPT_DEFAULT);
+  char *expected_html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  char *expected_commonmark =
+      cmark_render_commonmark(doc, CMARK_OPT_DEFAULT, 0);
+  cmark_flat_tree *tree = cmark_node_freeze(doc);
+  const uint8_t *types;
+  const uint32_t *parents, *first_children, *next_siblings;
+  cmark_iter *iter;
+  cmark_event_type ev_type;
+  uint32_t i, size, consistent = 1;
+  char *html, *commonmark;
+
+  cmark_node_free(doc);
+  OK(runner, tree != NULL, "freeze");
+  size = cmark_flat_tree_size(tree);
+  types = cmark_flat_tree_types(tree);
+  parents = cmark_flat_tree_parents(tree);
+  first_children = cmark_flat_tree_first_children(tree);
+  next_siblings = cmark_flat_tree_next_siblings(tree);
+  INT_EQ(runner, (int)size, 16, "frozen size");
+  INT_EQ(runner, types[0], CMARK_NODE_DOCUMENT, "root type");
+  OK(runner, parents[0] == CMARK_FLAT_NONE, "root has no parent");
+  INT_EQ(runner, types[1], CMARK_NODE_HEADING, "first child type");
+
+  // The arrays describe the same tree as the nodes, in document order.
+  i = 0;
+  iter = cmark_iter_new(cmark_flat_tree_node(tree, 0));
+  while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cmark_node *node = cmark_iter_get_node(iter);
+
+    if (ev_type != CMARK_EVENT_ENTER)
+      continue;
+    if (node != cmark_flat_tree_node(tree, i) ||
+        types[i] != cmark_node_get_type(node) ||
+        (first_children[i] != CMARK_FLAT_NONE) !=
+            (cmark_node_first_child(node) != NULL) ||
+        (first_children[i] != CMARK_FLAT_NONE && first_children[i] != i + 1) ||
+        (next_siblings[i] != CMARK_FLAT_NONE &&
+         cmark_flat_tree_node(tree, next_siblings[i]) !=
+             cmark_node_next(node)) ||
+        (parents[i] != CMARK_FLAT_NONE &&
+         cmark_flat_tree_node(tree, parents[i]) != cmark_node_parent(node)))
+      consistent = 0;
+    i++;
+  }
+  cmark_iter_free(iter);
+  OK(runner, consistent && i == size, "arrays match the nodes");
+  OK(runner, cmark_flat_tree_node(tree, size) == NULL, "node out of range");
+  STR_EQ(runner, cmark_node_get_url(cmark_flat_tree_node(tree, 10)), "/u",
+         "frozen url");
+
+  html = cmark_flat_tree_render_html(tree, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, expected_html, "frozen tree as HTML");
+  free(html);
+  commonmark = cmark_flat_tree_render_commonmark(tree, CMARK_OPT_DEFAULT, 0);
+  STR_EQ(runner, commonmark, expected_commonmark,
+         "frozen tree as commonmark");
+  free(commonmark);
+
+  cmark_flat_tree_free(tree);
+  free(expected_html);
+  free(expected_commonmark);
+}
+
+// Replaces 'old_len' bytes at 'start' in 'text' with 'insert', reparses
+// the document of 'text' after that edit, and compares it with a full
+// parse of the result, source positions included.
+static void test_reparse(test_batch_runner *runner, const char *text,
+                         size_t start, size_t old_len, const char *insert,
+                         int options, const char *msg) {
+  size_t len = strlen(text), new_len = strlen(insert);
+  char *edited = (char *)malloc(len - old_len + new_len + 1);
+  cmark_node *doc = cmark_parse_document(text, len, options);
+  cmark_node *expected, *result;
+  char *xml, *expected_xml;
+
+  memcpy(edited, text, start);
+  memcpy(edited + start, insert, new_len);
+  strcpy(edited + start + new_len, text + start + old_len);
+  len = strlen(edited);
+
+  result = cmark_reparse(doc, edited, len, start, old_len, new_len, options);
+  OK(runner, result == doc, "%s: root is updated in place", msg);
+  expected = cmark_parse_document(edited, len, options);
+  xml = cmark_render_xml(doc, CMARK_OPT_SOURCEPOS);
+  expected_xml = cmark_render_xml(expected, CMARK_OPT_SOURCEPOS);
+  STR_EQ(runner, xml, expected_xml, "%s", msg);
+
+  free(xml);
+  free(expected_xml);
+  cmark_node_free(expected);
+  cmark_node_free(doc);
+  free(edited);
+}
+
+static void incremental_reparse(test_batch_runner *runner) {
+  static const char markdown[] = "# Title\n"
+                                 "\n"
+                                 "See [one] and [two].\n"
+                                 "\n"
+                                 "- a\n"
+                                 "- b\n"
+                                 "\n"
+                                 "```\n"
+                                 "code\n"
+                                 "```\n"
+                                 "\n"
+                                 "Last *paragraph*.\n"
+                                 "\n"
+                                 "[one]: /first\n";
+  int options = CMARK_OPT_INCREMENTAL;
+  const char *list = strstr(markdown, "- b");
+  const char *fence = strstr(markdown, "```");
+  const char *url = strstr(markdown, "/first");
+  cmark_parser *parser;
+  cmark_node *doc, *result;
+  char *html;
+
+  test_reparse(runner, markdown, (size_t)(list - markdown) + 2, 1, "bee",
+               options, "edit within a line");
+  test_reparse(runner, markdown, (size_t)(list - markdown), 0,
+               "- new\n\nparagraph\n", options, "lines inserted");
+  test_reparse(runner, markdown, 0, (size_t)(list - markdown), "", options,
+               "lines deleted");
+  test_reparse(runner, markdown, (size_t)(fence - markdown), 0, "> ",
+               options, "block type changed");
+  test_reparse(runner, markdown, (size_t)(fence - markdown), 3, "", options,
+               "fence removed");
+  test_reparse(runner, markdown, (size_t)(url - markdown), 6, "/changed",
+               options, "definition changed");
+  test_reparse(runner, markdown, sizeof(markdown) - 1, 0, "[two]: /second\n",
+               options, "definition added");
+  test_reparse(runner, markdown, (size_t)(url - markdown) - 7, 7, "",
+               options, "definition removed");
+  test_reparse(runner, markdown, (size_t)(list - markdown), 0,
+               "[two]: /early\n\n", options, "definition added before use");
+  test_reparse(runner, markdown, (size_t)(url - markdown), 6, "/changed",
+               CMARK_OPT_DEFAULT, "without kept definitions");
+
+  // A parser with its own options can be used to parse the edit.
+  doc = cmark_parse_document("a\n\nb\n", 5, CMARK_OPT_INCREMENTAL);
+  parser = cmark_parser_new(CMARK_OPT_INCREMENTAL | CMARK_OPT_SMART);
+  result = cmark_parser_reparse(parser, doc, "a\n\n'b'\n", 7, 3, 1, 3);
+  OK(runner, result == doc, "parser reparse returns the root");
+  html = cmark_render_html(doc, CMARK_OPT_DEFAULT);
+  STR_EQ(runner, html, "<p>a</p>\n<p>\xe2\x80\x98" "b\xe2\x80\x99</p>\n",
+         "parser reparse uses the parser's options");
+  free(html);
+  cmark_parser_free(parser);
+
+  OK(runner, cmark_reparse(doc, "a\n", 2, 3, 0, 0, 0) == NULL,
+     "edit past the end");
+  OK(runner, cmark_reparse(doc, "a\n", 2, 0, 0, 3, 0) == NULL,
+     "edit longer than the text");
+  OK(runner, cmark_reparse(cmark_node_first_child(doc), "a\n", 2, 0, 1, 1,
+                           0) == NULL,
+     "not a document");
+  OK(runner, cmark_reparse(doc, "a\n\n'b'\n", 7, 0, 0, 0, 0) == doc,
+     "empty edit");
+  cmark_node_free(doc);
+}
+
 static void utf8(test_batch_runner *runner) {
   // Ranges
   test_char(runner, 1, "\x01", "valid utf8 01");
@@ -972,6 +1702,40 @@ static void ref_source_pos(test_batch_runner *runner) {
   cmark_node_free(doc);
 }
 
+// Control characters that are not whitespace are part of a label.
+static void ref_label_control_chars(test_batch_runner *runner) {
+  static const char controls[] = "\x01\x02\x03\x04\x05\x06\x07\x08\x0b\x0c";
+  char markdown[64];
+  char *html;
+  size_t i;
+  int resolved = 1, collapsed = 0, confused = 0;
+
+  for (i = 0; i < sizeof(controls) - 1; i++) {
+    char c = controls[i];
+
+    sprintf(markdown, "[a%cb]\n\n[A%cB]: /u\n", c, c);
+    html = cmark_markdown_to_html(markdown, strlen(markdown), 0);
+    if (strstr(html, "href=\"/u\"") == NULL)
+      resolved = 0;
+    free(html);
+
+    sprintf(markdown, "[a%cb]\n\n[a b]: /u\n", c);
+    html = cmark_markdown_to_html(markdown, strlen(markdown), 0);
+    if (strstr(html, "href") != NULL)
+      collapsed = 1;
+    free(html);
+
+    sprintf(markdown, "[%c]\n\n[%c]: /u\n", c, c == '\x0c' ? 1 : c + 1);
+    html = cmark_markdown_to_html(markdown, strlen(markdown), 0);
+    if (strstr(html, "href") != NULL)
+      confused = 1;
+    free(html);
+  }
+  OK(runner, resolved, "labels with control characters resolve");
+  OK(runner, !collapsed, "control characters are not whitespace in labels");
+  OK(runner, !confused, "control characters are told apart in labels");
+}
+
 int main() {
   int retval;
   test_batch_runner *runner = test_batch_runner_new();
@@ -986,11 +1750,20 @@ int main() {
   custom_nodes(runner);
   hierarchy(runner);
   parser(runner);
+  parser_pool(runner);
+  parser_stats(runner);
+  parser_limits(runner);
+  parser_profiler(runner);
+  builtin_extensions(runner);
+  inline_extension_without_chars(runner);
   render_html(runner);
   render_xml(runner);
   render_man(runner);
   render_latex(runner);
   render_commonmark(runner);
+  serialization(runner);
+  flat_tree(runner);
+  incremental_reparse(runner);
   utf8(runner);
   line_endings(runner);
   numeric_entities(runner);
@@ -999,6 +1772,7 @@ int main() {
   test_feed_across_line_ending(runner);
   source_pos(runner);
   ref_source_pos(runner);
+  ref_label_control_chars(runner);
 
   test_print_summary(runner);
   retval = test_ok(runner) ? 0 : 1;
@@ -0,0 +1,492 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "cmark.h"
+
+// What is reported for every iteration.  Block parsing, inline parsing
+// and consolidation do not overlap and add up to the whole parse.
+typedef enum {
+  T_BLOCKS,
+  T_INLINES,
+  T_REFERENCES,
+  T_CONSOLIDATE,
+  T_PARSE,
+  T_HTML,
+  T_XML,
+  T_MAN,
+  T_COMMONMARK,
+  T_LATEX,
+  NUM_TIMINGS
+} timing;
+
+static const char *timing_names[NUM_TIMINGS] = {
+    "blocks", "inlines", "references", "consolidate", "parse",
+    "html",   "xml",     "man",        "commonmark",  "latex"};
+
+// Indexed by cmark_alloc_site.
+static const char *site_names[CMARK_ALLOC_LAST + 1] = {
+    "other", "node", "strbuf", "chunk_copy", "cstr", "delimiter", "reference"};
+
+typedef struct {
+  int iterations;
+  int warmup;
+  int repeat;
+  int options;
+  bool json;
+  bool allocs;
+  cmark_llist *extensions;
+} bench_config;
+
+typedef struct {
+  uint64_t median;
+  uint64_t p99;
+} summary;
+
+static void print_usage(void) {
+  printf("Usage:   cmark-bench [OPTIONS] [FILE|DIR]*\n");
+  printf("Parses and renders each sample in-process and reports the time\n");
+  printf("spent in every phase.  Directories are searched for *.md files;\n");
+  printf("the default is %s.\n", BENCH_SAMPLES_DIR);
+  printf("Options:\n");
+  printf("  -n, --iterations N   Timed iterations per sample (default 100)\n");
+  printf("  --warmup N           Untimed iterations per sample (default 3)\n");
+  printf("  -r, --repeat N       Concatenate N copies of each sample\n");
+  printf("                       (default 200)\n");
+  printf("  -e, --extension NAME Attach an extension to the parser\n");
+  printf("  --smart              Use smart punctuation\n");
+  printf("  --allocs             Also count the allocations made while\n");
+  printf("                       parsing, per KB of input, by what made\n");
+  printf("                       them and by node type\n");
+  printf("  --json               Write results as JSON\n");
+  printf("  --help, -h           Print usage information\n");
+}
+
+static int compare_names(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool has_md_suffix(const char *name) {
+  size_t len = strlen(name);
+  return len > 3 && strcmp(name + len - 3, ".md") == 0;
+}
+
+static char *join_path(const char *dir, const char *name) {
+  size_t len = strlen(dir) + strlen(name) + 2;
+  char *path = (char *)malloc(len);
+  snprintf(path, len, "%s/%s", dir, name);
+  return path;
+}
+
+// Append the *.md files in 'dir' to 'paths', sorted by name.  Returns
+// false if 'dir' is not a directory.
+static bool list_samples(const char *dir, char ***paths, int *npaths) {
+  char **names = NULL;
+  int nnames = 0, i;
+
+#ifdef _WIN32
+  WIN32_FIND_DATAA data;
+  char *pattern = join_path(dir, "*.md");
+  HANDLE h = FindFirstFileA(pattern, &data);
+
+  free(pattern);
+  if (h == INVALID_HANDLE_VALUE)
+    return false;
+  do {
+    names = (char **)realloc(names, (nnames + 1) * sizeof(char *));
+    names[nnames++] = join_path(dir, data.cFileName);
+  } while (FindNextFileA(h, &data));
+  FindClose(h);
+#else
+  struct dirent *entry;
+  DIR *d = opendir(dir);
+
+  if (d == NULL)
+    return false;
+  while ((entry = readdir(d)) != NULL) {
+    if (!has_md_suffix(entry->d_name))
+      continue;
+    names = (char **)realloc(names, (nnames + 1) * sizeof(char *));
+    names[nnames++] = join_path(dir, entry->d_name);
+  }
+  closedir(d);
+#endif
+
+  qsort(names, nnames, sizeof(char *), compare_names);
+  *paths = (char **)realloc(*paths, (*npaths + nnames) * sizeof(char *));
+  for (i = 0; i < nnames; i++)
+    (*paths)[(*npaths)++] = names[i];
+  free(names);
+  return true;
+}
+
+static bool is_directory(const char *path) {
+#ifdef _WIN32
+  DWORD attrs = GetFileAttributesA(path);
+  return attrs != INVALID_FILE_ATTRIBUTES &&
+         (attrs & FILE_ATTRIBUTE_DIRECTORY);
+#else
+  struct stat st;
+  return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+// Read 'path' and return 'repeat' copies of its contents.
+static char *read_sample(const char *path, int repeat, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  char *text = NULL, *out;
+  size_t size = 0, cap = 0, n;
+  int i;
+
+  if (f == NULL)
+    return NULL;
+  do {
+    if (size == cap) {
+      cap = cap ? 2 * cap : 4096;
+      text = (char *)realloc(text, cap);
+    }
+    n = fread(text + size, 1, cap - size, f);
+    size += n;
+  } while (n > 0);
+  fclose(f);
+
+  out = (char *)malloc(size * repeat + 1);
+  for (i = 0; i < repeat; i++)
+    memcpy(out + size * i, text, size);
+  out[size * repeat] = '\0';
+  free(text);
+  *len = size * repeat;
+  return out;
+}
+
+// Parse and render 'text' once with profiling turned on, storing the
+// nanoseconds taken by each timing in 'times'.
+static void run_once(cmark_parser *parser, const char *text, size_t len,
+                     int options, uint64_t *times) {
+  cmark_profile profile;
+  cmark_node *doc;
+  uint64_t start;
+  char *out;
+  int t;
+
+  start = cmark_profile_clock();
+  cmark_parser_feed(parser, text, len);
+  doc = cmark_parser_finish(parser);
+  times[T_PARSE] = cmark_profile_clock() - start;
+
+  for (t = T_HTML; t < NUM_TIMINGS; t++) {
+    switch (t) {
+    case T_HTML:
+      out = cmark_render_html(doc, options);
+      break;
+    case T_XML:
+      out = cmark_render_xml(doc, options);
+      break;
+    case T_MAN:
+      out = cmark_render_man(doc, options, 0);
+      break;
+    case T_COMMONMARK:
+      out = cmark_render_commonmark(doc, options, 0);
+      break;
+    default:
+      out = cmark_render_latex(doc, options, 0);
+      break;
+    }
+    free(out);
+  }
+
+  cmark_node_get_profile(doc, &profile);
+  times[T_BLOCKS] = profile.phases[CMARK_PHASE_FEED].total_ns +
+                    profile.phases[CMARK_PHASE_FINALIZE].total_ns -
+                    profile.phases[CMARK_PHASE_INLINES].total_ns;
+  times[T_INLINES] = profile.phases[CMARK_PHASE_INLINES].total_ns;
+  times[T_REFERENCES] = profile.phases[CMARK_PHASE_REFERENCES].total_ns;
+  times[T_CONSOLIDATE] = profile.phases[CMARK_PHASE_CONSOLIDATE].total_ns;
+  times[T_HTML] = profile.phases[CMARK_PHASE_RENDER_HTML].total_ns;
+  times[T_XML] = profile.phases[CMARK_PHASE_RENDER_XML].total_ns;
+  times[T_MAN] = profile.phases[CMARK_PHASE_RENDER_MAN].total_ns;
+  times[T_COMMONMARK] =
+      profile.phases[CMARK_PHASE_RENDER_COMMONMARK].total_ns;
+  times[T_LATEX] = profile.phases[CMARK_PHASE_RENDER_LATEX].total_ns;
+
+  cmark_node_free(doc);
+}
+
+// Parse 'text' once with the instrumented allocator, which is too slow
+// to leave on for the timed runs.
+static void count_allocations(const bench_config *config, const char *text,
+                              size_t len, cmark_parser_stats *stats) {
+  cmark_parser *parser = cmark_parser_new_with_mem(
+      config->options, cmark_get_instrumented_mem_allocator());
+  cmark_llist *tmp;
+
+  for (tmp = config->extensions; tmp; tmp = tmp->next)
+    cmark_parser_attach_syntax_extension(parser,
+                                         (cmark_syntax_extension *)tmp->data);
+  cmark_parser_feed(parser, text, len);
+  cmark_node_free(cmark_parser_finish(parser));
+  cmark_parser_get_stats(parser, stats);
+  cmark_parser_free(parser);
+}
+
+static const char *node_type_name(int type) {
+  static const char *names[CMARK_NODE_LAST_INLINE + 1];
+
+  if (names[type] == NULL) {
+    cmark_node *node = cmark_node_new((cmark_node_type)type);
+    names[type] = node ? cmark_node_get_type_string(node) : "unknown";
+    cmark_node_free(node);
+  }
+  return names[type];
+}
+
+static void print_allocations(const cmark_parser_stats *stats, size_t len) {
+  double kb = len ? (double)len / 1024.0 : 1.0;
+  int s, type;
+
+  printf("  %-12s %12s %12s\n", "allocated by", "allocs/KB", "bytes/KB");
+  for (s = 0; s <= CMARK_ALLOC_LAST; s++)
+    printf("  %-12s %12.2f %12.1f\n", site_names[s],
+           stats->site_allocations[s] / kb, stats->site_bytes[s] / kb);
+  printf("  %-12s %12.2f %12.1f\n", "total", stats->allocations / kb,
+         stats->bytes_allocated / kb);
+  printf("  %-12s %12s\n", "node type", "nodes/KB");
+  for (type = 1; type <= CMARK_NODE_LAST_INLINE; type++) {
+    if (stats->node_allocations[type])
+      printf("  %-12s %12.2f\n", node_type_name(type),
+             stats->node_allocations[type] / kb);
+  }
+}
+
+static void print_allocations_json(const cmark_parser_stats *stats,
+                                   size_t len) {
+  double kb = len ? (double)len / 1024.0 : 1.0;
+  int s, type, n = 0;
+
+  printf(", \"allocations_per_kb\": {");
+  for (s = 0; s <= CMARK_ALLOC_LAST; s++)
+    printf("%s\n      \"%s\": {\"allocs\": %.3f, \"bytes\": %.1f}",
+           s ? "," : "", site_names[s], stats->site_allocations[s] / kb,
+           stats->site_bytes[s] / kb);
+  printf("}, \"nodes_per_kb\": {");
+  for (type = 1; type <= CMARK_NODE_LAST_INLINE; type++) {
+    if (stats->node_allocations[type])
+      printf("%s\n      \"%s\": %.3f", n++ ? "," : "", node_type_name(type),
+             stats->node_allocations[type] / kb);
+  }
+  printf("}");
+}
+
+static int compare_times(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Median and nearest-rank 99th percentile of 'n' samples, which are
+// sorted in place.
+static summary summarize(uint64_t *samples, int n) {
+  summary s;
+  int rank = (99 * n + 99) / 100;
+
+  qsort(samples, n, sizeof(uint64_t), compare_times);
+  s.median = n % 2 ? samples[n / 2]
+                   : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  s.p99 = samples[rank - 1];
+  return s;
+}
+
+static void print_json_string(const char *s) {
+  putchar('"');
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\')
+      putchar('\\');
+    putchar(*s);
+  }
+  putchar('"');
+}
+
+// Benchmark one sample and print its results.  Returns false if the
+// sample cannot be read.
+static bool bench_sample(const bench_config *config, const char *path,
+                         bool first) {
+  cmark_parser *parser;
+  cmark_parser_stats stats;
+  cmark_llist *tmp;
+  uint64_t *times, *column;
+  summary results[NUM_TIMINGS];
+  const char *name;
+  double mb_per_s;
+  size_t len;
+  char *text;
+  int i, t;
+
+  text = read_sample(path, config->repeat, &len);
+  if (text == NULL) {
+    fprintf(stderr, "cmark-bench: cannot read %s\n", path);
+    return false;
+  }
+
+  parser = cmark_parser_new(config->options);
+  cmark_parser_set_profiler(parser, true);
+  for (tmp = config->extensions; tmp; tmp = tmp->next)
+    cmark_parser_attach_syntax_extension(parser,
+                                         (cmark_syntax_extension *)tmp->data);
+
+  times = (uint64_t *)malloc(sizeof(uint64_t) * NUM_TIMINGS *
+                             config->iterations);
+  for (i = 0; i < config->warmup; i++)
+    run_once(parser, text, len, config->options, times);
+  for (i = 0; i < config->iterations; i++)
+    run_once(parser, text, len, config->options, times + i * NUM_TIMINGS);
+
+  // Gather each timing into a column of its own before summarizing.
+  column = (uint64_t *)malloc(sizeof(uint64_t) * config->iterations);
+  for (t = 0; t < NUM_TIMINGS; t++) {
+    for (i = 0; i < config->iterations; i++)
+      column[i] = times[i * NUM_TIMINGS + t];
+    results[t] = summarize(column, config->iterations);
+  }
+  free(column);
+  free(times);
+  cmark_parser_free(parser);
+  if (config->allocs)
+    count_allocations(config, text, len, &stats);
+  free(text);
+
+  name = strrchr(path, '/');
+  name = name ? name + 1 : path;
+  mb_per_s = results[T_PARSE].median
+                 ? (double)len * 1000.0 / (double)results[T_PARSE].median
+                 : 0.0;
+
+  if (config->json) {
+    printf("%s\n    {\"name\": ", first ? "" : ",");
+    print_json_string(name);
+    printf(", \"bytes\": %lu, \"parse_mb_per_s\": %.2f, \"phases\": {",
+           (unsigned long)len, mb_per_s);
+    for (t = 0; t < NUM_TIMINGS; t++)
+      printf("%s\n      \"%s\": {\"median_ns\": %llu, \"p99_ns\": %llu}",
+             t ? "," : "", timing_names[t],
+             (unsigned long long)results[t].median,
+             (unsigned long long)results[t].p99);
+    printf("}");
+    if (config->allocs)
+      print_allocations_json(&stats, len);
+    printf("}");
+  } else {
+    printf("%s  %lu bytes, %.1f MB/s\n", name, (unsigned long)len, mb_per_s);
+    printf("  %-12s %12s %12s\n", "phase", "median (us)", "p99 (us)");
+    for (t = 0; t < NUM_TIMINGS; t++)
+      printf("  %-12s %12.1f %12.1f\n", timing_names[t],
+             results[t].median / 1000.0, results[t].p99 / 1000.0);
+    if (config->allocs)
+      print_allocations(&stats, len);
+  }
+  return true;
+}
+
+static bool parse_count(const char *arg, int *value) {
+  char *end;
+  long n;
+
+  if (arg == NULL)
+    return false;
+  n = strtol(arg, &end, 10);
+  if (*end != '\0' || n < 0 || n > 1000000000)
+    return false;
+  *value = (int)n;
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bench_config config;
+  char **paths = NULL;
+  int npaths = 0, reported = 0;
+  bool ok = true;
+  int i;
+
+  memset(&config, 0, sizeof(config));
+  config.iterations = 100;
+  config.warmup = 3;
+  config.repeat = 200;
+  config.options = CMARK_OPT_DEFAULT;
+
+  cmark_init();
+
+  for (i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+
+    if (strcmp(arg, "-n") == 0 || strcmp(arg, "--iterations") == 0) {
+      if (!parse_count(argv[++i], &config.iterations) ||
+          config.iterations == 0) {
+        fprintf(stderr, "cmark-bench: bad iteration count\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--warmup") == 0) {
+      if (!parse_count(argv[++i], &config.warmup)) {
+        fprintf(stderr, "cmark-bench: bad warmup count\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--repeat") == 0) {
+      if (!parse_count(argv[++i], &config.repeat) || config.repeat == 0) {
+        fprintf(stderr, "cmark-bench: bad repeat count\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "-e") == 0 || strcmp(arg, "--extension") == 0) {
+      cmark_syntax_extension *ext =
+          argv[i + 1] ? cmark_find_syntax_extension(argv[++i]) : NULL;
+      if (ext == NULL) {
+        fprintf(stderr, "cmark-bench: unknown extension %s\n",
+                argv[i] ? argv[i] : "");
+        return 1;
+      }
+      config.extensions = cmark_llist_append(config.extensions, ext);
+    } else if (strcmp(arg, "--smart") == 0) {
+      config.options |= CMARK_OPT_SMART;
+    } else if (strcmp(arg, "--allocs") == 0) {
+      config.allocs = true;
+    } else if (strcmp(arg, "--json") == 0) {
+      config.json = true;
+    } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      print_usage();
+      return 0;
+    } else if (is_directory(arg)) {
+      list_samples(arg, &paths, &npaths);
+    } else {
+      paths = (char **)realloc(paths, (npaths + 1) * sizeof(char *));
+      paths[npaths] = (char *)malloc(strlen(arg) + 1);
+      strcpy(paths[npaths++], arg);
+    }
+  }
+
+  if (npaths == 0 && !list_samples(BENCH_SAMPLES_DIR, &paths, &npaths)) {
+    fprintf(stderr, "cmark-bench: cannot open %s\n", BENCH_SAMPLES_DIR);
+    return 1;
+  }
+
+  if (config.json)
+    printf("{\"iterations\": %d, \"repeat\": %d, \"samples\": [",
+           config.iterations, config.repeat);
+  for (i = 0; i < npaths; i++) {
+    if (bench_sample(&config, paths[i], reported == 0))
+      reported++;
+    else
+      ok = false;
+    free(paths[i]);
+  }
+  if (config.json)
+    printf("\n  ]}\n");
+
+  free(paths);
+  cmark_llist_free(config.extensions);
+  cmark_deinit();
+  return ok ? 0 : 1;
+}
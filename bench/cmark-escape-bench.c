@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "cmark.h"
+#include "houdini.h"
+
+// Times the escaping routines on their own, outside of parsing and
+// rendering.  They are internal to the library, so this links the
+// static one.
+
+typedef enum {
+  MODE_HTML,
+  MODE_HTML_SECURE,
+  MODE_HREF,
+} escape_mode;
+
+static const char *mode_names[] = {"html", "html-secure", "href"};
+
+typedef struct {
+  int iterations;
+  int repeat;
+  escape_mode mode;
+} bench_config;
+
+// What is escaped on every iteration: 'count' spans of 'text', one per
+// call.
+typedef struct {
+  char *text;
+  size_t *starts;
+  size_t *lens;
+  int count;
+} escape_input;
+
+static void print_usage(void) {
+  printf("Usage:   cmark-escape-bench [OPTIONS] FILE*\n");
+  printf("Escapes the contents of each file in-process and reports the\n");
+  printf("median throughput.  In href mode the link and image URLs of\n");
+  printf("each file are escaped one by one instead.  The default is\n");
+  printf("%s/block-code.md.\n", BENCH_SAMPLES_DIR);
+  printf("Options:\n");
+  printf("  -m, --mode MODE      html (default), html-secure or href\n");
+  printf("  -n, --iterations N   Timed iterations per file (default 100)\n");
+  printf("  -r, --repeat N       Concatenate N copies of each file\n");
+  printf("                       (default 200)\n");
+  printf("  --help, -h           Print usage information\n");
+}
+
+// Read 'path' and return 'repeat' copies of its contents.
+static char *read_sample(const char *path, int repeat, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  char *text = NULL, *out;
+  size_t size = 0, cap = 0, n;
+  int i;
+
+  if (f == NULL)
+    return NULL;
+  do {
+    if (size == cap) {
+      cap = cap ? 2 * cap : 4096;
+      text = (char *)realloc(text, cap);
+    }
+    n = fread(text + size, 1, cap - size, f);
+    size += n;
+  } while (n > 0);
+  fclose(f);
+
+  out = (char *)malloc(size * repeat + 1);
+  for (i = 0; i < repeat; i++)
+    memcpy(out + size * i, text, size);
+  out[size * repeat] = '\0';
+  free(text);
+  *len = size * repeat;
+  return out;
+}
+
+// Parse 'text' and return the URLs of its links and images, 'repeat'
+// times over, as spans of one buffer.  Returns the total length of the
+// URLs in 'len'.
+static void collect_urls(const char *text, size_t size, int repeat,
+                         escape_input *input, size_t *len) {
+  cmark_node *doc = cmark_parse_document(text, size, CMARK_OPT_DEFAULT);
+  cmark_iter *iter = cmark_iter_new(doc);
+  cmark_event_type ev;
+  size_t total = 0, cap = 0, n;
+  int count = 0, i, j;
+
+  input->text = NULL;
+  input->starts = NULL;
+  input->lens = NULL;
+  while ((ev = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
+    cmark_node *node = cmark_iter_get_node(iter);
+    const char *url;
+
+    if (ev != CMARK_EVENT_ENTER ||
+        (cmark_node_get_type(node) != CMARK_NODE_LINK &&
+         cmark_node_get_type(node) != CMARK_NODE_IMAGE))
+      continue;
+    url = cmark_node_get_url(node);
+    n = strlen(url);
+    if (input->text == NULL || total + n > cap) {
+      cap = 2 * (total + n) + 1;
+      input->text = (char *)realloc(input->text, cap);
+    }
+    memcpy(input->text + total, url, n);
+    input->lens = (size_t *)realloc(input->lens, (count + 1) * sizeof(size_t));
+    input->lens[count++] = n;
+    total += n;
+  }
+  cmark_iter_free(iter);
+  cmark_node_free(doc);
+
+  // The copies share the text and repeat the spans.
+  input->count = count * repeat;
+  input->lens =
+      (size_t *)realloc(input->lens, (input->count + 1) * sizeof(size_t));
+  input->starts = (size_t *)malloc((input->count + 1) * sizeof(size_t));
+  for (i = 0, n = 0; i < count; n += input->lens[i++])
+    input->starts[i] = n;
+  for (j = 1; j < repeat; j++) {
+    for (i = 0; i < count; i++) {
+      input->starts[j * count + i] = input->starts[i];
+      input->lens[j * count + i] = input->lens[i];
+    }
+  }
+  *len = total * repeat;
+}
+
+// Read 'path' and set up 'input' for the configured mode.  Returns the
+// number of bytes escaped per iteration in 'len'.
+static bool load_input(const bench_config *config, const char *path,
+                       escape_input *input, size_t *len) {
+  char *text;
+  size_t size;
+
+  if (config->mode != MODE_HREF) {
+    input->text = read_sample(path, config->repeat, len);
+    if (input->text == NULL)
+      return false;
+    input->starts = (size_t *)calloc(1, sizeof(size_t));
+    input->lens = (size_t *)malloc(sizeof(size_t));
+    input->lens[0] = *len;
+    input->count = 1;
+    return true;
+  }
+
+  text = read_sample(path, 1, &size);
+  if (text == NULL)
+    return false;
+  collect_urls(text, size, config->repeat, input, len);
+  free(text);
+  return true;
+}
+
+// Escape 'input' once into 'buf', which keeps its capacity between
+// iterations so that only the escaping itself is timed.
+static uint64_t run_once(const bench_config *config, cmark_strbuf *buf,
+                         const escape_input *input) {
+  const uint8_t *text = (const uint8_t *)input->text;
+  uint64_t start;
+  int i;
+
+  cmark_strbuf_clear(buf);
+  start = cmark_profile_clock();
+  for (i = 0; i < input->count; i++) {
+    if (config->mode == MODE_HREF)
+      houdini_escape_href(buf, text + input->starts[i],
+                          (bufsize_t)input->lens[i]);
+    else
+      houdini_escape_html0(buf, text + input->starts[i],
+                           (bufsize_t)input->lens[i],
+                           config->mode == MODE_HTML_SECURE);
+  }
+  return cmark_profile_clock() - start;
+}
+
+static int compare_times(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Benchmark one file and print its results.  Returns false if the file
+// cannot be read.
+static bool bench_sample(const bench_config *config, const char *path) {
+  escape_input input;
+  cmark_strbuf *buf;
+  uint64_t *times, median;
+  const char *name;
+  size_t len;
+  int i;
+
+  if (!load_input(config, path, &input, &len)) {
+    fprintf(stderr, "cmark-escape-bench: cannot read %s\n", path);
+    return false;
+  }
+
+  buf = cmark_strbuf_new(0);
+  times = (uint64_t *)malloc(sizeof(uint64_t) * config->iterations);
+  run_once(config, buf, &input);
+  for (i = 0; i < config->iterations; i++)
+    times[i] = run_once(config, buf, &input);
+  qsort(times, config->iterations, sizeof(uint64_t), compare_times);
+  median = times[config->iterations / 2];
+
+  name = strrchr(path, '/');
+  name = name ? name + 1 : path;
+  printf("%-26s %-12s %10lu bytes %8.2f GB/s\n", name,
+         mode_names[config->mode], (unsigned long)len,
+         median ? (double)len / (double)median : 0.0);
+
+  free(times);
+  cmark_strbuf_free(buf);
+  free(input.text);
+  free(input.starts);
+  free(input.lens);
+  return true;
+}
+
+static bool parse_count(const char *arg, int *value) {
+  char *end;
+  long n;
+
+  if (arg == NULL)
+    return false;
+  n = strtol(arg, &end, 10);
+  if (*end != '\0' || n <= 0 || n > 1000000000)
+    return false;
+  *value = (int)n;
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bench_config config;
+  const char **paths;
+  int npaths = 0;
+  bool ok = true;
+  size_t m;
+  int i;
+
+  config.iterations = 100;
+  config.repeat = 200;
+  config.mode = MODE_HTML;
+  paths = (const char **)malloc(sizeof(char *) * argc);
+
+  for (i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+
+    if (strcmp(arg, "-n") == 0 || strcmp(arg, "--iterations") == 0) {
+      if (!parse_count(argv[++i], &config.iterations)) {
+        fprintf(stderr, "cmark-escape-bench: bad iteration count\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--repeat") == 0) {
+      if (!parse_count(argv[++i], &config.repeat)) {
+        fprintf(stderr, "cmark-escape-bench: bad repeat count\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "-m") == 0 || strcmp(arg, "--mode") == 0) {
+      const char *name = argv[++i];
+      for (m = 0; m < sizeof(mode_names) / sizeof(mode_names[0]); m++) {
+        if (name && strcmp(name, mode_names[m]) == 0)
+          break;
+      }
+      if (m == sizeof(mode_names) / sizeof(mode_names[0])) {
+        fprintf(stderr, "cmark-escape-bench: unknown mode %s\n",
+                name ? name : "");
+        return 1;
+      }
+      config.mode = (escape_mode)m;
+    } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      print_usage();
+      free(paths);
+      return 0;
+    } else {
+      paths[npaths++] = arg;
+    }
+  }
+
+  if (npaths == 0)
+    paths[npaths++] = BENCH_SAMPLES_DIR "/block-code.md";
+  for (i = 0; i < npaths; i++)
+    ok = bench_sample(&config, paths[i]) && ok;
+  free(paths);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,485 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+// Writes a synthetic document of a given size for benchmarking.  It is
+// made of chapters mixing the constructs that real documents use:
+// wrapped prose with inline markup, nested lists, pipe tables (for the
+// piped-tables extension), fenced and indented code, deeply nested
+// block quotes and a footer of reference definitions for the reference
+// links in the chapter.  The output depends only on the size, the seed
+// and the number of reference labels, so the same arguments always give
+// the same bytes on every platform.
+
+typedef struct {
+  char *ptr;
+  size_t size;
+  size_t asize;
+} buffer;
+
+typedef struct {
+  uint64_t state;
+  int references;
+  unsigned char *used;  // labels already used in this chapter
+  int *used_list;
+  int nused;
+  int chapter;
+} generator;
+
+static const char *words[] = {
+    "the",      "of",       "and",       "a",         "to",      "in",
+    "is",       "that",     "for",       "it",        "as",      "with",
+    "was",      "on",       "be",        "by",        "this",    "are",
+    "from",     "or",       "an",        "which",     "one",     "all",
+    "parser",   "block",    "inline",    "document",  "node",    "tree",
+    "render",   "output",   "input",     "buffer",    "line",    "list",
+    "quote",    "table",    "code",      "heading",   "link",    "image",
+    "emphasis", "strong",   "paragraph", "reference", "label",   "title",
+    "version",  "commit",   "branch",    "merge",     "remote",  "history",
+    "file",     "change",   "repository", "object",   "index",   "working",
+    "quickly",  "carefully", "usually",  "never",     "simple",  "large",
+    "small",    "first",    "last",      "other",     "several", "common"};
+
+#define NUM_WORDS (sizeof(words) / sizeof(words[0]))
+
+static const char *languages[] = {"c", "python", "sh", "ruby", "js", ""};
+
+#define NUM_LANGUAGES (sizeof(languages) / sizeof(languages[0]))
+
+// Paragraphs are wrapped at this column.
+#define WRAP_COLUMN 72
+
+static void print_usage(void) {
+  printf("Usage:   cmark-gencorpus [OPTIONS]\n");
+  printf("Writes a synthetic CommonMark document of exactly SIZE bytes,\n");
+  printf("the same for the same options.  Tables need the piped-tables\n");
+  printf("extension.\n");
+  printf("Options:\n");
+  printf("  -s, --size SIZE      Bytes to write, with an optional suffix\n");
+  printf("                       K, M or G (default 1M)\n");
+  printf("  --seed N             Seed for the document (default 1)\n");
+  printf("  --references N       Distinct reference labels (default 256)\n");
+  printf("  -o, --output FILE    Write to FILE instead of stdout\n");
+  printf("  --help, -h           Print usage information\n");
+}
+
+static void buffer_grow(buffer *buf, size_t len) {
+  if (buf->size + len + 1 > buf->asize) {
+    buf->asize = (buf->size + len + 1) * 2;
+    buf->ptr = (char *)realloc(buf->ptr, buf->asize);
+    if (buf->ptr == NULL) {
+      fprintf(stderr, "cmark-gencorpus: out of memory\n");
+      exit(1);
+    }
+  }
+}
+
+static void put(buffer *buf, const char *s) {
+  size_t len = strlen(s);
+  buffer_grow(buf, len);
+  memcpy(buf->ptr + buf->size, s, len + 1);
+  buf->size += len;
+}
+
+static void putc_n(buffer *buf, char c, int n) {
+  buffer_grow(buf, (size_t)n);
+  memset(buf->ptr + buf->size, c, (size_t)n);
+  buf->size += (size_t)n;
+  buf->ptr[buf->size] = '\0';
+}
+
+static void putf(buffer *buf, const char *fmt, ...) {
+  char tmp[256];
+  va_list ap;
+
+  va_start(ap, fmt);
+  vsnprintf(tmp, sizeof(tmp), fmt, ap);
+  va_end(ap);
+  put(buf, tmp);
+}
+
+// xorshift64*, seeded through splitmix64 so that small seeds give
+// unrelated streams.
+static void seed_generator(generator *gen, uint64_t seed) {
+  uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  gen->state = (z ^ (z >> 31)) | 1;
+}
+
+static uint64_t next_random(generator *gen) {
+  gen->state ^= gen->state >> 12;
+  gen->state ^= gen->state << 25;
+  gen->state ^= gen->state >> 27;
+  return gen->state * 0x2545F4914F6CDD1Dull;
+}
+
+// A number in [lo, hi].
+static int between(generator *gen, int lo, int hi) {
+  return lo + (int)(next_random(gen) % (uint64_t)(hi - lo + 1));
+}
+
+static int percent(generator *gen, int p) { return between(gen, 1, 100) <= p; }
+
+static const char *word(generator *gen) {
+  return words[next_random(gen) % NUM_WORDS];
+}
+
+static int use_reference(generator *gen) {
+  int label = between(gen, 0, gen->references - 1);
+  if (!gen->used[label]) {
+    gen->used[label] = 1;
+    gen->used_list[gen->nused++] = label;
+  }
+  return label;
+}
+
+// One word or inline construct, with its trailing punctuation.
+static void inline_item(generator *gen, buffer *out) {
+  int r = between(gen, 1, 100);
+
+  if (r <= 80) {
+    put(out, word(gen));
+  } else if (r <= 84) {
+    putf(out, "*%s %s*", word(gen), word(gen));
+  } else if (r <= 87) {
+    putf(out, "**%s**", word(gen));
+  } else if (r <= 91) {
+    putf(out, "`%s_%s()`", word(gen), word(gen));
+  } else if (r <= 95) {
+    putf(out, "[%s %s][ref-%d]", word(gen), word(gen), use_reference(gen));
+  } else if (r <= 97) {
+    putf(out, "[%s](https://example.com/%s/%d \"%s\")", word(gen), word(gen),
+         between(gen, 1, 9999), word(gen));
+  } else if (r <= 98) {
+    putf(out, "<https://example.org/%s>", word(gen));
+  } else if (r <= 99) {
+    putf(out, "%s &amp; %s", word(gen), word(gen));
+  } else {
+    putf(out, "%s\\_%s", word(gen), word(gen));
+  }
+}
+
+// A paragraph of 'sentences' sentences, wrapped, with 'first' before
+// the first line and 'prefix' before the others.
+static void paragraph(generator *gen, buffer *out, const char *first,
+                      const char *prefix, int sentences) {
+  buffer item = {NULL, 0, 0};
+  size_t column = 0;
+  int s, w, nwords;
+
+  put(out, first);
+  for (s = 0; s < sentences; s++) {
+    nwords = between(gen, 5, 18);
+    for (w = 0; w < nwords; w++) {
+      item.size = 0;
+      inline_item(gen, &item);
+      if (w == 0 && item.ptr[0] >= 'a' && item.ptr[0] <= 'z')
+        item.ptr[0] = (char)(item.ptr[0] - 'a' + 'A');
+      if (w == nwords - 1)
+        put(&item, percent(gen, 10) ? "?" : ".");
+      else if (percent(gen, 8))
+        put(&item, ",");
+
+      if (column > 0 && column + 1 + item.size > WRAP_COLUMN) {
+        put(out, "\n");
+        put(out, prefix);
+        column = 0;
+      } else if (column > 0) {
+        put(out, " ");
+        column++;
+      }
+      put(out, item.ptr);
+      column += item.size;
+    }
+  }
+  put(out, "\n");
+  free(item.ptr);
+}
+
+// An empty line that stays inside the containers of 'prefix'.
+static void blank_line(buffer *out, const char *prefix) {
+  size_t len = strlen(prefix);
+
+  while (len > 0 && prefix[len - 1] == ' ')
+    len--;
+  buffer_grow(out, len + 1);
+  memcpy(out->ptr + out->size, prefix, len);
+  out->size += len;
+  put(out, "\n");
+}
+
+static void list(generator *gen, buffer *out, const char *prefix, int depth) {
+  char nested[128];
+  int ordered = percent(gen, 35);
+  int loose = percent(gen, 20);
+  int items = between(gen, 2, 7);
+  int i;
+
+  for (i = 0; i < items; i++) {
+    int marker_width = ordered ? (i + 1 >= 10 ? 4 : 3) : 2;
+
+    put(out, prefix);
+    if (ordered)
+      putf(out, "%d. ", i + 1);
+    else
+      put(out, "- ");
+    snprintf(nested, sizeof(nested), "%s%*s", prefix, marker_width, "");
+    paragraph(gen, out, "", nested, 1);
+    if (loose && percent(gen, 40)) {
+      blank_line(out, nested);
+      paragraph(gen, out, nested, nested, between(gen, 1, 2));
+    }
+    if (depth < 3 && strlen(nested) < 64 && percent(gen, 20))
+      list(gen, out, nested, depth + 1);
+    if (loose && i < items - 1)
+      blank_line(out, prefix);
+  }
+}
+
+static void table(generator *gen, buffer *out) {
+  int columns = between(gen, 2, 6);
+  int rows = between(gen, 2, 12);
+  int r, c;
+
+  for (c = 0; c < columns; c++)
+    putf(out, "| %s ", word(gen));
+  put(out, "|\n");
+  for (c = 0; c < columns; c++)
+    put(out, percent(gen, 50) ? "|---" : "| --- ");
+  put(out, "|\n");
+  for (r = 0; r < rows; r++) {
+    for (c = 0; c < columns; c++) {
+      put(out, "| ");
+      if (percent(gen, 20))
+        putf(out, "`%d`", between(gen, 0, 99999));
+      else
+        inline_item(gen, out);
+      put(out, " ");
+    }
+    put(out, "|\n");
+  }
+}
+
+static void code_lines(generator *gen, buffer *out, const char *indent,
+                       int lines) {
+  int i, depth = 0;
+
+  for (i = 0; i < lines; i++) {
+    put(out, indent);
+    putc_n(out, ' ', 2 * depth);
+    switch (between(gen, 0, 4)) {
+    case 0:
+      putf(out, "%s_%s = %s(%d);\n", word(gen), word(gen), word(gen),
+           between(gen, 0, 999));
+      break;
+    case 1:
+      putf(out, "if (%s < %s) {\n", word(gen), word(gen));
+      if (depth < 6)
+        depth++;
+      break;
+    case 2:
+      putf(out, "return %s->%s[%d];\n", word(gen), word(gen),
+           between(gen, 0, 63));
+      if (depth > 0)
+        depth--;
+      break;
+    case 3:
+      putf(out, "// %s %s <%s> & %s\n", word(gen), word(gen), word(gen),
+           word(gen));
+      break;
+    default:
+      put(out, "\n");
+      break;
+    }
+  }
+}
+
+static void fenced_code(generator *gen, buffer *out) {
+  const char *fence = percent(gen, 80) ? "```" : "~~~~";
+
+  putf(out, "%s%s\n", fence, languages[next_random(gen) % NUM_LANGUAGES]);
+  code_lines(gen, out, "", between(gen, 3, 25));
+  putf(out, "%s\n", fence);
+}
+
+// Block quotes nested up to 'depth' levels, going in and back out with
+// a paragraph or a list at every level.
+static void deep_quote(generator *gen, buffer *out, int depth) {
+  char prefix[128];
+  int d, len;
+
+  for (d = 1; d <= 2 * depth - 1; d++) {
+    int level = d <= depth ? d : 2 * depth - d;
+
+    len = 0;
+    while (len / 2 < level) {
+      prefix[len++] = '>';
+      prefix[len++] = ' ';
+    }
+    prefix[len] = '\0';
+    if (percent(gen, 25))
+      list(gen, out, prefix, 2);
+    else
+      paragraph(gen, out, prefix, prefix, between(gen, 1, 3));
+    // A line holding only the markers ends the paragraph or list
+    // without leaving the quote.
+    blank_line(out, prefix);
+  }
+}
+
+static void chapter(generator *gen, buffer *out) {
+  int blocks = between(gen, 15, 40);
+  int i;
+
+  gen->chapter++;
+  if (percent(gen, 80)) {
+    putf(out, "# Chapter %d: %s %s\n\n", gen->chapter, word(gen), word(gen));
+  } else {
+    size_t start = out->size;
+    putf(out, "Chapter %d: %s %s", gen->chapter, word(gen), word(gen));
+    put(out, "\n");
+    putc_n(out, '=', (int)(out->size - start - 1));
+    put(out, "\n\n");
+  }
+
+  for (i = 0; i < blocks; i++) {
+    int r = between(gen, 1, 100);
+
+    if (r <= 40) {
+      paragraph(gen, out, "", "", between(gen, 1, 6));
+    } else if (r <= 55) {
+      list(gen, out, "", 1);
+    } else if (r <= 63) {
+      table(gen, out);
+    } else if (r <= 73) {
+      fenced_code(gen, out);
+    } else if (r <= 76) {
+      code_lines(gen, out, "    ", between(gen, 2, 10));
+    } else if (r <= 84) {
+      deep_quote(gen, out, between(gen, 2, 12));
+    } else if (r <= 94) {
+      putf(out, "%s %s %s\n", percent(gen, 70) ? "##" : "###", word(gen),
+           word(gen));
+    } else if (r <= 97) {
+      put(out, "<div class=\"note\">\n");
+      paragraph(gen, out, "", "", 1);
+      put(out, "</div>\n");
+    } else {
+      put(out, percent(gen, 50) ? "* * *\n" : "---\n");
+    }
+    put(out, "\n");
+  }
+
+  // The footer defines every label used in the chapter.  Labels are
+  // shared between chapters, so later definitions are duplicates.
+  for (i = 0; i < gen->nused; i++) {
+    int label = gen->used_list[i];
+    putf(out, "[ref-%d]: https://example.com/ref/%d \"%s %s\"\n", label,
+         label, word(gen), word(gen));
+    gen->used[label] = 0;
+  }
+  gen->nused = 0;
+  put(out, "\n");
+}
+
+static int parse_size(const char *arg, unsigned long long *value) {
+  char *end;
+  unsigned long long n;
+
+  if (arg == NULL)
+    return 0;
+  n = strtoull(arg, &end, 10);
+  if (end == arg)
+    return 0;
+  if (*end == 'K' || *end == 'k')
+    n <<= 10, end++;
+  else if (*end == 'M' || *end == 'm')
+    n <<= 20, end++;
+  else if (*end == 'G' || *end == 'g')
+    n <<= 30, end++;
+  if (*end != '\0')
+    return 0;
+  *value = n;
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long long size = 1 << 20, seed = 1, references = 256, written = 0;
+  const char *output = NULL;
+  FILE *out = stdout;
+  buffer buf = {NULL, 0, 0};
+  generator gen;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+
+    if (strcmp(arg, "-s") == 0 || strcmp(arg, "--size") == 0) {
+      if (!parse_size(argv[++i], &size)) {
+        fprintf(stderr, "cmark-gencorpus: bad size\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--seed") == 0) {
+      if (!parse_size(argv[++i], &seed)) {
+        fprintf(stderr, "cmark-gencorpus: bad seed\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--references") == 0) {
+      if (!parse_size(argv[++i], &references) || references == 0 ||
+          references > 1000000) {
+        fprintf(stderr, "cmark-gencorpus: bad reference count\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+      output = argv[++i];
+      if (output == NULL) {
+        fprintf(stderr, "cmark-gencorpus: missing output file\n");
+        return 1;
+      }
+    } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+      print_usage();
+      return 0;
+    } else {
+      fprintf(stderr, "cmark-gencorpus: unknown option %s\n", arg);
+      return 1;
+    }
+  }
+
+  if (output != NULL && (out = fopen(output, "wb")) == NULL) {
+    fprintf(stderr, "cmark-gencorpus: cannot write %s\n", output);
+    return 1;
+  }
+
+  memset(&gen, 0, sizeof(gen));
+  seed_generator(&gen, seed);
+  gen.references = (int)references;
+  gen.used = (unsigned char *)calloc((size_t)references, 1);
+  gen.used_list = (int *)calloc((size_t)references, sizeof(int));
+
+  while (written < size) {
+    buf.size = 0;
+    chapter(&gen, &buf);
+    if (buf.size > size - written) {
+      // Cut the last chapter short, still ending with a newline.
+      buf.size = (size_t)(size - written);
+      buf.ptr[buf.size - 1] = '\n';
+    }
+    if (fwrite(buf.ptr, 1, buf.size, out) != buf.size) {
+      fprintf(stderr, "cmark-gencorpus: write error\n");
+      return 1;
+    }
+    written += buf.size;
+  }
+
+  if (out != stdout && fclose(out) != 0) {
+    fprintf(stderr, "cmark-gencorpus: write error\n");
+    return 1;
+  }
+  free(buf.ptr);
+  free(gen.used);
+  free(gen.used_list);
+  return 0;
+}
@@ -194,6 +194,8 @@ static bool table_matches(cmark_syntax_extension *self,
                           cmark_node   * parent_container) {
   bool res = false;
 
+  (void)self;
+
   if (cmark_node_get_type(parent_container) == CMARK_NODE_TABLE) {
     table_row *new_row = row_from_string(input + cmark_parser_get_first_nonspace(parser));
     if (new_row) {
@@ -211,6 +213,10 @@ cmark_syntax_extension *cmark_table_extension_new(void) {
 
   ext->last_block_matches = table_matches;
   ext->try_opening_block = try_opening_table_block;
+  // The delimiter row that starts a table begins with a pipe; rows of an
+  // existing table reach us because we own the table container.
+  ext->block_start_chars = cmark_llist_append(ext->block_start_chars,
+      (void *) '|');
 
   return ext;
 }
@@ -225,6 +231,10 @@ static cmark_node *strikethrough_match(cmark_syntax_extension *self,
   bool left_flanking, right_flanking, punct_before, punct_after;
   int num_delims;
 
+  (void)self;
+  (void)parser;
+  (void)parent;
+
   /* Exit early */
   if (character != '~')
     return NULL;
@@ -258,6 +268,9 @@ static delimiter *strikethrough_insert(cmark_syntax_extension *self,
   delimiter *delim, *tmp_delim;
   delimiter *res = closer->next;
 
+  (void)self;
+  (void)parser;
+
   strikethrough = opener->inl_text;
   cmark_node_set_type(strikethrough, CMARK_NODE_STRIKETHROUGH);
   cmark_node_set_string_content(strikethrough, "~");
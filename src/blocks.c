@@ -18,7 +18,16 @@
 #include "scanners.h"
 #include "inlines.h"
 #include "houdini.h"
+#include "stats.h"
 #include "buffer.h"
+#include "cmark_clock.h"
+#include "probes.h"
+
+#ifdef HAVE_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
 
 #define CODE_INDENT 4
 #define TAB_STOP 4
@@ -62,6 +71,7 @@ static cmark_node *make_block(cmark_mem *mem, cmark_node_type tag,
                               int start_line, int start_column) {
   cmark_node *e;
 
+  CMARK_ALLOC_NODE_SITE(mem, tag);
   e = (cmark_node *)mem->calloc(1, sizeof(*e));
   cmark_strbuf_init(mem, &e->content, 32);
   e->type = (uint16_t)tag;
@@ -79,56 +89,149 @@ static cmark_node *make_document(cmark_mem *mem) {
   return e;
 }
 
+static cmark_llist **S_dispatch_new(cmark_mem *mem) {
+  return (cmark_llist **)mem->calloc(256, sizeof(cmark_llist *));
+}
+
+static void S_dispatch_free(cmark_mem *mem, cmark_llist **table) {
+  int c;
+
+  if (table == NULL)
+    return;
+  for (c = 0; c < 256; c++)
+    cmark_llist_free(table[c]);
+  mem->free(table);
+}
+
+// Add 'extension' to the dispatch lists of the characters in 'chars',
+// or to every list if it did not declare any.
+static void S_dispatch_add(cmark_llist **table, cmark_llist *chars,
+                           cmark_syntax_extension *extension) {
+  cmark_llist *tmp, *entry;
+  int c;
+
+  if (chars == NULL) {
+    for (c = 0; c < 256; c++)
+      table[c] = cmark_llist_append(table[c], extension);
+    return;
+  }
+
+  for (tmp = chars; tmp; tmp = tmp->next) {
+    c = (unsigned char)(unsigned long)tmp->data;
+    for (entry = table[c]; entry && entry->data != extension;
+         entry = entry->next)
+      ;
+    if (entry == NULL)
+      table[c] = cmark_llist_append(table[c], extension);
+  }
+}
+
 bool cmark_parser_attach_syntax_extension(cmark_parser *parser,
                                       cmark_syntax_extension *extension) {
-  parser->syntax_extensions = cmark_llist_append(parser->syntax_extensions, extension);
+  parser->syntax_extensions = cmark_llist_append(
+      parser->syntax_extensions, cmark_syntax_extension_ref(extension));
+  if (extension->try_opening_block) {
+    if (parser->block_dispatch == NULL)
+      parser->block_dispatch = S_dispatch_new(parser->mem);
+    S_dispatch_add(parser->block_dispatch, extension->block_start_chars,
+                   extension);
+  }
   if (extension->match_inline && extension->insert_inline_from_delim) {
     parser->inline_syntax_extensions = cmark_llist_append(
         parser->inline_syntax_extensions, extension);
+    if (parser->inline_dispatch == NULL)
+      parser->inline_dispatch = S_dispatch_new(parser->mem);
+    S_dispatch_add(parser->inline_dispatch, extension->special_inline_chars,
+                   extension);
+    cmark_inlines_init_special_chars(parser);
   }
 
   return true;
 }
 
-static void cmark_parser_dispose(cmark_parser *parser) {
-  if (parser->root)
-    cmark_node_free(parser->root);
-
-  if (parser->refmap)
-    cmark_reference_map_free(parser->refmap);
-}
-
-static void cmark_parser_reset(cmark_parser *parser) {
+// Discard the document being parsed and start a new one.  The line
+// buffers and the reference map are emptied rather than freed, so a
+// parser that is reused keeps the capacity it grew on earlier documents.
+void cmark_parser_reset(cmark_parser *parser) {
+  cmark_stats_collector *saved_stats = parser->stats;
+  cmark_stats_collector *outer_stats = NULL;
+  cmark_parser_limits saved_limits = parser->limits;
+  bool saved_has_limits = parser->has_limits;
+  cmark_parser_error saved_finished_error = parser->finished_error;
+  bool saved_profiling = parser->profiling;
   cmark_llist *saved_exts = parser->syntax_extensions;
   cmark_llist *saved_inline_exts = parser->inline_syntax_extensions;
+  cmark_llist **saved_block_dispatch = parser->block_dispatch;
+  cmark_llist **saved_inline_dispatch = parser->inline_dispatch;
+  cmark_reference_map *saved_refmap = parser->refmap;
+  cmark_strbuf saved_curline = parser->curline;
+  cmark_strbuf saved_linebuf = parser->linebuf;
+  cmark_node *saved_root = parser->root;
   int saved_options = parser->options;
   cmark_mem *saved_mem = parser->mem;
 
-  cmark_parser_dispose(parser);
+  if (saved_stats) {
+    outer_stats = cmark_stats_enter(saved_stats);
+    cmark_stats_begin_document(saved_stats);
+  }
+
+  // No line has been processed since the last reset, so the document
+  // node is still empty and can be kept.
+  if (saved_root && (parser->line_number > 0 || saved_root->first_child)) {
+    cmark_node_free(saved_root);
+    saved_root = NULL;
+  }
 
   memset(parser, 0, sizeof(cmark_parser));
   parser->mem = saved_mem;
 
-  cmark_strbuf_init(parser->mem, &parser->curline, 256);
-  cmark_strbuf_init(parser->mem, &parser->linebuf, 0);
+  parser->curline = saved_curline;
+  parser->linebuf = saved_linebuf;
+  cmark_strbuf_clear(&parser->curline);
+  cmark_strbuf_clear(&parser->linebuf);
 
-  cmark_node *document = make_document(parser->mem);
+  if (saved_root == NULL) {
+    saved_root = make_document(parser->mem);
+  } else if (saved_root->as.document.profile) {
+    parser->mem->free(saved_root->as.document.profile);
+    saved_root->as.document.profile = NULL;
+  }
 
-  parser->refmap = cmark_reference_map_new(parser->mem);
-  parser->root = document;
-  parser->current = document;
+  parser->refmap = saved_refmap;
+  cmark_reference_map_clear(parser->refmap);
+  parser->refmap->keep_definitions =
+      (saved_options & CMARK_OPT_INCREMENTAL) != 0;
+  parser->root = saved_root;
+  parser->current = saved_root;
 
   parser->last_buffer_ended_with_cr = false;
 
   parser->syntax_extensions = saved_exts;
   parser->inline_syntax_extensions = saved_inline_exts;
+  parser->block_dispatch = saved_block_dispatch;
+  parser->inline_dispatch = saved_inline_dispatch;
   parser->options = saved_options;
+  parser->stats = saved_stats;
+  parser->limits = saved_limits;
+  parser->has_limits = saved_has_limits;
+  parser->finished_error = saved_finished_error;
+  parser->profiling = saved_profiling;
+
+  cmark_inlines_init_special_chars(parser);
+
+  if (saved_stats)
+    cmark_stats_leave(outer_stats);
 }
 
 cmark_parser *cmark_parser_new_with_mem(int options, cmark_mem *mem) {
   cmark_parser *parser = (cmark_parser *)mem->calloc(1, sizeof(cmark_parser));
   parser->mem = mem;
   parser->options = options;
+  cmark_strbuf_init(mem, &parser->curline, 256);
+  cmark_strbuf_init(mem, &parser->linebuf, 0);
+  parser->refmap = cmark_reference_map_new(mem);
+  if (cmark_mem_is_instrumented(mem))
+    parser->stats = cmark_stats_collector_new();
   cmark_parser_reset(parser);
   return parser;
 }
@@ -140,11 +243,17 @@ cmark_parser *cmark_parser_new(int options) {
 
 void cmark_parser_free(cmark_parser *parser) {
   cmark_mem *mem = parser->mem;
-  cmark_parser_dispose(parser);
+  if (parser->root)
+    cmark_node_free(parser->root);
+  cmark_reference_map_free(parser->refmap);
   cmark_strbuf_release(&parser->curline);
   cmark_strbuf_release(&parser->linebuf);
-  cmark_llist_free(parser->syntax_extensions);
   cmark_llist_free(parser->inline_syntax_extensions);
+  cmark_llist_free_full(parser->syntax_extensions,
+                        (CMarkListFreeFunc) cmark_syntax_extension_free);
+  S_dispatch_free(mem, parser->block_dispatch);
+  S_dispatch_free(mem, parser->inline_dispatch);
+  cmark_stats_collector_free(parser->stats);
   mem->free(parser);
 }
 
@@ -286,6 +395,7 @@ static cmark_node *finalize(cmark_parser *parser, cmark_node *b) {
     b->end_line = parser->line_number - 1;
     b->end_column = parser->last_line_length;
   }
+  CMARK_PROBE3(block__close, S_type(b), b->start_line, b->end_line);
 
   cmark_strbuf *node_content = &b->content;
 
@@ -293,12 +403,14 @@ static cmark_node *finalize(cmark_parser *parser, cmark_node *b) {
   case CMARK_NODE_PARAGRAPH:
   {
     cmark_chunk chunk = {node_content->ptr, node_content->size, 0};
+    parser->refmap->line = b->start_line;
     while (chunk.len && chunk.data[0] == '[' &&
            (pos = cmark_parse_reference_inline(parser->mem, &chunk, parser->refmap))) {
 
       chunk.data += pos;
       chunk.len -= pos;
     }
+    parser->refmap->line = 0;
     cmark_strbuf_drop(node_content, (node_content->size - chunk.len));
     if (is_blank(node_content, 0)) {
       // remove blank node (former reference def)
@@ -384,9 +496,25 @@ static cmark_node *add_child(cmark_parser *parser, cmark_node *parent,
     parent = finalize(parser, parent);
   }
 
+  // A block past the depth limit stops the parse; open_new_blocks opens
+  // nothing more on this line, and S_enforce_max_depth drops the block.
+  if (parser->limits.max_depth > 0 && !parser->error) {
+    cmark_node *tmp = parent;
+    int depth = 1;
+
+    while (tmp->parent && depth <= parser->limits.max_depth) {
+      tmp = tmp->parent;
+      depth++;
+    }
+    if (depth > parser->limits.max_depth)
+      parser->error = CMARK_PARSER_ERROR_DEPTH_LIMIT;
+  }
+
   cmark_node *child =
       make_block(parser->mem, block_type, parser->line_number, start_column);
+  CMARK_PROBE3(block__open, block_type, parser->line_number, start_column);
   child->parent = parent;
+  parser->num_nodes++;
 
   if (parent->last_child) {
     parent->last_child->next = child;
@@ -399,32 +527,14 @@ static cmark_node *add_child(cmark_parser *parser, cmark_node *parent,
   return child;
 }
 
-static void manage_extensions_special_characters(cmark_parser *parser, bool add) {
-  cmark_llist *tmp_ext;
-
-  for (tmp_ext = parser->inline_syntax_extensions; tmp_ext; tmp_ext=tmp_ext->next) {
-    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp_ext->data;
-    cmark_llist *tmp_char;
-    for (tmp_char = ext->special_inline_chars; tmp_char; tmp_char=tmp_char->next) {
-      unsigned char c = (unsigned char) (unsigned long) tmp_char->data;
-      if (add)
-        cmark_inlines_add_special_character(c);
-      else
-        cmark_inlines_remove_special_character(c);
-    }
-  }
-}
-
 // Walk through node and all children, recursively, parsing
 // string content into inline content where appropriate.
-static void process_inlines(cmark_parser *parser, cmark_reference_map *refmap,
-                            int options) {
-  cmark_iter *iter = cmark_iter_new(parser->root);
+static void process_inlines(cmark_parser *parser, cmark_node *root,
+                            cmark_reference_map *refmap, int options) {
+  cmark_iter *iter = cmark_iter_new(root);
   cmark_node *cur;
   cmark_event_type ev_type;
 
-  manage_extensions_special_characters(parser, true);
-
   while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
     cur = cmark_iter_get_node(iter);
     if (ev_type == CMARK_EVENT_ENTER) {
@@ -434,11 +544,30 @@ static void process_inlines(cmark_parser *parser, cmark_reference_map *refmap,
     }
   }
 
-  manage_extensions_special_characters(parser, false);
-
   cmark_iter_free(iter);
 }
 
+void cmark_parser_reparse_inlines(cmark_parser *parser, cmark_node *root,
+                                  cmark_reference_map *refmap) {
+  cmark_node *node = root;
+
+  while (node) {
+    if (contains_inlines(S_type(node))) {
+      while (node->first_child)
+        cmark_node_free(node->first_child);
+    } else if (node->first_child) {
+      node = node->first_child;
+      continue;
+    }
+    while (node != root && node->next == NULL)
+      node = node->parent;
+    node = node == root ? NULL : node->next;
+  }
+
+  process_inlines(parser, root, refmap, parser->options);
+  cmark_consolidate_text_nodes(root);
+}
+
 // Attempts to parse a list item marker (bullet or enumerated).
 // On success, returns length of the marker, and populates
 // data with the details.  On failure, returns 0.
@@ -470,6 +599,7 @@ static bufsize_t parse_list_marker(cmark_mem *mem, cmark_chunk *input,
       }
     }
 
+    CMARK_ALLOC_SITE(mem, CMARK_ALLOC_NODE);
     data = (cmark_list *)mem->calloc(1, sizeof(*data));
     data->marker_offset = 0; // will be adjusted later
     data->list_type = CMARK_BULLET_LIST;
@@ -510,6 +640,7 @@ static bufsize_t parse_list_marker(cmark_mem *mem, cmark_chunk *input,
         }
       }
 
+      CMARK_ALLOC_SITE(mem, CMARK_ALLOC_NODE);
       data = (cmark_list *)mem->calloc(1, sizeof(*data));
       data->marker_offset = 0; // will be adjusted later
       data->list_type = CMARK_ORDERED_LIST;
@@ -537,29 +668,88 @@ static int lists_match(cmark_list *list_data, cmark_list *item_data) {
 }
 
 static cmark_node *finalize_document(cmark_parser *parser) {
+  cmark_profile *profile = cmark_parser_profile(parser);
+  uint64_t start = 0;
+
   while (parser->current != parser->root) {
     parser->current = finalize(parser, parser->current);
   }
 
   finalize(parser, parser->root);
-  process_inlines(parser, parser->refmap, parser->options);
+
+  if (profile)
+    start = cmark_clock_ns();
+  process_inlines(parser, parser->root, parser->refmap, parser->options);
+  if (profile)
+    cmark_profile_add(profile, CMARK_PHASE_INLINES, start, cmark_clock_ns());
 
   return parser->root;
 }
 
-cmark_node *cmark_parse_file(FILE *f, int options) {
+#ifdef HAVE_MMAP
+// Map the rest of a regular file and feed it in one go, so that no line
+// straddles a read boundary and has to be copied into parser->linebuf.
+// Returns false if 'f' cannot be mapped and should be read instead.
+static bool S_parser_feed_mapped(cmark_parser *parser, FILE *f) {
+  struct stat st;
+  int fd = fileno(f);
+  off_t pos;
+  size_t size;
+  void *map;
+
+  if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    return false;
+
+  // Honour anything already consumed through the stdio buffer.
+  pos = ftello(f);
+  if (pos < 0 || pos >= st.st_size ||
+      (uintmax_t)st.st_size > (uintmax_t)SIZE_MAX)
+    return false;
+
+  size = (size_t)st.st_size;
+  map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return false;
+
+#ifdef HAVE_MADVISE
+  madvise(map, size, MADV_SEQUENTIAL);
+#endif
+
+  S_parser_feed(parser, (const unsigned char *)map + pos, size - (size_t)pos,
+                false);
+
+  munmap(map, size);
+  fseeko(f, 0, SEEK_END);
+  return true;
+}
+#endif
+
+void cmark_parser_feed_file(cmark_parser *parser, FILE *f, bool map) {
   unsigned char buffer[4096];
-  cmark_parser *parser = cmark_parser_new(options);
   size_t bytes;
-  cmark_node *document;
+
+#ifdef HAVE_MMAP
+  if (map && S_parser_feed_mapped(parser, f))
+    return;
+#else
+  (void)map;
+#endif
 
   while ((bytes = fread(buffer, 1, sizeof(buffer), f)) > 0) {
-    bool eof = bytes < sizeof(buffer);
-    S_parser_feed(parser, buffer, bytes, eof);
-    if (eof) {
+    S_parser_feed(parser, buffer, bytes, false);
+    if (bytes < sizeof(buffer)) {
       break;
     }
   }
+}
+
+cmark_node *cmark_parse_file(FILE *f, int options) {
+  cmark_parser *parser = cmark_parser_new(options);
+  cmark_node *document;
+
+  // Not mapped: a file truncated while it is read would raise SIGBUS in
+  // the caller, which only asked for a file to be parsed.
+  cmark_parser_feed_file(parser, f, false);
 
   document = cmark_parser_finish(parser);
   cmark_parser_free(parser);
@@ -598,6 +788,15 @@ static void S_parser_feed(cmark_parser *parser, const unsigned char *buffer,
                           size_t len, bool eof) {
   const unsigned char *end = buffer + len;
   static const uint8_t repl[] = {239, 191, 189};
+  cmark_stats_collector *outer_stats = NULL;
+  cmark_profile *profile;
+  uint64_t start = 0;
+
+  if (parser->stats)
+    outer_stats = cmark_stats_enter(parser->stats);
+  profile = cmark_parser_profile(parser);
+  if (profile)
+    start = cmark_clock_ns();
 
   if (parser->last_buffer_ended_with_cr && *buffer == '\n') {
     // skip NL if last buffer ended with CR ; see #117
@@ -608,6 +807,10 @@ static void S_parser_feed(cmark_parser *parser, const unsigned char *buffer,
     const unsigned char *eol;
     bufsize_t chunk_len;
     bool process = false;
+
+    if (parser->has_limits && cmark_parser_check_limits(parser))
+      break;
+
     for (eol = buffer; eol < end; ++eol) {
       if (S_is_line_end_char(*eol)) {
         process = true;
@@ -658,6 +861,11 @@ static void S_parser_feed(cmark_parser *parser, const unsigned char *buffer,
       }
     }
   }
+
+  if (profile)
+    cmark_profile_add(profile, CMARK_PHASE_FEED, start, cmark_clock_ns());
+  if (parser->stats)
+    cmark_stats_leave(outer_stats);
 }
 
 static void chop_trailing_hashtags(cmark_chunk *ch) {
@@ -960,7 +1168,8 @@ static void open_new_blocks(cmark_parser *parser, cmark_node **container,
   int save_column;
 
   while (cont_type != CMARK_NODE_CODE_BLOCK &&
-         cont_type != CMARK_NODE_HTML_BLOCK) {
+         cont_type != CMARK_NODE_HTML_BLOCK &&
+         parser->error != CMARK_PARSER_ERROR_DEPTH_LIMIT) {
 
     S_find_first_nonspace(parser, input);
     indented = parser->indent >= CODE_INDENT;
@@ -1109,26 +1318,37 @@ static void open_new_blocks(cmark_parser *parser, cmark_node **container,
     } else {
       cmark_llist *tmp;
       cmark_node *new_container = NULL;
+      cmark_syntax_extension *owner = (*container)->extension;
+      unsigned char c = parser->first_nonspace < input->len
+                            ? peek_at(input, parser->first_nonspace)
+                            : 0;
+
+      // The extension that owns the current container (e.g. a table
+      // that is being extended row by row) is always consulted first;
+      // other extensions only for the characters they start blocks with.
+      if (owner && owner->try_opening_block) {
+        const char *input_cstr = cmark_chunk_to_cstr(parser->mem, input);
+
+        new_container = owner->try_opening_block(
+            owner, indented, parser, *container, input_cstr);
+      }
 
-      for (tmp = parser->syntax_extensions; tmp; tmp=tmp->next) {
+      tmp = parser->block_dispatch ? parser->block_dispatch[c] : NULL;
+      for (; tmp && !new_container; tmp = tmp->next) {
         cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
 
-        if (ext->try_opening_block) {
+        if (ext != owner) {
           const char *input_cstr = cmark_chunk_to_cstr(parser->mem, input);
 
           new_container = ext->try_opening_block(
               ext, indented, parser, *container, input_cstr);
-
-          if (new_container) {
-            *container = new_container;
-            break;
-          }
         }
       }
 
       if (!new_container) {
         break;
       }
+      *container = new_container;
     }
 
     if (accepts_lines(S_type(*container))) {
@@ -1322,23 +1542,73 @@ finished:
   cmark_strbuf_clear(&parser->curline);
 }
 
+// Drop everything nested deeper than the depth limit: inlines, and the
+// block at which add_child stopped the parse.
+static void S_enforce_max_depth(cmark_parser *parser) {
+  cmark_node *root = parser->root;
+  cmark_node *node = root;
+  int depth = 0;
+
+  while (node) {
+    if (depth == parser->limits.max_depth && node->first_child) {
+      while (node->first_child)
+        cmark_node_free(node->first_child);
+      if (!parser->error)
+        parser->error = CMARK_PARSER_ERROR_DEPTH_LIMIT;
+    }
+
+    if (node->first_child) {
+      node = node->first_child;
+      depth++;
+      continue;
+    }
+    while (node != root && node->next == NULL) {
+      node = node->parent;
+      depth--;
+    }
+    node = node == root ? NULL : node->next;
+  }
+}
+
 cmark_node *cmark_parser_finish(cmark_parser *parser) {
+  cmark_stats_collector *outer_stats = NULL;
+  cmark_profile *profile;
+  uint64_t start = 0;
   cmark_node *res;
 
   /* Parser was already finished once */
   if (parser->root == NULL)
     return NULL;
 
-  if (parser->linebuf.size) {
+  if (parser->stats)
+    outer_stats = cmark_stats_enter(parser->stats);
+
+  if (parser->has_limits)
+    cmark_parser_check_limits(parser);
+
+  profile = cmark_parser_profile(parser);
+  if (profile)
+    start = cmark_clock_ns();
+
+  if (parser->linebuf.size && !parser->error) {
     S_process_line(parser, parser->linebuf.ptr, parser->linebuf.size);
     cmark_strbuf_clear(&parser->linebuf);
   }
 
   finalize_document(parser);
 
-  cmark_consolidate_text_nodes(parser->root);
+  if (profile) {
+    uint64_t finalized = cmark_clock_ns();
+    cmark_profile_add(profile, CMARK_PHASE_FINALIZE, start, finalized);
+    cmark_consolidate_text_nodes(parser->root);
+    cmark_profile_add(profile, CMARK_PHASE_CONSOLIDATE, finalized,
+                      cmark_clock_ns());
+  } else {
+    cmark_consolidate_text_nodes(parser->root);
+  }
 
-  cmark_strbuf_release(&parser->curline);
+  if (parser->limits.max_depth > 0)
+    S_enforce_max_depth(parser);
 
 #if CMARK_DEBUG_NODES
   if (cmark_node_check(parser->root, stderr)) {
@@ -1346,8 +1616,19 @@ cmark_node *cmark_parser_finish(cmark_parser *parser) {
   }
 #endif
 
+  if (parser->stats) {
+    cmark_stats_finish_document(parser->stats, parser->root, parser->refmap);
+    cmark_stats_leave(outer_stats);
+  }
+
   res = parser->root;
   parser->root = NULL;
+  parser->finished_error = parser->error;
+
+  if (parser->refmap->keep_definitions) {
+    res->as.document.refmap = parser->refmap;
+    parser->refmap = cmark_reference_map_new(parser->mem);
+  }
 
   cmark_parser_reset(parser);
 
@@ -1412,7 +1693,66 @@ void cmark_parser_add_reference(cmark_parser *parser, const char *label, const c
   cmark_chunk refurl = cmark_chunk_literal(url);
   cmark_chunk reftitle = cmark_chunk_literal(title);
 
+  cmark_stats_collector *outer_stats = NULL;
+
+  if (parser->stats)
+    outer_stats = cmark_stats_enter(parser->stats);
   cmark_reference_create(parser->refmap, &reflabel, &refurl, &reftitle);
+  if (parser->stats)
+    cmark_stats_leave(outer_stats);
+}
+
+void cmark_parser_set_limits(cmark_parser *parser,
+                             const cmark_parser_limits *limits) {
+  parser->limits = *limits;
+  parser->has_limits = limits->max_bytes || limits->max_nodes ||
+                       limits->max_depth || limits->max_delimiters;
+}
+
+void cmark_parser_set_profiler(cmark_parser *parser, bool enabled) {
+  parser->profiling = enabled;
+}
+
+cmark_profile *cmark_parser_profile(cmark_parser *parser) {
+  cmark_node *root = parser->root;
+
+  if (!parser->profiling || root == NULL)
+    return NULL;
+  if (root->as.document.profile == NULL)
+    root->as.document.profile =
+        (cmark_profile *)parser->mem->calloc(1, sizeof(cmark_profile));
+  return root->as.document.profile;
+}
+
+cmark_parser_error cmark_parser_get_error(cmark_parser *parser) {
+  return parser->finished_error;
+}
+
+bool cmark_parser_check_limits(cmark_parser *parser) {
+  const cmark_parser_limits *limits = &parser->limits;
+
+  if (parser->error)
+    return true;
+
+  if (limits->max_nodes && parser->num_nodes > limits->max_nodes)
+    parser->error = CMARK_PARSER_ERROR_NODE_LIMIT;
+  else if (limits->max_delimiters &&
+           parser->num_delimiter_steps > limits->max_delimiters)
+    parser->error = CMARK_PARSER_ERROR_DELIMITER_LIMIT;
+  else if (limits->max_bytes && parser->stats &&
+           cmark_stats_bytes_allocated(parser->stats) > limits->max_bytes)
+    parser->error = CMARK_PARSER_ERROR_MEMORY_LIMIT;
+
+  return parser->error != CMARK_PARSER_OK;
+}
+
+bool cmark_parser_get_stats(cmark_parser *parser, cmark_parser_stats *stats) {
+  if (parser->stats == NULL) {
+    memset(stats, 0, sizeof(*stats));
+    return false;
+  }
+  cmark_stats_get(parser->stats, stats);
+  return true;
 }
 
 cmark_node *cmark_parser_get_root(cmark_parser *parser) {
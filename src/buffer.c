@@ -10,6 +10,7 @@
 #include "cmark_ctype.h"
 #include "buffer.h"
 #include "memory.h"
+#include "stats.h"
 
 /* Used as default value for cmark_strbuf->ptr so that people can always
  * assume ptr is non-NULL and zero terminated even for new cmark_strbufs.
@@ -62,6 +63,7 @@ void cmark_strbuf_grow(cmark_strbuf *buf, bufsize_t target_size) {
   new_size += 1;
   new_size = (new_size + 7) & ~7;
 
+  CMARK_ALLOC_SITE(buf->mem, CMARK_ALLOC_STRBUF);
   buf->ptr = (unsigned char *)buf->mem->realloc(buf->asize ? buf->ptr : NULL,
                                                 new_size);
   buf->asize = new_size;
@@ -132,6 +134,23 @@ void cmark_strbuf_puts(cmark_strbuf *buf, const char *string) {
   cmark_strbuf_put(buf, (const unsigned char *)string, strlen(string));
 }
 
+void cmark_strbuf_put_int(cmark_strbuf *buf, int n) {
+  // Enough room for "-2147483648".
+  unsigned char digits[12];
+  unsigned char *p = digits + sizeof(digits);
+  unsigned int u = n < 0 ? 0U - (unsigned int)n : (unsigned int)n;
+
+  do {
+    *--p = (unsigned char)('0' + u % 10);
+    u /= 10;
+  } while (u);
+
+  if (n < 0)
+    *--p = '-';
+
+  cmark_strbuf_put(buf, p, (bufsize_t)(digits + sizeof(digits) - p));
+}
+
 const char *cmark_strbuf_get(cmark_strbuf *buf) {
   return (const char *) buf->ptr;
 }
@@ -167,6 +186,7 @@ unsigned char *cmark_strbuf_detach(cmark_strbuf *buf) {
 
   if (buf->asize == 0) {
     /* return an empty string */
+    CMARK_ALLOC_SITE(buf->mem, CMARK_ALLOC_STRBUF);
     return (unsigned char *)buf->mem->calloc(1, 1);
   }
 
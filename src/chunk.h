@@ -8,6 +8,7 @@
 #include "buffer.h"
 #include "memory.h"
 #include "cmark_ctype.h"
+#include "stats.h"
 
 #define CMARK_CHUNK_EMPTY                                                      \
   { NULL, 0, 0 }
@@ -66,6 +67,7 @@ static CMARK_INLINE const char *cmark_chunk_to_cstr(cmark_mem *mem,
   if (c->alloc) {
     return (char *)c->data;
   }
+  CMARK_ALLOC_SITE(mem, CMARK_ALLOC_CSTR);
   str = (unsigned char *)mem->calloc(c->len + 1, 1);
   if (c->len > 0) {
     memcpy(str, c->data, c->len);
@@ -86,6 +88,7 @@ static CMARK_INLINE void cmark_chunk_set_cstr(cmark_mem *mem, cmark_chunk *c,
     c->alloc = 0;
   } else {
     c->len = (bufsize_t)strlen(str);
+    CMARK_ALLOC_SITE(mem, CMARK_ALLOC_CHUNK_COPY);
     c->data = (unsigned char *)mem->calloc(c->len + 1, 1);
     c->alloc = 1;
     memcpy(c->data, str, c->len + 1);
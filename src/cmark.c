@@ -6,11 +6,19 @@
 #include "houdini.h"
 #include "cmark.h"
 #include "buffer.h"
+#include "cmark_clock.h"
+#include "work.h"
 
 int cmark_version() { return CMARK_VERSION; }
 
 const char *cmark_version_string() { return CMARK_VERSION_STRING; }
 
+uint64_t cmark_profile_clock(void) { return cmark_clock_ns(); }
+
+#ifdef CMARK_COUNT_WORK
+cmark_work_counters cmark_work;
+#endif
+
 static void *xcalloc(size_t nmem, size_t size) {
   void *ptr = calloc(nmem, size);
   if (!ptr) {
@@ -44,7 +52,7 @@ char *cmark_markdown_to_html(const char *text, size_t len, int options) {
 }
 
 bool cmark_init(void) {
-  cmark_discover_plugins();
+  cmark_register_builtin_extensions();
   return true;
 }
 
@@ -2,6 +2,7 @@
 #define CMARK_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <cmark_export.h>
 #include <cmark_version.h>
 #include <cmark_config.h>
@@ -94,6 +95,7 @@ typedef enum {
 
 typedef struct cmark_node cmark_node;
 typedef struct cmark_parser cmark_parser;
+typedef struct cmark_parser_pool cmark_parser_pool;
 typedef struct cmark_iter cmark_iter;
 typedef struct cmark_strbuf cmark_strbuf;
 typedef struct cmark_plugin cmark_plugin;
@@ -161,12 +163,21 @@ void          cmark_llist_free      (cmark_llist       * head);
  * ## Initialization
  */
 
-/** Initialize the cmark library. This will discover available plugins.
+/** Initialize the cmark library. This registers the built-in extensions
+ *  (see cmark_register_builtin_extensions); plugins are discovered lazily,
+ *  the first time an extension is requested that is not already known.
  *  Returns 'true' if initialization was successful, 'false' otherwise.
  */
 CMARK_EXPORT
 bool cmark_init(void);
 
+/** Register the core extensions that were linked into the library, without
+ *  touching the filesystem.  Calling it more than once has no effect, and
+ *  it does nothing if libcmark was built without CMARK_BUILTIN_EXTENSIONS.
+ */
+CMARK_EXPORT
+void cmark_register_builtin_extensions(void);
+
 /** Deinitialize the cmark library. This will release all plugins.
  *  Returns true if deinitialization was successful, 'false' otherwise.
  */
@@ -619,6 +630,263 @@ bool cmark_parser_attach_syntax_extension(cmark_parser *parser, cmark_syntax_ext
 CMARK_EXPORT
 void cmark_parser_add_reference(cmark_parser *parser, const char *label, const char *url, const char *title);
 
+/**
+ * ## Parser pools
+ *
+ * A pool hands out parsers that are reused across documents, keeping
+ * their attached extensions and the capacity of their internal buffers.
+ * This saves most of the setup cost when parsing many small documents.
+ * Pools are safe to share between threads; a checked-out parser is not.
+ *
+ *     cmark_parser_pool *pool = cmark_parser_pool_new(CMARK_OPT_DEFAULT);
+ *     ...
+ *     cmark_parser *parser = cmark_parser_pool_checkout(pool);
+ *     cmark_parser_feed(parser, buffer, len);
+ *     document = cmark_parser_finish(parser);
+ *     cmark_parser_pool_return(pool, parser);
+ *     ...
+ *     cmark_parser_pool_free(pool);
+ */
+
+/** Creates a pool of parsers created with 'options'.
+ */
+CMARK_EXPORT
+cmark_parser_pool *cmark_parser_pool_new(int options);
+
+/** Creates a pool of parsers that use the given memory allocator.
+ */
+CMARK_EXPORT
+cmark_parser_pool *cmark_parser_pool_new_with_mem(int options, cmark_mem *mem);
+
+/** Frees 'pool' and the parsers that are idle in it.  Parsers that are
+ * still checked out must be freed with 'cmark_parser_free' instead.
+ */
+CMARK_EXPORT
+void cmark_parser_pool_free(cmark_parser_pool *pool);
+
+/** Attach the syntax 'extension' to every parser handed out by 'pool'.
+ * Extensions can only be attached before the first checkout.
+ *
+ * Returns 'true' if the 'extension' was attached, 'false' otherwise.
+ */
+CMARK_EXPORT
+bool cmark_parser_pool_attach_syntax_extension(cmark_parser_pool *pool,
+                                               cmark_syntax_extension *extension);
+
+/** Takes a parser from 'pool', creating one if none is idle.  The parser
+ * is ready for a new document.
+ */
+CMARK_EXPORT
+cmark_parser *cmark_parser_pool_checkout(cmark_parser_pool *pool);
+
+/** Gives 'parser' back to 'pool'.  A document that was fed but not
+ * finished is discarded, as are references added with
+ * 'cmark_parser_add_reference'.
+ */
+CMARK_EXPORT
+void cmark_parser_pool_return(cmark_parser_pool *pool, cmark_parser *parser);
+
+/**
+ * ## Parse statistics
+ *
+ * A parser created with the instrumented allocator records how much
+ * memory each document took and what the document looked like:
+ *
+ *     cmark_parser *parser = cmark_parser_new_with_mem(
+ *         CMARK_OPT_DEFAULT, cmark_get_instrumented_mem_allocator());
+ *     cmark_parser_feed(parser, buffer, len);
+ *     document = cmark_parser_finish(parser);
+ *     cmark_parser_get_stats(parser, &stats);
+ */
+
+/** What an allocation made while parsing was for.
+ */
+typedef enum {
+  /** Anything not listed below, such as the parser itself */
+  CMARK_ALLOC_OTHER = 0,
+  /** Nodes, and the list data of list nodes */
+  CMARK_ALLOC_NODE,
+  /** Growing a 'cmark_strbuf': lines, block contents, cleaned up link
+   * destinations and titles */
+  CMARK_ALLOC_STRBUF,
+  /** Copies of strings held by nodes */
+  CMARK_ALLOC_CHUNK_COPY,
+  /** Terminated copies of node contents for the node getters and for
+   * extensions */
+  CMARK_ALLOC_CSTR,
+  /** Entries on the emphasis delimiter and link bracket stacks */
+  CMARK_ALLOC_DELIMITER,
+  /** Link reference definitions */
+  CMARK_ALLOC_REFERENCE,
+  CMARK_ALLOC_LAST = CMARK_ALLOC_REFERENCE
+} cmark_alloc_site;
+
+/** Statistics about the document most recently finished by a parser.
+ */
+typedef struct cmark_parser_stats {
+  /** Bytes requested from the allocator while parsing; growing a
+   * buffer counts the growth only */
+  size_t bytes_allocated;
+  /** Largest number of bytes held at any one time */
+  size_t bytes_peak;
+  /** Bytes still held when parsing finished, mostly the document tree */
+  size_t bytes_live;
+  /** Calls to 'calloc' and 'realloc' */
+  size_t allocations;
+  /** Nodes in the document, indexed by 'cmark_node_type' */
+  size_t nodes[CMARK_NODE_LAST_INLINE + 1];
+  size_t nodes_total;
+  /** Distinct link reference definitions */
+  size_t reference_definitions;
+  /** Largest number of entries on the emphasis delimiter stack while
+   * parsing any one block's inlines */
+  size_t delimiters_peak;
+  /** Deepest nesting of nodes; children of the document are at depth 1 */
+  int max_depth;
+  /** Calls to 'calloc' and 'realloc' and the bytes they requested,
+   * counted as in 'allocations' and 'bytes_allocated', indexed by
+   * 'cmark_alloc_site' */
+  size_t site_allocations[CMARK_ALLOC_LAST + 1];
+  size_t site_bytes[CMARK_ALLOC_LAST + 1];
+  /** Nodes allocated, indexed by 'cmark_node_type'.  Unlike 'nodes'
+   * this includes nodes that were freed again before parsing finished,
+   * such as the text of unmatched brackets. */
+  size_t node_allocations[CMARK_NODE_LAST_INLINE + 1];
+} cmark_parser_stats;
+
+/** Returns an allocator that lets parsers created with it through
+ * 'cmark_parser_new_with_mem' collect statistics.  Memory allocated
+ * with it is ordinary heap memory, so everything the library returns
+ * can still be released with 'free'.  Only allocations made while the
+ * parser is working are counted, which makes the instrumented allocator
+ * safe to share between parsers and threads.
+ */
+CMARK_EXPORT
+cmark_mem *cmark_get_instrumented_mem_allocator(void);
+
+/** Fills 'stats' with statistics about the document most recently
+ * returned by 'cmark_parser_finish'.
+ *
+ * Returns 'false', leaving 'stats' zeroed, if 'parser' was not created
+ * with the instrumented allocator.
+ */
+CMARK_EXPORT
+bool cmark_parser_get_stats(cmark_parser *parser, cmark_parser_stats *stats);
+
+/**
+ * ## Parser limits
+ *
+ * For untrusted input a parser can be given hard budgets.  When one is
+ * exceeded the parser stops consuming input, 'cmark_parser_finish'
+ * returns the part of the document parsed so far, and
+ * 'cmark_parser_get_error' reports which budget was exhausted.  Limits
+ * are checked after every line and every inline element, so a budget
+ * is overshot by at most the work for one of them.
+ */
+
+/** Which limit cut a document short.
+ */
+typedef enum {
+  CMARK_PARSER_OK = 0,
+  CMARK_PARSER_ERROR_MEMORY_LIMIT,
+  CMARK_PARSER_ERROR_NODE_LIMIT,
+  CMARK_PARSER_ERROR_DEPTH_LIMIT,
+  CMARK_PARSER_ERROR_DELIMITER_LIMIT
+} cmark_parser_error;
+
+/** Budgets for a single document.  Zero means unlimited.
+ */
+typedef struct cmark_parser_limits {
+  /** Bytes allocated while parsing.  Only enforced for parsers created
+   * with 'cmark_get_instrumented_mem_allocator', as other allocators
+   * give no way of attributing memory to a parser. */
+  size_t max_bytes;
+  /** Nodes created while parsing */
+  size_t max_nodes;
+  /** Nesting depth of the document.  Parsing stops at the first block
+   * that would be nested deeper; deeper inlines are dropped */
+  int max_depth;
+  /** Delimiters examined while resolving emphasis */
+  size_t max_delimiters;
+} cmark_parser_limits;
+
+/** Sets the budgets that 'parser' applies to each document.
+ */
+CMARK_EXPORT
+void cmark_parser_set_limits(cmark_parser *parser,
+                             const cmark_parser_limits *limits);
+
+/** Returns the limit that cut short the document most recently returned
+ * by 'cmark_parser_finish', or 'CMARK_PARSER_OK'.
+ */
+CMARK_EXPORT
+cmark_parser_error cmark_parser_get_error(cmark_parser *parser);
+
+/**
+ * ## Profiling
+ *
+ * A parser can record how long each phase of a document takes.  The
+ * timings travel with the document node returned by
+ * 'cmark_parser_finish', so that rendering it adds the renderer's time
+ * too, and are read back with 'cmark_node_get_profile'.  Phases nest as
+ * the functions that implement them do: CMARK_PHASE_FINALIZE includes
+ * CMARK_PHASE_INLINES, which includes CMARK_PHASE_REFERENCES.
+ */
+
+typedef enum {
+  /** Splitting input into lines and parsing blocks, in cmark_parser_feed */
+  CMARK_PHASE_FEED,
+  /** Closing the open blocks and parsing inlines, in cmark_parser_finish */
+  CMARK_PHASE_FINALIZE,
+  /** Parsing the inline content of every block */
+  CMARK_PHASE_INLINES,
+  /** Looking up link reference definitions */
+  CMARK_PHASE_REFERENCES,
+  /** Merging adjacent text nodes */
+  CMARK_PHASE_CONSOLIDATE,
+  CMARK_PHASE_RENDER_HTML,
+  CMARK_PHASE_RENDER_XML,
+  CMARK_PHASE_RENDER_MAN,
+  CMARK_PHASE_RENDER_COMMONMARK,
+  CMARK_PHASE_RENDER_LATEX,
+  CMARK_PHASE_LAST = CMARK_PHASE_RENDER_LATEX
+} cmark_phase;
+
+/** Timestamps are nanoseconds from the monotonic clock read by
+ * 'cmark_profile_clock'.
+ */
+typedef struct cmark_phase_timing {
+  /** When the phase was first entered */
+  uint64_t first_start_ns;
+  /** When the phase was last left */
+  uint64_t last_end_ns;
+  /** Time spent in the phase */
+  uint64_t total_ns;
+  /** How many times the phase was entered; zero if it never was */
+  size_t count;
+} cmark_phase_timing;
+
+typedef struct cmark_profile {
+  cmark_phase_timing phases[CMARK_PHASE_LAST + 1];
+} cmark_profile;
+
+/** Turns profiling of the documents parsed by 'parser' on or off.
+ */
+CMARK_EXPORT
+void cmark_parser_set_profiler(cmark_parser *parser, bool enabled);
+
+/** Copies the timings recorded for the document 'node' into 'profile'
+ * and returns true.  Returns false and zeroes 'profile' if 'node' is not
+ * a document parsed with profiling turned on.
+ */
+CMARK_EXPORT
+bool cmark_node_get_profile(cmark_node *node, cmark_profile *profile);
+
+/** Returns the current reading of the clock used for profiles.
+ */
+CMARK_EXPORT
+uint64_t cmark_profile_clock(void);
+
 /** Parse a CommonMark document in 'buffer' of length 'len'.
  * Returns a pointer to a tree of nodes.  The memory allocated for
  * the node tree should be released using 'cmark_node_free'
@@ -824,7 +1092,12 @@ void cmark_parser_advance_offset(cmark_parser *parser,
  * with a single exported function named after the distributed
  * filename.
  *
- * When discovering extensions (see cmark_init), cmark will
+ * The core extensions are linked into libcmark and registered by
+ * cmark_init without any filesystem access.  Plugins are only discovered
+ * when cmark_find_syntax_extension is asked for a name that is not
+ * already registered, or when cmark_list_syntax_extensions is called.
+ *
+ * When discovering extensions, cmark will
  * try to load a symbol named "init_{{filename}}" in all the
  * dynamic libraries it encounters.
  *
@@ -874,8 +1147,8 @@ typedef struct delimiter {
  * This function will typically be called from the init function
  * of external modules.
  *
- * This takes ownership of 'extension', one should not call
- * 'cmark_syntax_extension_free' on a registered extension.
+ * This takes over the caller's reference to 'extension'; call
+ * 'cmark_syntax_extension_ref' first to keep using it afterwards.
  */
 CMARK_EXPORT
 bool cmark_plugin_register_syntax_extension(cmark_plugin *plugin,
@@ -949,12 +1222,19 @@ typedef delimiter *(*InlineFromDelimFunc)(cmark_syntax_extension *extension,
  * If 'try_opening_block' is NULL, the extension will have
  * no effect at all on the final AST.
  *
+ * If the extension lists characters in 'block_start_chars',
+ * 'try_opening_block' is only called for lines whose first non-space
+ * character is one of them, or when the current container was created
+ * by the extension itself.  Otherwise it is called for every line
+ * that does not start a core block.
+ *
  * #### Inline parsing phase hooks
  *
  * For each character listed by the extension in 'special_inline_chars',
  * 'match_inline' will get called, it is the responsibility of the extension
  * to scan the characters located at the current inline parsing offset
- * with the cmark_inline_parser API.
+ * with the cmark_inline_parser API.  An extension that lists none has
+ * 'match_inline' called at the start of every run of literal text.
  *
  * Depending on the type of the extension, it can either:
  *
@@ -993,14 +1273,26 @@ struct cmark_syntax_extension {
   char                  * name;
   void                  * priv;
   void                    (*free_function) (void *);
+  cmark_llist           * block_start_chars;
+  int                     refcount;
 };
 
-/** Free a cmark_syntax_extension.
+/** Release a reference to a cmark_syntax_extension, freeing it when the
+ * last reference is gone.  The registry and every parser the extension
+ * is attached to each hold a reference, so an extension stays valid for
+ * as long as a parser uses it.
  */
 CMARK_EXPORT
 void cmark_syntax_extension_free               (cmark_syntax_extension *extension);
 
-/** Return a newly-constructed cmark_syntax_extension, named 'name'.
+/** Take an additional reference to 'extension' and return it.  This is
+ * safe to call from several threads at once.
+ */
+CMARK_EXPORT
+cmark_syntax_extension *cmark_syntax_extension_ref (cmark_syntax_extension *extension);
+
+/** Return a newly-constructed cmark_syntax_extension, named 'name',
+ * holding a single reference.
  */
 CMARK_EXPORT
 cmark_syntax_extension *cmark_syntax_extension_new (const char *name);
@@ -1122,6 +1414,172 @@ char *cmark_render_commonmark(cmark_node *root, int options, int width);
 CMARK_EXPORT
 char *cmark_render_latex(cmark_node *root, int options, int width);
 
+/**
+ * ## Serialization
+ *
+ * A parsed tree can be saved in a compact binary form and loaded again
+ * much faster than its source can be parsed, so that documents can be
+ * cached between the stages of a pipeline.  The form does not depend
+ * on the host or on where it is loaded in memory, and it records the
+ * type, source position and contents of each node and the name of its
+ * syntax extension; user data and profiles are not saved.
+ */
+
+/** Serialize the tree under 'root', storing its length in '*len'.  It
+ * is the caller's responsibility to free the returned buffer.
+ */
+CMARK_EXPORT
+unsigned char *cmark_node_serialize(cmark_node *root, size_t *len);
+
+/** Rebuild a tree from the 'len' bytes at 'data' written by
+ * cmark_node_serialize().  Nodes made by a syntax extension are given
+ * the registered extension of the same name.  Returns NULL if 'data'
+ * was written by an incompatible version, is truncated or inconsistent,
+ * or names an extension that is not registered.
+ */
+CMARK_EXPORT
+cmark_node *cmark_node_deserialize(const void *data, size_t len);
+
+/** Like cmark_node_deserialize(), allocating the tree with 'mem'.
+ */
+CMARK_EXPORT
+cmark_node *cmark_node_deserialize_with_mem(const void *data, size_t len,
+                                            cmark_mem *mem);
+
+/** Like cmark_node_deserialize(), but the literals, URLs and titles of
+ * the tree are not copied; they point into 'data', which must stay
+ * valid and unchanged until the tree is freed.  This makes loading a
+ * file mapped with mmap() cheaper still.
+ */
+CMARK_EXPORT
+cmark_node *cmark_node_deserialize_view(const void *data, size_t len);
+
+/**
+ * ## Frozen trees
+ *
+ * A frozen tree is a read-only copy of a tree laid out for consumers
+ * that only read it, such as renderers and indexers.  Its nodes are
+ * stored contiguously in document order, with all of their text in a
+ * single string pool, and the type, parent, first child and next
+ * sibling of each node are also kept in arrays indexed by its position
+ * (the root is 0), so that the tree can be walked with a linear scan.
+ */
+
+typedef struct cmark_flat_tree cmark_flat_tree;
+
+/** The index of a parent, child or sibling that does not exist.
+ */
+#define CMARK_FLAT_NONE UINT32_MAX
+
+/** Make a frozen copy of the tree under 'root', which is left as it
+ * is and may be freed at once.  The copy shares the user data pointers
+ * of the original but not the responsibility for freeing them.
+ * Returns NULL if the tree has too many nodes.
+ */
+CMARK_EXPORT
+cmark_flat_tree *cmark_node_freeze(cmark_node *root);
+
+/** Free a frozen tree.
+ */
+CMARK_EXPORT
+void cmark_flat_tree_free(cmark_flat_tree *tree);
+
+/** Returns the number of nodes in 'tree'.
+ */
+CMARK_EXPORT
+uint32_t cmark_flat_tree_size(cmark_flat_tree *tree);
+
+/** Returns the array of the types of the nodes of 'tree', each a
+ * cmark_node_type.
+ */
+CMARK_EXPORT
+const uint8_t *cmark_flat_tree_types(cmark_flat_tree *tree);
+
+/** Returns the array of the indices of the parents of the nodes of
+ * 'tree', which are CMARK_FLAT_NONE for the root.
+ */
+CMARK_EXPORT
+const uint32_t *cmark_flat_tree_parents(cmark_flat_tree *tree);
+
+/** Returns the array of the indices of the first children of the nodes
+ * of 'tree', which are CMARK_FLAT_NONE for nodes without children.  A
+ * node's first child, if any, always comes right after it.
+ */
+CMARK_EXPORT
+const uint32_t *cmark_flat_tree_first_children(cmark_flat_tree *tree);
+
+/** Returns the array of the indices of the next siblings of the nodes
+ * of 'tree', which are CMARK_FLAT_NONE for last children.
+ */
+CMARK_EXPORT
+const uint32_t *cmark_flat_tree_next_siblings(cmark_flat_tree *tree);
+
+/** Returns the node at 'index' in 'tree', or NULL if there is none, for
+ * use with the accessors and the iterator.  It must not be modified or
+ * freed, and is valid until the tree is freed.
+ */
+CMARK_EXPORT
+cmark_node *cmark_flat_tree_node(cmark_flat_tree *tree, uint32_t index);
+
+/** Render 'tree' as an HTML fragment, like cmark_render_html().  It is
+ * the caller's responsibility to free the returned buffer.
+ */
+CMARK_EXPORT
+char *cmark_flat_tree_render_html(cmark_flat_tree *tree, int options);
+
+/** Render 'tree' as a commonmark document, like
+ * cmark_render_commonmark().  It is the caller's responsibility to free
+ * the returned buffer.
+ */
+CMARK_EXPORT
+char *cmark_flat_tree_render_commonmark(cmark_flat_tree *tree, int options,
+                                        int width);
+
+/**
+ * ## Incremental parsing
+ *
+ * An editor that shows a live preview can update the tree of a document
+ * after each edit instead of parsing it again.  Only the top-level
+ * blocks from the last one that starts before the edit to the first one
+ * after it at which the parser is back in step with the old tree are
+ * parsed again; the rest are kept, with their source positions moved.
+ * Inlines are parsed again outside that section only if its link
+ * reference definitions changed.  The result is the tree that parsing
+ * the new text in full would give.
+ *
+ *     cmark_node *doc = cmark_parse_document(text, len,
+ *                                            CMARK_OPT_INCREMENTAL);
+ *     ...  // replace 'old_len' bytes at 'start' with 'new_len' bytes
+ *     doc = cmark_reparse(doc, text, len, start, old_len, new_len,
+ *                         CMARK_OPT_INCREMENTAL);
+ *
+ * The document must have been parsed, or last updated, from the text
+ * before the edit with the same options and extensions, and not be
+ * modified in between.  A document parsed without CMARK_OPT_INCREMENTAL
+ * is parsed in full the first time it is updated.
+ */
+
+/** Update 'root', a document parsed from a text in which 'edit_old_len'
+ * bytes at 'edit_start' have since been replaced by the 'edit_new_len'
+ * bytes at the same offset in 'text', which is the 'len' bytes of the
+ * new text.  'root' is updated in place and returned, or NULL is
+ * returned if it is not a document or the edit does not fit in 'text'.
+ */
+CMARK_EXPORT
+cmark_node *cmark_reparse(cmark_node *root, const char *text, size_t len,
+                          size_t edit_start, size_t edit_old_len,
+                          size_t edit_new_len, int options);
+
+/** Like cmark_reparse(), parsing with 'parser' and so with its options
+ * and syntax extensions.  The parser must not have been fed anything
+ * since it was created or last finished.
+ */
+CMARK_EXPORT
+cmark_node *cmark_parser_reparse(cmark_parser *parser, cmark_node *root,
+                                 const char *text, size_t len,
+                                 size_t edit_start, size_t edit_old_len,
+                                 size_t edit_new_len);
+
 /**
  * ## Character buffer interface
  */
@@ -1198,6 +1656,12 @@ void cmark_strbuf_put(cmark_strbuf *buf, const unsigned char *data,
 CMARK_EXPORT
 void cmark_strbuf_puts(cmark_strbuf *buf, const char *string);
 
+/** Append the decimal representation of 'n' to 'buf'.  Unlike
+ * printf, this does not depend on the current locale.
+ */
+CMARK_EXPORT
+void cmark_strbuf_put_int(cmark_strbuf *buf, int n);
+
 /** Reset 'buf' to the empty state
  */
 CMARK_EXPORT
@@ -1299,6 +1763,12 @@ void cmark_strbuf_unescape(cmark_strbuf *s);
  */
 #define CMARK_OPT_SMART (1 << 10)
 
+/** Keep the link reference definitions of the document with it, so
+ * that cmark_reparse() can update it after an edit without parsing it
+ * all again.
+ */
+#define CMARK_OPT_INCREMENTAL (1 << 11)
+
 /**
  * ## Version information
  */
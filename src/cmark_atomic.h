@@ -0,0 +1,45 @@
+#ifndef CMARK_CMARK_ATOMIC_H
+#define CMARK_CMARK_ATOMIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Minimal atomic operations on 'int' counters and pointers, used for
+ * reference counts and for publishing data that is read without locks.
+ * Without compiler support they degrade to plain accesses, which is only
+ * correct for single-threaded use.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+
+#define cmark_atomic_inc(p) __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+#define cmark_atomic_dec(p) __atomic_sub_fetch((p), 1, __ATOMIC_ACQ_REL)
+#define cmark_atomic_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define cmark_atomic_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+#elif defined(_MSC_VER)
+
+#include <intrin.h>
+
+#define cmark_atomic_inc(p) _InterlockedIncrement((long volatile *)(p))
+#define cmark_atomic_dec(p) _InterlockedDecrement((long volatile *)(p))
+/* Aligned loads and stores are atomic on the platforms MSVC targets;
+ * the barriers keep the compiler from reordering around them. */
+#define cmark_atomic_load(p) (_ReadWriteBarrier(), *(p))
+#define cmark_atomic_store(p, v) (_ReadWriteBarrier(), *(p) = (v))
+
+#else
+
+#define cmark_atomic_inc(p) (++*(p))
+#define cmark_atomic_dec(p) (--*(p))
+#define cmark_atomic_load(p) (*(p))
+#define cmark_atomic_store(p, v) (*(p) = (v))
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef CMARK_CMARK_CLOCK_H
+#define CMARK_CMARK_CLOCK_H
+
+#include <stdint.h>
+
+#include "cmark.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Nanoseconds from a monotonic clock with an arbitrary origin, for
+ * timing the phases of a parse.
+ */
+static CMARK_INLINE uint64_t cmark_clock_ns(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER now;
+
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&now);
+  return (uint64_t)(now.QuadPart / frequency.QuadPart) * 1000000000u +
+         (uint64_t)(now.QuadPart % frequency.QuadPart) * 1000000000u /
+             (uint64_t)frequency.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/** Add a run of 'phase' from 'start' to 'end' to 'profile'.
+ */
+static CMARK_INLINE void cmark_profile_add(cmark_profile *profile,
+                                           cmark_phase phase, uint64_t start,
+                                           uint64_t end) {
+  cmark_phase_timing *timing = &profile->phases[phase];
+
+  if (timing->count == 0)
+    timing->first_start_ns = start;
+  timing->last_end_ns = end;
+  timing->total_ns += end - start;
+  timing->count++;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
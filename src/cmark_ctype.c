@@ -42,3 +42,8 @@ int cmark_isalnum(char c) {
 int cmark_isdigit(char c) { return cmark_ctype_class[(uint8_t)c] == 3; }
 
 int cmark_isalpha(char c) { return cmark_ctype_class[(uint8_t)c] == 4; }
+
+/**
+ * Returns the lowercase of c if it is an ascii uppercase letter, c otherwise.
+ */
+int cmark_tolower(char c) { return c >= 'A' && c <= 'Z' ? c + 32 : c; }
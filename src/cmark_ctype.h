@@ -19,6 +19,8 @@ int cmark_isdigit(char c);
 
 int cmark_isalpha(char c);
 
+int cmark_tolower(char c);
+
 #ifdef __cplusplus
 }
 #endif
@@ -501,5 +501,6 @@ char *cmark_render_commonmark(cmark_node *root, int options, int width) {
     // a different meaning with OPT_HARDBREAKS
     width = 0;
   }
-  return cmark_render(root, options, width, outc, S_render_node);
+  return cmark_render(root, options, width, CMARK_PHASE_RENDER_COMMONMARK,
+                      outc, S_render_node);
 }
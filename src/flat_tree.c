@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmark.h"
+#include "node.h"
+#include "buffer.h"
+#include "chunk.h"
+
+/* The nodes of a frozen tree are ordinary cmark_nodes, so that the
+ * renderers and accessors work on them unchanged, but they are copied
+ * into one array in document order, and all their text into one string
+ * pool.  Every string in the pool is NUL-terminated and its chunk is
+ * marked as allocated, so that the accessors return it as it is rather
+ * than allocating a copy; nothing in the tree is freed on its own.
+ */
+struct cmark_flat_tree {
+  cmark_mem *mem;
+  uint32_t size;
+  cmark_node *nodes;
+  unsigned char *strings;
+  uint8_t *types;
+  uint32_t *parents;
+  uint32_t *first_children;
+  uint32_t *next_siblings;
+};
+
+// The node after 'node' in document order, within 'root'.
+static cmark_node *next_in_order(cmark_node *root, cmark_node *node,
+                                 size_t *depth) {
+  if (node->first_child != NULL) {
+    ++*depth;
+    return node->first_child;
+  }
+  while (node != root && node->next == NULL) {
+    node = node->parent;
+    --*depth;
+  }
+  return node == root ? NULL : node->next;
+}
+
+static unsigned char *copy_to_pool(unsigned char **pool,
+                                   const unsigned char *data, size_t len) {
+  unsigned char *copy = *pool;
+
+  if (len > 0)
+    memcpy(copy, data, len);
+  copy[len] = '\0';
+  *pool += len + 1;
+  return copy;
+}
+
+static uint32_t index_of(cmark_flat_tree *tree, cmark_node *node) {
+  return node ? (uint32_t)(node - tree->nodes) : CMARK_FLAT_NONE;
+}
+
+cmark_flat_tree *cmark_node_freeze(cmark_node *root) {
+  cmark_mem *mem = cmark_node_mem(root);
+  cmark_flat_tree *tree;
+  cmark_node *node, **path;
+  cmark_chunk *chunks[2];
+  unsigned char *pool;
+  size_t n = 0, pool_size = 0, depth = 0, max_depth = 0, i;
+  int c;
+
+  // Count the nodes, their text and the depth of the tree.
+  for (node = root; node != NULL; node = next_in_order(root, node, &depth)) {
+    n++;
+    if (depth > max_depth)
+      max_depth = depth;
+    pool_size += (size_t)node->content.size + 1;
+    if (node->html_attrs)
+      pool_size += strlen(node->html_attrs) + 1;
+    cmark_node_chunks(node, &chunks[0], &chunks[1]);
+    for (c = 0; c < 2; c++) {
+      if (chunks[c])
+        pool_size += (size_t)chunks[c]->len + 1;
+    }
+  }
+  if (n >= CMARK_FLAT_NONE)
+    return NULL;
+
+  tree = (cmark_flat_tree *)mem->calloc(1, sizeof(*tree));
+  tree->mem = mem;
+  tree->size = (uint32_t)n;
+  tree->nodes = (cmark_node *)mem->calloc(n, sizeof(*tree->nodes));
+  tree->strings = (unsigned char *)mem->calloc(pool_size, 1);
+  tree->types = (uint8_t *)mem->calloc(n, sizeof(*tree->types));
+  tree->parents = (uint32_t *)mem->calloc(n, sizeof(*tree->parents));
+  tree->first_children =
+      (uint32_t *)mem->calloc(n, sizeof(*tree->first_children));
+  tree->next_siblings =
+      (uint32_t *)mem->calloc(n, sizeof(*tree->next_siblings));
+  path = (cmark_node **)mem->calloc(max_depth + 1, sizeof(*path));
+  pool = tree->strings;
+
+  for (node = root, i = 0; node != NULL;
+       node = next_in_order(root, node, &depth), i++) {
+    cmark_node *copy = &tree->nodes[i];
+    cmark_node *parent = depth ? path[depth - 1] : NULL;
+
+    *copy = *node;
+    copy->content.mem = mem;
+    copy->content.size = node->content.size;
+    copy->content.asize = 0;
+    copy->content.ptr = copy_to_pool(&pool, node->content.ptr,
+                                     (size_t)node->content.size);
+    if (node->html_attrs)
+      copy->html_attrs = (char *)copy_to_pool(
+          &pool, (unsigned char *)node->html_attrs, strlen(node->html_attrs));
+    copy->user_data_free_func = NULL;
+    if (copy->type == CMARK_NODE_DOCUMENT) {
+      copy->as.document.profile = NULL;
+      copy->as.document.refmap = NULL;
+    }
+
+    cmark_node_chunks(copy, &chunks[0], &chunks[1]);
+    for (c = 0; c < 2; c++) {
+      if (chunks[c] == NULL)
+        continue;
+      chunks[c]->data =
+          copy_to_pool(&pool, chunks[c]->data, (size_t)chunks[c]->len);
+      chunks[c]->alloc = 1;
+    }
+
+    copy->parent = parent;
+    copy->first_child = copy->last_child = NULL;
+    copy->next = NULL;
+    copy->prev = NULL;
+    if (parent != NULL) {
+      copy->prev = parent->last_child;
+      if (parent->last_child)
+        parent->last_child->next = copy;
+      else
+        parent->first_child = copy;
+      parent->last_child = copy;
+    }
+    path[depth] = copy;
+  }
+  mem->free(path);
+
+  for (i = 0; i < n; i++) {
+    tree->types[i] = (uint8_t)tree->nodes[i].type;
+    tree->parents[i] = index_of(tree, tree->nodes[i].parent);
+    tree->first_children[i] = index_of(tree, tree->nodes[i].first_child);
+    tree->next_siblings[i] = index_of(tree, tree->nodes[i].next);
+  }
+  return tree;
+}
+
+void cmark_flat_tree_free(cmark_flat_tree *tree) {
+  cmark_mem *mem;
+
+  if (tree == NULL)
+    return;
+  mem = tree->mem;
+  mem->free(tree->next_siblings);
+  mem->free(tree->first_children);
+  mem->free(tree->parents);
+  mem->free(tree->types);
+  mem->free(tree->strings);
+  mem->free(tree->nodes);
+  mem->free(tree);
+}
+
+uint32_t cmark_flat_tree_size(cmark_flat_tree *tree) { return tree->size; }
+
+const uint8_t *cmark_flat_tree_types(cmark_flat_tree *tree) {
+  return tree->types;
+}
+
+const uint32_t *cmark_flat_tree_parents(cmark_flat_tree *tree) {
+  return tree->parents;
+}
+
+const uint32_t *cmark_flat_tree_first_children(cmark_flat_tree *tree) {
+  return tree->first_children;
+}
+
+const uint32_t *cmark_flat_tree_next_siblings(cmark_flat_tree *tree) {
+  return tree->next_siblings;
+}
+
+cmark_node *cmark_flat_tree_node(cmark_flat_tree *tree, uint32_t index) {
+  return index < tree->size ? &tree->nodes[index] : NULL;
+}
+
+char *cmark_flat_tree_render_html(cmark_flat_tree *tree, int options) {
+  return cmark_render_html(tree->nodes, options);
+}
+
+char *cmark_flat_tree_render_commonmark(cmark_flat_tree *tree, int options,
+                                        int width) {
+  return cmark_render_commonmark(tree->nodes, options, width);
+}
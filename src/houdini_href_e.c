@@ -4,6 +4,11 @@
 
 #include "houdini.h"
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define HOUDINI_USE_SSE2
+#endif
+
 /*
  * The following characters will not be escaped:
  *
@@ -43,17 +48,71 @@ static const char HREF_SAFE[] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 };
 
+/* Return the index of the first byte at or after 'i' that is not in
+ * HREF_SAFE, or 'size' if there is none.
+ */
+static CMARK_INLINE bufsize_t S_skip_safe(const uint8_t *src, bufsize_t i,
+                                          bufsize_t size) {
+#ifdef HOUDINI_USE_SSE2
+  /* HREF_SAFE is the printable ASCII range '!'..'}' minus a handful of
+   * single characters and the '['..'^' and '{'..'}' runs.  Bytes >= 0x80
+   * compare as negative, so the signed range check rejects them too.
+   */
+  const __m128i below = _mm_set1_epi8(' ' + 1);
+  const __m128i above_z = _mm_set1_epi8('z');
+  const __m128i above_Z = _mm_set1_epi8('Z');
+  const __m128i below_caret = _mm_set1_epi8('^' + 1);
+  const __m128i quot = _mm_set1_epi8('"');
+  const __m128i amp = _mm_set1_epi8('&');
+  const __m128i apos = _mm_set1_epi8('\'');
+  const __m128i lt = _mm_set1_epi8('<');
+  const __m128i gt = _mm_set1_epi8('>');
+  const __m128i grave = _mm_set1_epi8('`');
+
+  while (size - i >= 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i unsafe = _mm_or_si128(
+        _mm_cmplt_epi8(chunk, below),
+        _mm_or_si128(_mm_cmpgt_epi8(chunk, above_z),
+                     _mm_and_si128(_mm_cmpgt_epi8(chunk, above_Z),
+                                   _mm_cmplt_epi8(chunk, below_caret))));
+    int mask;
+
+    unsafe = _mm_or_si128(
+        unsafe,
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quot),
+                         _mm_cmpeq_epi8(chunk, amp)),
+            _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, apos),
+                             _mm_cmpeq_epi8(chunk, grave)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, lt),
+                             _mm_cmpeq_epi8(chunk, gt)))));
+
+    mask = _mm_movemask_epi8(unsafe);
+    if (mask)
+      return i + __builtin_ctz((unsigned int)mask);
+
+    i += 16;
+  }
+#endif
+
+  while (i < size && HREF_SAFE[src[i]] != 0)
+    i++;
+
+  return i;
+}
+
 int houdini_escape_href(cmark_strbuf *ob, const uint8_t *src, bufsize_t size) {
   static const uint8_t hex_chars[] = "0123456789ABCDEF";
-  bufsize_t i = 0, org;
-  uint8_t hex_str[3];
-
-  hex_str[0] = '%';
+  bufsize_t i = 0, org, n;
+  /* %XX escapes are collected here and appended in batches, since runs
+   * of them (non-ASCII paths, spaces) are common. */
+  uint8_t hex_str[3 * 32];
 
   while (i < size) {
     org = i;
-    while (i < size && HREF_SAFE[src[i]] != 0)
-      i++;
+    i = S_skip_safe(src, i, size);
 
     if (likely(i > org))
       cmark_strbuf_put(ob, src + org, i - org);
@@ -66,14 +125,16 @@ int houdini_escape_href(cmark_strbuf *ob, const uint8_t *src, bufsize_t size) {
     /* amp appears all the time in URLs, but needs
      * HTML-entity escaping to be inside an href */
     case '&':
-      cmark_strbuf_puts(ob, "&amp;");
+      cmark_strbuf_put(ob, (const unsigned char *)"&amp;", 5);
+      i++;
       break;
 
     /* the single quote is a valid URL character
      * according to the standard; it needs HTML
      * entity escaping too */
     case '\'':
-      cmark_strbuf_puts(ob, "&#x27;");
+      cmark_strbuf_put(ob, (const unsigned char *)"&#x27;", 6);
+      i++;
       break;
 
 /* the space can be escaped to %20 or a plus
@@ -88,12 +149,16 @@ int houdini_escape_href(cmark_strbuf *ob, const uint8_t *src, bufsize_t size) {
 
     /* every other character goes with a %XX escaping */
     default:
-      hex_str[1] = hex_chars[(src[i] >> 4) & 0xF];
-      hex_str[2] = hex_chars[src[i] & 0xF];
-      cmark_strbuf_put(ob, hex_str, 3);
+      n = 0;
+      do {
+        hex_str[n++] = '%';
+        hex_str[n++] = hex_chars[(src[i] >> 4) & 0xF];
+        hex_str[n++] = hex_chars[src[i] & 0xF];
+        i++;
+      } while (i < size && n < (bufsize_t)sizeof(hex_str) &&
+               HREF_SAFE[src[i]] == 0 && src[i] != '&' && src[i] != '\'');
+      cmark_strbuf_put(ob, hex_str, n);
     }
-
-    i++;
   }
 
   return 1;
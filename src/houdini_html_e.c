@@ -4,6 +4,11 @@
 
 #include "houdini.h"
 
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define HOUDINI_USE_SSE2
+#endif
+
 /**
  * According to the OWASP rules:
  *
@@ -32,14 +37,58 @@ static const char HTML_ESCAPE_TABLE[] = {
 static const char *HTML_ESCAPES[] = {"",      "&quot;", "&amp;", "&#39;",
                                      "&#47;", "&lt;",   "&gt;"};
 
+static const bufsize_t HTML_ESCAPES_LEN[] = {0, 6, 5, 5, 5, 4, 4};
+
+/* Return the index of the first byte at or after 'i' that has to be
+ * escaped, or 'size' if there is none.  The single quote and the forward
+ * slash are only escaped in secure mode.
+ */
+static CMARK_INLINE bufsize_t S_skip_unescaped(const uint8_t *src, bufsize_t i,
+                                               bufsize_t size, int secure) {
+#ifdef HOUDINI_USE_SSE2
+  const __m128i quot = _mm_set1_epi8('"');
+  const __m128i amp = _mm_set1_epi8('&');
+  const __m128i lt = _mm_set1_epi8('<');
+  const __m128i gt = _mm_set1_epi8('>');
+  const __m128i apos = _mm_set1_epi8('\'');
+  const __m128i slash = _mm_set1_epi8('/');
+
+  while (size - i >= 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)(src + i));
+    __m128i hits = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quot), _mm_cmpeq_epi8(chunk, amp)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, gt)));
+    int mask;
+
+    if (secure)
+      hits = _mm_or_si128(hits, _mm_or_si128(_mm_cmpeq_epi8(chunk, apos),
+                                             _mm_cmpeq_epi8(chunk, slash)));
+
+    mask = _mm_movemask_epi8(hits);
+    if (mask)
+      return i + __builtin_ctz((unsigned int)mask);
+
+    i += 16;
+  }
+#endif
+
+  while (i < size) {
+    if (HTML_ESCAPE_TABLE[src[i]] &&
+        (secure || (src[i] != '/' && src[i] != '\'')))
+      break;
+    i++;
+  }
+
+  return i;
+}
+
 int houdini_escape_html0(cmark_strbuf *ob, const uint8_t *src, bufsize_t size,
                          int secure) {
-  bufsize_t i = 0, org, esc = 0;
+  bufsize_t i = 0, org, esc;
 
   while (i < size) {
     org = i;
-    while (i < size && (esc = HTML_ESCAPE_TABLE[src[i]]) == 0)
-      i++;
+    i = S_skip_unescaped(src, i, size, secure);
 
     if (i > org)
       cmark_strbuf_put(ob, src + org, i - org);
@@ -48,12 +97,9 @@ int houdini_escape_html0(cmark_strbuf *ob, const uint8_t *src, bufsize_t size,
     if (unlikely(i >= size))
       break;
 
-    /* The forward slash is only escaped in secure mode */
-    if ((src[i] == '/' || src[i] == '\'') && !secure) {
-      cmark_strbuf_putc(ob, src[i]);
-    } else {
-      cmark_strbuf_puts(ob, HTML_ESCAPES[esc]);
-    }
+    esc = HTML_ESCAPE_TABLE[src[i]];
+    cmark_strbuf_put(ob, (const unsigned char *)HTML_ESCAPES[esc],
+                     HTML_ESCAPES_LEN[esc]);
 
     i++;
   }
@@ -7,32 +7,39 @@
 #include "utf8.h"
 #include "entities.inc"
 
-/* Binary tree lookup code for entities added by JGM */
-
-static const unsigned char *S_lookup(int i, int low, int hi,
-                                     const unsigned char *s, int len) {
-  int j;
-  int cmp =
-      strncmp((const char *)s, (const char *)cmark_entities[i].entity, len);
-  if (cmp == 0 && cmark_entities[i].entity[len] == 0) {
-    return (const unsigned char *)cmark_entities[i].bytes;
-  } else if (cmp <= 0 && i > low) {
-    j = i - ((i - low) / 2);
-    if (j == i)
-      j -= 1;
-    return S_lookup(j, low, i - 1, s, len);
-  } else if (cmp > 0 && i < hi) {
-    j = i + ((hi - i) / 2);
-    if (j == i)
-      j += 1;
-    return S_lookup(j, i + 1, hi, s, len);
-  } else {
-    return NULL;
-  }
+/* Entities are found through a minimal perfect hash generated by
+ * tools/make_entities_inc.py: the first hash selects a displacement,
+ * which either is the table index itself (negative values) or seeds a
+ * second hash giving the index.  A single comparison then confirms the
+ * match.  S_entity_hash must be kept in sync with the generator.
+ */
+static CMARK_INLINE uint32_t S_entity_hash(uint32_t seed,
+                                           const unsigned char *s, int len) {
+  uint32_t h = seed ? seed : 0x01000193;
+  int i;
+
+  for (i = 0; i < len; i++)
+    h = (h * 0x01000193) ^ s[i];
+
+  return h;
 }
 
 static const unsigned char *S_lookup_entity(const unsigned char *s, int len) {
-  return S_lookup(CMARK_NUM_ENTITIES / 2, 0, CMARK_NUM_ENTITIES - 1, s, len);
+  int d = cmark_entity_displacements[S_entity_hash(0, s, len) %
+                                     CMARK_NUM_ENTITIES];
+  const struct cmark_entity_node *node;
+
+  if (d < 0)
+    node = &cmark_entities[-d - 1];
+  else
+    node = &cmark_entities[S_entity_hash((uint32_t)d, s, len) %
+                           CMARK_NUM_ENTITIES];
+
+  if (strncmp((const char *)s, (const char *)node->entity, len) == 0 &&
+      node->entity[len] == 0)
+    return (const unsigned char *)node->bytes;
+
+  return NULL;
 }
 
 bufsize_t houdini_unescape_ent(cmark_strbuf *ob, const uint8_t *src,
@@ -8,8 +8,9 @@
 #include "buffer.h"
 #include "houdini.h"
 #include "scanners.h"
-
-#define BUFFER_SIZE 100
+#include "cmark_clock.h"
+#include "work.h"
+#include "probes.h"
 
 // Functions to convert cmark_nodes to HTML strings.
 
@@ -32,12 +33,16 @@ struct render_state {
 
 static void S_render_sourcepos(cmark_node *node, cmark_strbuf *html,
                                int options) {
-  char buffer[BUFFER_SIZE];
   if (CMARK_OPT_SOURCEPOS & options) {
-    snprintf(buffer, BUFFER_SIZE, " data-sourcepos=\"%d:%d-%d:%d\"",
-             cmark_node_get_start_line(node), cmark_node_get_start_column(node),
-             cmark_node_get_end_line(node), cmark_node_get_end_column(node));
-    cmark_strbuf_puts(html, buffer);
+    cmark_strbuf_puts(html, " data-sourcepos=\"");
+    cmark_strbuf_put_int(html, node->start_line);
+    cmark_strbuf_putc(html, ':');
+    cmark_strbuf_put_int(html, node->start_column);
+    cmark_strbuf_putc(html, '-');
+    cmark_strbuf_put_int(html, node->end_line);
+    cmark_strbuf_putc(html, ':');
+    cmark_strbuf_put_int(html, node->end_column);
+    cmark_strbuf_putc(html, '"');
   }
 }
 
@@ -46,10 +51,7 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
   cmark_node *parent;
   cmark_node *grandparent;
   cmark_strbuf *html = state->html;
-  char start_heading[] = "<h0";
-  char end_heading[] = "</h0";
   bool tight;
-  char buffer[BUFFER_SIZE];
 
   bool entering = (ev_type == CMARK_EVENT_ENTER);
 
@@ -107,8 +109,9 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
         S_render_sourcepos(node, html, options);
         cmark_strbuf_puts(html, ">\n");
       } else {
-        snprintf(buffer, BUFFER_SIZE, "<ol start=\"%d\"", start);
-        cmark_strbuf_puts(html, buffer);
+        cmark_strbuf_puts(html, "<ol start=\"");
+        cmark_strbuf_put_int(html, start);
+        cmark_strbuf_putc(html, '"');
         S_render_sourcepos(node, html, options);
         cmark_strbuf_puts(html, ">\n");
       }
@@ -133,13 +136,13 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
   case CMARK_NODE_HEADING:
     if (entering) {
       cr(html);
-      start_heading[2] = (char)('0' + node->as.heading.level);
-      cmark_strbuf_puts(html, start_heading);
+      cmark_strbuf_puts(html, "<h");
+      cmark_strbuf_put_int(html, node->as.heading.level);
       S_render_sourcepos(node, html, options);
       cmark_strbuf_putc(html, '>');
     } else {
-      end_heading[3] = (char)('0' + node->as.heading.level);
-      cmark_strbuf_puts(html, end_heading);
+      cmark_strbuf_puts(html, "</h");
+      cmark_strbuf_put_int(html, node->as.heading.level);
       cmark_strbuf_puts(html, ">\n");
     }
     break;
@@ -401,14 +404,22 @@ char *cmark_render_html(cmark_node *root, int options) {
   cmark_event_type ev_type;
   cmark_node *cur;
   struct render_state state = {&html, NULL, false, false};
+  cmark_profile *profile = cmark_node_profile(root);
+  uint64_t start = profile ? cmark_clock_ns() : 0;
   cmark_iter *iter = cmark_iter_new(root);
 
+  CMARK_PROBE1(render__start, CMARK_PHASE_RENDER_HTML);
   while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
     cur = cmark_iter_get_node(iter);
     S_render_node(cur, ev_type, &state, options);
   }
+  CMARK_PROBE2(render__done, CMARK_PHASE_RENDER_HTML, html.size);
+  CMARK_COUNT_WORK_UNITS(output_bytes, html.size);
   result = (char *)cmark_strbuf_detach(&html);
 
   cmark_iter_free(iter);
+  if (profile)
+    cmark_profile_add(profile, CMARK_PHASE_RENDER_HTML, start,
+                      cmark_clock_ns());
   return result;
 }
@@ -11,6 +11,10 @@
 #include "utf8.h"
 #include "scanners.h"
 #include "inlines.h"
+#include "stats.h"
+#include "cmark_clock.h"
+#include "work.h"
+#include "probes.h"
 
 static const char *EMDASH = "\xE2\x80\x94";
 static const char *ENDASH = "\xE2\x80\x93";
@@ -24,10 +28,10 @@ static const char *RIGHTSINGLEQUOTE = "\xE2\x80\x99";
 #define make_str(subj, sc, ec, s) make_literal(subj, CMARK_NODE_TEXT, sc, ec, s)
 #define make_code(subj, sc, ec, s) make_literal(subj, CMARK_NODE_CODE, sc, ec, s)
 #define make_raw_html(subj, sc, ec, s) make_literal(subj, CMARK_NODE_HTML_INLINE, sc, ec, s)
-#define make_linebreak(mem) make_simple(mem, CMARK_NODE_LINEBREAK)
-#define make_softbreak(mem) make_simple(mem, CMARK_NODE_SOFTBREAK)
-#define make_emph(mem) make_simple(mem, CMARK_NODE_EMPH)
-#define make_strong(mem) make_simple(mem, CMARK_NODE_STRONG)
+#define make_linebreak(subj) make_simple(subj, CMARK_NODE_LINEBREAK)
+#define make_softbreak(subj) make_simple(subj, CMARK_NODE_SOFTBREAK)
+#define make_emph(subj) make_simple(subj, CMARK_NODE_EMPH)
+#define make_strong(subj) make_simple(subj, CMARK_NODE_STRONG)
 
 #define MAXBACKTICKS 1000
 
@@ -53,6 +57,9 @@ typedef struct subject {
   bracket *last_bracket;
   bufsize_t backticks[MAXBACKTICKS + 1];
   bool scanned_for_backticks;
+  size_t num_delims;
+  size_t max_delims;
+  size_t nodes; /* created and not yet counted in parser->num_nodes */
 } subject;
 
 static CMARK_INLINE bool S_is_line_end_char(char c) {
@@ -66,14 +73,18 @@ static int parse_inline(cmark_parser *parser, subject *subj, cmark_node *parent,
 
 static void subject_from_buf(cmark_mem *mem, int line_number, int block_offset, subject *e,
                              cmark_chunk *chunk, cmark_reference_map *refmap);
-static bufsize_t subject_find_special_char(subject *subj, int options);
+static bufsize_t subject_find_special_char(cmark_parser *parser, subject *subj,
+                                           int options);
 
 // Create an inline with a literal string value.
 static CMARK_INLINE cmark_node *make_literal(subject *subj, cmark_node_type t,
                                              int start_column, int end_column,
                                              cmark_chunk s) {
-  cmark_node *e = (cmark_node *)subj->mem->calloc(1, sizeof(*e));
+  cmark_node *e;
+  CMARK_ALLOC_NODE_SITE(subj->mem, t);
+  e = (cmark_node *)subj->mem->calloc(1, sizeof(*e));
   cmark_strbuf_init(subj->mem, &e->content, 0);
+  subj->nodes++;
   e->type = (uint16_t)t;
   e->as.literal = s;
   e->start_line = e->end_line = subj->line;
@@ -84,9 +95,12 @@ static CMARK_INLINE cmark_node *make_literal(subject *subj, cmark_node_type t,
 }
 
 // Create an inline with no value.
-static CMARK_INLINE cmark_node *make_simple(cmark_mem *mem, cmark_node_type t) {
-  cmark_node *e = (cmark_node *)mem->calloc(1, sizeof(*e));
-  cmark_strbuf_init(mem, &e->content, 0);
+static CMARK_INLINE cmark_node *make_simple(subject *subj, cmark_node_type t) {
+  cmark_node *e;
+  CMARK_ALLOC_NODE_SITE(subj->mem, t);
+  e = (cmark_node *)subj->mem->calloc(1, sizeof(*e));
+  cmark_strbuf_init(subj->mem, &e->content, 0);
+  subj->nodes++;
   e->type = t;
   return e;
 }
@@ -111,6 +125,7 @@ static cmark_chunk chunk_clone(cmark_mem *mem, cmark_chunk *src) {
   bufsize_t len = src->len;
 
   c.len = len;
+  CMARK_ALLOC_SITE(mem, CMARK_ALLOC_CHUNK_COPY);
   c.data = (unsigned char *)mem->calloc(len + 1, 1);
   c.alloc = 1;
   if (len)
@@ -141,7 +156,7 @@ static cmark_chunk cmark_clean_autolink(cmark_mem *mem, cmark_chunk *url,
 static CMARK_INLINE cmark_node *make_autolink(subject *subj,
                                               int start_column, int end_column,
                                               cmark_chunk url, int is_email) {
-  cmark_node *link = make_simple(subj->mem, CMARK_NODE_LINK);
+  cmark_node *link = make_simple(subj, CMARK_NODE_LINK);
   link->as.link.url = cmark_clean_autolink(subj->mem, &url, is_email);
   link->as.link.title = cmark_chunk_literal("");
   link->start_line = link->end_line = subj->line;
@@ -167,6 +182,9 @@ static void subject_from_buf(cmark_mem *mem, int line_number, int block_offset,
     e->backticks[i] = 0;
   }
   e->scanned_for_backticks = false;
+  e->num_delims = 0;
+  e->max_delims = 0;
+  e->nodes = 0;
 }
 
 static CMARK_INLINE int isbacktick(int c) { return (c == '`'); }
@@ -429,6 +447,7 @@ static void remove_delimiter(subject *subj, delimiter *delim) {
   if (delim->previous != NULL) {
     delim->previous->next = delim->next;
   }
+  subj->num_delims--;
   subj->mem->free(delim);
 }
 
@@ -443,7 +462,9 @@ static void pop_bracket(subject *subj) {
 
 static void push_delimiter(subject *subj, unsigned char c, bool can_open,
                            bool can_close, cmark_node *inl_text) {
-  delimiter *delim = (delimiter *)subj->mem->calloc(1, sizeof(delimiter));
+  delimiter *delim;
+  CMARK_ALLOC_SITE(subj->mem, CMARK_ALLOC_DELIMITER);
+  delim = (delimiter *)subj->mem->calloc(1, sizeof(delimiter));
   delim->delim_char = c;
   delim->can_open = can_open;
   delim->can_close = can_close;
@@ -455,10 +476,14 @@ static void push_delimiter(subject *subj, unsigned char c, bool can_open,
     delim->previous->next = delim;
   }
   subj->last_delim = delim;
+  if (++subj->num_delims > subj->max_delims)
+    subj->max_delims = subj->num_delims;
 }
 
 static void push_bracket(subject *subj, bool image, cmark_node *inl_text) {
-  bracket *b = (bracket *)subj->mem->calloc(1, sizeof(bracket));
+  bracket *b;
+  CMARK_ALLOC_SITE(subj->mem, CMARK_ALLOC_DELIMITER);
+  b = (bracket *)subj->mem->calloc(1, sizeof(bracket));
   if (subj->last_bracket != NULL) {
     subj->last_bracket->bracket_after = true;
   }
@@ -574,18 +599,18 @@ static void add_extensions_openers_bottom(cmark_parser *parser,
 }
 
 static cmark_syntax_extension *get_extension_for_special_char(cmark_parser *parser, unsigned char c) {
-  cmark_llist *tmp_ext;
+  cmark_llist *tmp;
 
-  for (tmp_ext = parser->inline_syntax_extensions; tmp_ext; tmp_ext=tmp_ext->next) {
-    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp_ext->data;
-    cmark_llist *tmp_char;
-    for (tmp_char = ext->special_inline_chars; tmp_char; tmp_char=tmp_char->next) {
-      unsigned char tmp_c = (unsigned char) (unsigned long) tmp_char->data;
+  if (parser->inline_dispatch == NULL)
+    return NULL;
 
-      if (tmp_c == c) {
-        return ext;
-      }
-    }
+  // Extensions that listed no characters are on every list, but own no
+  // delimiters.
+  for (tmp = parser->inline_dispatch[c]; tmp; tmp = tmp->next) {
+    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
+
+    if (ext->special_inline_chars)
+      return ext;
   }
 
   return NULL;
@@ -600,6 +625,8 @@ static void process_emphasis(cmark_parser *parser, subject *subj, delimiter *sta
   delimiter *openers_bottom[3][128];
   int i;
 
+  CMARK_PROBE1(emphasis__start, subj->line);
+
   // initialize openers_bottom:
   for (i=0; i < 3; i++) {
     openers_bottom[i]['*'] = stack_bottom;
@@ -609,13 +636,22 @@ static void process_emphasis(cmark_parser *parser, subject *subj, delimiter *sta
     add_extensions_openers_bottom(parser, openers_bottom[i], stack_bottom);
   }
 
-  // move back to first relevant delim.
+  // move back to first relevant delim.  If there is none above
+  // stack_bottom, don't walk past it to the bottom of the whole stack.
+  if (closer == stack_bottom)
+    closer = NULL;
   while (closer != NULL && closer->previous != stack_bottom) {
+    CMARK_COUNT_WORK_UNITS(delimiter_steps, 1);
     closer = closer->previous;
   }
 
   // now move forward, looking for closers, and handling each
   while (closer != NULL) {
+    parser->num_delimiter_steps++;
+    CMARK_COUNT_WORK_UNITS(delimiter_steps, 1);
+    if (parser->has_limits && cmark_parser_check_limits(parser))
+      break;
+
     cmark_syntax_extension *extension = get_extension_for_special_char(parser, closer->delim_char);
     if (closer->can_close &&
         (extension != NULL ||
@@ -627,6 +663,8 @@ static void process_emphasis(cmark_parser *parser, subject *subj, delimiter *sta
       odd_match = false;
       while (opener != NULL && opener != stack_bottom &&
              opener != openers_bottom[closer->length % 3][closer->delim_char]) {
+        parser->num_delimiter_steps++;
+        CMARK_COUNT_WORK_UNITS(delimiter_steps, 1);
 	      if (opener->can_open && opener->delim_char == closer->delim_char) {
           // interior closer of size 2 can't match opener of size 1
           // or of size 1 can't match 2
@@ -688,6 +726,7 @@ static void process_emphasis(cmark_parser *parser, subject *subj, delimiter *sta
   while (subj->last_delim != NULL && subj->last_delim != stack_bottom) {
     remove_delimiter(subj, subj->last_delim);
   }
+  CMARK_PROBE2(emphasis__done, subj->line, parser->num_delimiter_steps);
 }
 
 static delimiter *S_insert_emph(subject *subj, delimiter *opener,
@@ -719,7 +758,7 @@ static delimiter *S_insert_emph(subject *subj, delimiter *opener,
 
   // create new emph or strong, and splice it in to our inlines
   // between the opener and closer
-  emph = use_delims == 1 ? make_emph(subj->mem) : make_strong(subj->mem);
+  emph = use_delims == 1 ? make_emph(subj) : make_strong(subj);
 
   tmp = opener_inl->next;
   while (tmp && tmp != closer_inl) {
@@ -761,7 +800,7 @@ static cmark_node *handle_backslash(subject *subj) {
     advance(subj);
     return make_str(subj, subj->pos - 2, subj->pos - 1, cmark_chunk_dup(&subj->input, subj->pos - 1, 1));
   } else if (!is_eof(subj) && skip_line_end(subj)) {
-    return make_linebreak(subj->mem);
+    return make_linebreak(subj);
   } else {
     return make_str(subj, subj->pos - 1, subj->pos - 1, cmark_chunk_literal("\\"));
   }
@@ -1065,11 +1104,17 @@ static cmark_node *handle_close_bracket(cmark_parser *parser, subject *subj) {
     cmark_chunk_free(subj->mem, &raw_label);
     raw_label = cmark_chunk_dup(&subj->input, opener->position,
                                 initial_pos - opener->position - 1);
+    CMARK_COUNT_WORK_UNITS(bracket_steps, raw_label.len);
     found_label = true;
   }
 
   if (found_label) {
+    cmark_profile *profile = cmark_parser_profile(parser);
+    uint64_t start = profile ? cmark_clock_ns() : 0;
     ref = cmark_reference_lookup(subj->refmap, &raw_label);
+    if (profile)
+      cmark_profile_add(profile, CMARK_PHASE_REFERENCES, start,
+                        cmark_clock_ns());
     cmark_chunk_free(subj->mem, &raw_label);
   }
 
@@ -1088,7 +1133,7 @@ noMatch:
   return make_str(subj, subj->pos - 1, subj->pos - 1, cmark_chunk_literal("]"));
 
 match:
-  inl = make_simple(subj->mem, is_image ? CMARK_NODE_IMAGE : CMARK_NODE_LINK);
+  inl = make_simple(subj, is_image ? CMARK_NODE_IMAGE : CMARK_NODE_LINK);
   inl->as.link.url = url;
   inl->as.link.title = title;
   inl->start_line = inl->end_line = subj->line;
@@ -1098,6 +1143,7 @@ match:
   // Add link text:
   tmp = opener->inl_text->next;
   while (tmp) {
+    CMARK_COUNT_WORK_UNITS(bracket_steps, 1);
     tmpnext = tmp->next;
     cmark_node_append_child(inl, tmp);
     tmp = tmpnext;
@@ -1115,6 +1161,7 @@ match:
   if (!is_image) {
     opener = subj->last_bracket;
     while (opener != NULL) {
+      CMARK_COUNT_WORK_UNITS(bracket_steps, 1);
       if (!opener->image) {
         if (!opener->active) {
           break;
@@ -1146,14 +1193,14 @@ static cmark_node *handle_newline(subject *subj) {
   skip_spaces(subj);
   if (nlpos > 1 && peek_at(subj, nlpos - 1) == ' ' &&
       peek_at(subj, nlpos - 2) == ' ') {
-    return make_linebreak(subj->mem);
+    return make_linebreak(subj);
   } else {
-    return make_softbreak(subj->mem);
+    return make_softbreak(subj);
   }
 }
 
 // "\r\n\\`&_*[]<!"
-static int8_t SPECIAL_CHARS[256] = {
+static const int8_t SPECIAL_CHARS[256] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -1167,7 +1214,7 @@ static int8_t SPECIAL_CHARS[256] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 
 // " ' . -
-static char SMART_PUNCT_CHARS[] = {
+static const char SMART_PUNCT_CHARS[] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -1181,11 +1228,12 @@ static char SMART_PUNCT_CHARS[] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-static bufsize_t subject_find_special_char(subject *subj, int options) {
+static bufsize_t subject_find_special_char(cmark_parser *parser, subject *subj,
+                                           int options) {
   bufsize_t n = subj->pos + 1;
 
   while (n < subj->input.len) {
-    if (SPECIAL_CHARS[subj->input.data[n]])
+    if (parser->special_chars[subj->input.data[n]])
       return n;
     if (options & CMARK_OPT_SMART && SMART_PUNCT_CHARS[subj->input.data[n]])
       return n;
@@ -1195,12 +1243,24 @@ static bufsize_t subject_find_special_char(subject *subj, int options) {
   return subj->input.len;
 }
 
-void cmark_inlines_add_special_character(unsigned char c) {
-  SPECIAL_CHARS[c] = 1;
-}
+// Rebuild the parser's own copy of SPECIAL_CHARS from its inline
+// extensions.  Keeping this per parser (rather than toggling the static
+// table around each parse) lets several parsers run concurrently.
+void cmark_inlines_init_special_chars(cmark_parser *parser) {
+  cmark_llist *tmp_ext;
 
-void cmark_inlines_remove_special_character(unsigned char c) {
-  SPECIAL_CHARS[c] = 0;
+  memcpy(parser->special_chars, SPECIAL_CHARS, sizeof(SPECIAL_CHARS));
+
+  for (tmp_ext = parser->inline_syntax_extensions; tmp_ext;
+       tmp_ext = tmp_ext->next) {
+    cmark_syntax_extension *ext = (cmark_syntax_extension *)tmp_ext->data;
+    cmark_llist *tmp_char;
+    for (tmp_char = ext->special_inline_chars; tmp_char;
+         tmp_char = tmp_char->next) {
+      unsigned char c = (unsigned char)(unsigned long)tmp_char->data;
+      parser->special_chars[c] = 1;
+    }
+  }
 }
 
 static cmark_node *try_extensions(cmark_parser *parser,
@@ -1210,7 +1270,10 @@ static cmark_node *try_extensions(cmark_parser *parser,
   cmark_node *res = NULL;
   cmark_llist *tmp;
 
-  for (tmp = parser->inline_syntax_extensions; tmp; tmp = tmp->next) {
+  if (parser->inline_dispatch == NULL)
+    return NULL;
+
+  for (tmp = parser->inline_dispatch[c]; tmp; tmp = tmp->next) {
     cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
 
     res = ext->match_inline(ext, parser, parent, c, subj);
@@ -1233,6 +1296,7 @@ static int parse_inline(cmark_parser *parser, subject *subj, cmark_node *parent,
   if (c == 0) {
     return 0;
   }
+  CMARK_PROBE3(inline__start, c, subj->pos, subj->line);
   switch (c) {
   case '\r':
   case '\n':
@@ -1285,7 +1349,7 @@ static int parse_inline(cmark_parser *parser, subject *subj, cmark_node *parent,
     if (new_inl != NULL)
       break;
 
-    endpos = subject_find_special_char(subj, options);
+    endpos = subject_find_special_char(parser, subj, options);
     contents = cmark_chunk_dup(&subj->input, subj->pos, endpos - subj->pos);
     startpos = subj->pos;
     subj->pos = endpos;
@@ -1300,6 +1364,7 @@ static int parse_inline(cmark_parser *parser, subject *subj, cmark_node *parent,
   if (new_inl != NULL) {
     cmark_node_append_child(parent, new_inl);
   }
+  CMARK_PROBE3(inline__done, c, subj->pos, subj->line);
 
   return 1;
 }
@@ -1314,10 +1379,28 @@ extern void cmark_parse_inlines(cmark_parser *parser,
   subject_from_buf(parser->mem, parent->start_line, parent->start_column - 1 + parent->internal_offset, &subj, &content, refmap);
   cmark_chunk_rtrim(&subj.input);
 
-  while (!is_eof(&subj) && parse_inline(parser, &subj, parent, options))
-    ;
+  while (!parser->error && !is_eof(&subj) &&
+         parse_inline(parser, &subj, parent, options)) {
+    if (parser->has_limits) {
+      parser->num_nodes += subj.nodes;
+      subj.nodes = 0;
+      cmark_parser_check_limits(parser);
+    }
+  }
+
+  // Once a limit has been hit, the rest of the text is kept unparsed.
+  if (parser->error && !is_eof(&subj)) {
+    cmark_chunk rest =
+        cmark_chunk_dup(&subj.input, subj.pos, subj.input.len - subj.pos);
+    cmark_node_append_child(
+        parent, make_str(&subj, subj.pos, subj.input.len - 1, rest));
+  }
+  parser->num_nodes += subj.nodes;
 
-  process_emphasis(parser, &subj, NULL);
+  if (!parser->error)
+    process_emphasis(parser, &subj, NULL);
+  if (parser->stats)
+    cmark_stats_note_delimiters(parser->stats, subj.max_delims);
   // free bracket and delim stack
   while (subj.last_delim) {
     remove_delimiter(&subj, subj.last_delim);
@@ -16,8 +16,7 @@ void cmark_parse_inlines(cmark_parser *parser,
 bufsize_t cmark_parse_reference_inline(cmark_mem *mem, cmark_chunk *input,
                                        cmark_reference_map *refmap);
 
-void cmark_inlines_add_special_character(unsigned char c);
-void cmark_inlines_remove_special_character(unsigned char c);
+void cmark_inlines_init_special_chars(cmark_parser *parser);
 
 #ifdef __cplusplus
 }
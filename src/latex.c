@@ -495,5 +495,5 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 }
 
 char *cmark_render_latex(cmark_node *root, int options, int width) {
-  return cmark_render(root, options, width, outc, S_render_node);
+  return cmark_render(root, options, width, CMARK_PHASE_RENDER_LATEX, outc, S_render_node);
 }
@@ -5,11 +5,23 @@
 #include "memory.h"
 #include "cmark.h"
 #include "node.h"
+#include "parser.h"
 #include "registry.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
 #if defined(_WIN32) && !defined(__CYGWIN__)
 #include <io.h>
 #include <fcntl.h>
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
 #endif
 
 typedef enum {
@@ -34,35 +46,133 @@ void print_usage() {
   printf("  --smart          Use smart punctuation\n");
   printf("  --validate-utf8  Replace UTF-8 invalid sequences with U+FFFD\n");
   printf("  -e, --extension EXTENSION_NAME Specify an extension name to use\n");
+  printf("  --batch          Convert each FILE separately into the output "
+         "directory\n");
+  printf("  -o, --output DIR Output directory for --batch\n");
+  printf("  -j, --jobs N     Number of worker threads for --batch "
+         "(default: one per CPU)\n");
+  printf("                   or --serve (default: 1)\n");
+  printf("  --serve          Convert a stream of framed requests on stdin\n");
+  printf("  --max-bytes N    Stop parsing a document after it allocates N "
+         "bytes\n");
+  printf("  --max-nodes N    Stop parsing a document after it creates N "
+         "nodes\n");
+  printf("  --max-depth N    Stop parsing a document at a block nested more "
+         "than N\n");
+  printf("                   levels deep, and drop deeper inlines\n");
+  printf("  --max-delimiters N\n");
+  printf("                   Stop parsing a document after examining N "
+         "emphasis delimiters\n");
   printf("  --list-extensions              List available extensions and quit\n");
   printf("  --help, -h       Print usage information\n");
   printf("  --version        Print version\n");
 }
 
-static bool print_document(cmark_node *document, writer_format writer,
-                           int options, int width) {
-  char *result;
+// Returns the CMARK_OPT_* flag for a boolean command-line option, or 0.
+static int option_flag(const char *arg) {
+  if (strcmp(arg, "--sourcepos") == 0)
+    return CMARK_OPT_SOURCEPOS;
+  if (strcmp(arg, "--hardbreaks") == 0)
+    return CMARK_OPT_HARDBREAKS;
+  if (strcmp(arg, "--nobreaks") == 0)
+    return CMARK_OPT_NOBREAKS;
+  if (strcmp(arg, "--smart") == 0)
+    return CMARK_OPT_SMART;
+  if (strcmp(arg, "--safe") == 0)
+    return CMARK_OPT_SAFE;
+  if (strcmp(arg, "--validate-utf8") == 0)
+    return CMARK_OPT_VALIDATE_UTF8;
+  return 0;
+}
+
+// Stores VALUE in the limit named by a --max-* option.  Returns false if
+// 'arg' is not such an option.
+static bool set_limit(cmark_parser_limits *limits, const char *arg,
+                      size_t value) {
+  if (strcmp(arg, "--max-bytes") == 0)
+    limits->max_bytes = value;
+  else if (strcmp(arg, "--max-nodes") == 0)
+    limits->max_nodes = value;
+  else if (strcmp(arg, "--max-depth") == 0)
+    limits->max_depth = value > INT32_MAX ? INT32_MAX : (int)value;
+  else if (strcmp(arg, "--max-delimiters") == 0)
+    limits->max_delimiters = value;
+  else
+    return false;
+  return true;
+}
+
+static const char *limit_name(cmark_parser_error error) {
+  switch (error) {
+  case CMARK_PARSER_ERROR_MEMORY_LIMIT:
+    return "bytes";
+  case CMARK_PARSER_ERROR_NODE_LIMIT:
+    return "nodes";
+  case CMARK_PARSER_ERROR_DEPTH_LIMIT:
+    return "depth";
+  case CMARK_PARSER_ERROR_DELIMITER_LIMIT:
+    return "delimiters";
+  default:
+    return "nothing";
+  }
+}
+
+// A parser for untrusted input.  Byte limits can only be enforced by the
+// instrumented allocator.
+static cmark_parser *new_limited_parser(int options,
+                                        const cmark_parser_limits *limits) {
+  cmark_parser *parser =
+      limits->max_bytes
+          ? cmark_parser_new_with_mem(options,
+                                      cmark_get_instrumented_mem_allocator())
+          : cmark_parser_new(options);
+
+  cmark_parser_set_limits(parser, limits);
+  return parser;
+}
 
+static bool parse_format(const char *name, writer_format *writer) {
+  if (strcmp(name, "man") == 0) {
+    *writer = FORMAT_MAN;
+  } else if (strcmp(name, "html") == 0) {
+    *writer = FORMAT_HTML;
+  } else if (strcmp(name, "xml") == 0) {
+    *writer = FORMAT_XML;
+  } else if (strcmp(name, "commonmark") == 0) {
+    *writer = FORMAT_COMMONMARK;
+  } else if (strcmp(name, "latex") == 0) {
+    *writer = FORMAT_LATEX;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static char *render_document(cmark_node *document, writer_format writer,
+                             int options, int width) {
   switch (writer) {
   case FORMAT_HTML:
-    result = cmark_render_html(document, options);
-    break;
+    return cmark_render_html(document, options);
   case FORMAT_XML:
-    result = cmark_render_xml(document, options);
-    break;
+    return cmark_render_xml(document, options);
   case FORMAT_MAN:
-    result = cmark_render_man(document, options, width);
-    break;
+    return cmark_render_man(document, options, width);
   case FORMAT_COMMONMARK:
-    result = cmark_render_commonmark(document, options, width);
-    break;
+    return cmark_render_commonmark(document, options, width);
   case FORMAT_LATEX:
-    result = cmark_render_latex(document, options, width);
-    break;
+    return cmark_render_latex(document, options, width);
   default:
     fprintf(stderr, "Unknown format %d\n", writer);
-    return false;
+    return NULL;
   }
+}
+
+static bool print_document(cmark_node *document, writer_format writer,
+                           int options, int width) {
+  char *result = render_document(document, writer, options, width);
+
+  if (result == NULL)
+    return false;
 
   printf("%s", result);
   cmark_node_mem(document)->free(result);
@@ -70,6 +180,795 @@ static bool print_document(cmark_node *document, writer_format writer,
   return true;
 }
 
+static const char *format_suffix(writer_format writer) {
+  switch (writer) {
+  case FORMAT_HTML:
+    return ".html";
+  case FORMAT_XML:
+    return ".xml";
+  case FORMAT_MAN:
+    return ".1";
+  case FORMAT_COMMONMARK:
+    return ".md";
+  case FORMAT_LATEX:
+    return ".tex";
+  default:
+    return "";
+  }
+}
+
+// State shared by the --batch workers.  Each worker owns a parser that
+// is reused for every file it converts; the only shared mutable state
+// is the position of the next file and the error count.
+typedef struct {
+  char **paths;
+  int *files;
+  int numfps;
+  char **outputs; // output path for each of 'files', made up front
+  const char *outdir;
+  writer_format writer;
+  int options;
+  int width;
+  cmark_llist *extensions;
+  cmark_parser_limits limits;
+  int next;
+  int failures;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock;
+#endif
+} batch_job;
+
+static int batch_next_file(batch_job *job) {
+  int i = -1;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&job->lock);
+#endif
+  if (job->next < job->numfps)
+    i = job->next++;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&job->lock);
+#endif
+
+  return i;
+}
+
+// Build OUTDIR/INPUT with the input suffix replaced by the output one.
+// Relative directories in INPUT are kept, with "." and "dir/.." resolved;
+// leading "/" and "../" components are dropped so that the result stays
+// inside OUTDIR.  Returns false if a later ".." would leave OUTDIR or
+// no file name is left.
+static bool batch_output_path(batch_job *job, const char *input,
+                              cmark_strbuf *path) {
+  bufsize_t base, name;
+  const char *end, *dot;
+  bool leading = true;
+
+  cmark_strbuf_clear(path);
+  cmark_strbuf_puts(path, job->outdir);
+  base = path->size;
+
+  while (*input) {
+    size_t len;
+
+    end = strchr(input, '/');
+    if (end == NULL)
+      end = input + strlen(input);
+    len = (size_t)(end - input);
+
+    if (len == 0 || (len == 1 && input[0] == '.')) {
+      // nothing to add
+    } else if (len == 2 && input[0] == '.' && input[1] == '.') {
+      if (!leading) {
+        if (path->size == base)
+          return false;
+        cmark_strbuf_truncate(path,
+                              cmark_strbuf_strrchr(path, '/', path->size - 1));
+      }
+    } else {
+      leading = false;
+      cmark_strbuf_putc(path, '/');
+      cmark_strbuf_put(path, (const unsigned char *)input, (bufsize_t)len);
+    }
+    input = *end ? end + 1 : end;
+  }
+
+  if (path->size == base)
+    return false;
+  name = cmark_strbuf_strrchr(path, '/', path->size - 1) + 1;
+  dot = strrchr((char *)path->ptr + name, '.');
+  if (dot != NULL)
+    cmark_strbuf_truncate(path, (bufsize_t)(dot - (char *)path->ptr));
+  cmark_strbuf_puts(path, format_suffix(job->writer));
+  return true;
+}
+
+typedef struct {
+  const char *output;
+  const char *input;
+} batch_target;
+
+static int compare_targets(const void *a, const void *b) {
+  return strcmp(((const batch_target *)a)->output,
+                ((const batch_target *)b)->output);
+}
+
+// Make the output path of every file, failing if one cannot be made or
+// two files would be written to the same path.
+static bool batch_plan(batch_job *job, cmark_mem *mem) {
+  batch_target *targets;
+  cmark_strbuf path = CMARK_BUF_INIT(mem);
+  bool ok = true;
+  int i;
+
+  job->outputs = (char **)mem->calloc(job->numfps, sizeof(*job->outputs));
+  targets = (batch_target *)mem->calloc(job->numfps, sizeof(*targets));
+
+  for (i = 0; i < job->numfps; i++) {
+    const char *input = job->paths[job->files[i]];
+
+    if (!batch_output_path(job, input, &path)) {
+      fprintf(stderr, "Error: %s has no output path inside %s\n", input,
+              job->outdir);
+      ok = false;
+      continue;
+    }
+    job->outputs[i] = (char *)cmark_strbuf_detach(&path);
+    targets[i].output = job->outputs[i];
+    targets[i].input = input;
+  }
+
+  if (ok) {
+    qsort(targets, job->numfps, sizeof(*targets), compare_targets);
+    for (i = 1; i < job->numfps; i++) {
+      if (strcmp(targets[i - 1].output, targets[i].output) == 0) {
+        fprintf(stderr, "Error: %s and %s would both be written to %s\n",
+                targets[i - 1].input, targets[i].input, targets[i].output);
+        ok = false;
+      }
+    }
+  }
+
+  mem->free(targets);
+  return ok;
+}
+
+static void batch_free(batch_job *job, cmark_mem *mem) {
+  int i;
+
+  for (i = 0; i < job->numfps; i++)
+    mem->free(job->outputs[i]);
+  mem->free(job->outputs);
+}
+
+// Create every missing directory leading up to the file 'path'.
+static bool make_parent_dirs(char *path) {
+  size_t i;
+
+  for (i = 1; path[i]; i++) {
+    if (path[i] != '/')
+      continue;
+    path[i] = '\0';
+    if (mkdir(path, 0777) != 0 && errno != EEXIST) {
+      fprintf(stderr, "Error creating directory %s: %s\n", path,
+              strerror(errno));
+      path[i] = '/';
+      return false;
+    }
+    path[i] = '/';
+  }
+
+  return true;
+}
+
+static bool batch_convert(batch_job *job, cmark_parser *parser,
+                          const char *input, char *output) {
+  FILE *fp;
+  cmark_node *document;
+  cmark_parser_error error;
+  char *result;
+  size_t len;
+  bool ok;
+
+  fp = fopen(input, "rb");
+  if (fp == NULL) {
+    fprintf(stderr, "Error opening file %s: %s\n", input, strerror(errno));
+    return false;
+  }
+  cmark_parser_feed_file(parser, fp, true);
+  fclose(fp);
+
+  document = cmark_parser_finish(parser);
+  error = cmark_parser_get_error(parser);
+  result = render_document(document, job->writer, job->options, job->width);
+  cmark_node_free(document);
+  if (result == NULL)
+    return false;
+  if (error != CMARK_PARSER_OK)
+    fprintf(stderr, "%s exceeds the limit on %s; output is truncated\n",
+            input, limit_name(error));
+
+  ok = make_parent_dirs(output);
+  if (ok) {
+    fp = fopen(output, "wb");
+    if (fp == NULL) {
+      fprintf(stderr, "Error opening file %s: %s\n", output,
+              strerror(errno));
+      ok = false;
+    } else {
+      len = strlen(result);
+      ok = fwrite(result, 1, len, fp) == len;
+      ok = (fclose(fp) == 0) && ok;
+      if (!ok)
+        fprintf(stderr, "Error writing file %s\n", output);
+    }
+  }
+
+  parser->mem->free(result);
+  return ok && error == CMARK_PARSER_OK;
+}
+
+static void *batch_worker(void *data) {
+  batch_job *job = (batch_job *)data;
+  cmark_parser *parser = new_limited_parser(job->options, &job->limits);
+  cmark_llist *tmp;
+  int failures = 0;
+  int i;
+
+  for (tmp = job->extensions; tmp; tmp = tmp->next)
+    cmark_parser_attach_syntax_extension(
+        parser, (cmark_syntax_extension *)tmp->data);
+
+  while ((i = batch_next_file(job)) >= 0) {
+    if (!batch_convert(job, parser, job->paths[job->files[i]],
+                       job->outputs[i]))
+      failures++;
+  }
+
+  cmark_parser_free(parser);
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&job->lock);
+#endif
+  job->failures += failures;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&job->lock);
+#endif
+
+  return NULL;
+}
+
+static int default_jobs(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > 0)
+    return (int)n;
+#endif
+  return 1;
+}
+
+// Convert every input file separately, spreading them over 'jobs' worker
+// threads.  Returns the number of files that failed, or all of them if
+// their output paths are unusable.
+static int run_batch(batch_job *job, int jobs) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  cmark_mem *mem = &DEFAULT_MEM_ALLOCATOR;
+
+  job->next = 0;
+  job->failures = 0;
+
+  if (!batch_plan(job, mem)) {
+    batch_free(job, mem);
+    return job->numfps;
+  }
+
+  if (jobs > job->numfps)
+    jobs = job->numfps;
+
+#ifdef HAVE_PTHREAD_H
+  if (jobs > 1) {
+    pthread_t *threads = (pthread_t *)calloc(jobs, sizeof(*threads));
+    int started = 0;
+    int i;
+
+    pthread_mutex_init(&job->lock, NULL);
+    for (i = 0; i < jobs; i++) {
+      if (pthread_create(&threads[i], NULL, batch_worker, job) != 0)
+        break;
+      started++;
+    }
+    // If no thread could be started, do the work on this one.
+    if (started == 0)
+      batch_worker(job);
+    for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&job->lock);
+    free(threads);
+  } else {
+    pthread_mutex_init(&job->lock, NULL);
+    batch_worker(job);
+    pthread_mutex_destroy(&job->lock);
+  }
+#else
+  batch_worker(job);
+#endif
+
+  batch_free(job, mem);
+  return job->failures;
+}
+
+/* --serve protocol.
+ *
+ * Each request is a header line followed by a body:
+ *
+ *     LENGTH [OPTION...]\n
+ *     <LENGTH bytes of CommonMark>
+ *
+ * OPTIONs are the command-line flags --sourcepos, --hardbreaks,
+ * --nobreaks, --smart, --safe, --validate-utf8, -t FORMAT, --width N and
+ * -e EXTENSION, added on top of those given after --serve.  Each
+ * response is written in request order as
+ *
+ *     ok LENGTH\n<LENGTH bytes of output>
+ *
+ * or, if the request could not be handled,
+ *
+ *     error LENGTH\n<LENGTH bytes of message>
+ *
+ * A malformed header or a truncated body ends the stream after its
+ * error response, since the next frame cannot be located.
+ */
+
+#define SERVE_MAX_HEADER 4096
+#define SERVE_MAX_INPUT (INT32_MAX / 2 - 1)
+
+typedef enum { SLOT_FREE, SLOT_READY, SLOT_BUSY, SLOT_DONE } slot_state;
+
+// One in-flight request.  Slots are reused round-robin, so their buffers
+// only grow to the size of the largest request seen.
+typedef struct {
+  slot_state state;
+  writer_format writer;
+  int options;
+  int width;
+  cmark_strbuf extensions; // space-separated extension names
+  cmark_strbuf input;
+  char *result;
+  cmark_strbuf error;
+} serve_slot;
+
+typedef struct {
+  cmark_mem *mem;
+  writer_format writer;
+  int options;
+  int width;
+  cmark_strbuf extensions;
+  cmark_parser_limits limits;
+  cmark_strbuf header;
+  serve_slot *slots;
+  int nslots;
+  // Sequence numbers of the next request to read, to hand to a worker and
+  // to write out.  Request n lives in slots[n % nslots].
+  unsigned long next_read;
+  unsigned long next_work;
+  unsigned long next_write;
+  bool eof;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+} serve_state;
+
+// A worker keeps its parser for as long as requests use the same
+// options and extensions.
+typedef struct {
+  serve_state *st;
+  cmark_parser *parser;
+  int options;
+  cmark_strbuf extensions;
+} serve_worker;
+
+static void serve_init(serve_state *st, writer_format writer, int options,
+                       int width, cmark_llist *extensions,
+                       const cmark_parser_limits *limits) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  cmark_llist *tmp;
+
+  // Discover plugins now rather than lazily from the reader thread, so that
+  // the registry is not modified while workers look extensions up.
+  cmark_llist_free(cmark_list_syntax_extensions());
+
+  memset(st, 0, sizeof(*st));
+  st->mem = limits->max_bytes ? cmark_get_instrumented_mem_allocator()
+                              : &DEFAULT_MEM_ALLOCATOR;
+  st->limits = *limits;
+  st->writer = writer;
+  st->options = options;
+  st->width = width;
+  cmark_strbuf_init(st->mem, &st->extensions, 0);
+  cmark_strbuf_init(st->mem, &st->header, 0);
+  for (tmp = extensions; tmp; tmp = tmp->next) {
+    cmark_syntax_extension *ext = (cmark_syntax_extension *)tmp->data;
+    if (st->extensions.size)
+      cmark_strbuf_putc(&st->extensions, ' ');
+    cmark_strbuf_puts(&st->extensions, ext->name);
+  }
+}
+
+static void serve_free(serve_state *st) {
+  int i;
+
+  for (i = 0; i < st->nslots; i++) {
+    serve_slot *slot = &st->slots[i];
+    cmark_strbuf_release(&slot->extensions);
+    cmark_strbuf_release(&slot->input);
+    cmark_strbuf_release(&slot->error);
+    if (slot->result)
+      st->mem->free(slot->result);
+  }
+  free(st->slots);
+  cmark_strbuf_release(&st->extensions);
+  cmark_strbuf_release(&st->header);
+}
+
+static char *next_token(char **p) {
+  char *start = *p;
+
+  while (*start == ' ' || *start == '\t' || *start == '\r')
+    start++;
+  if (*start == '\0')
+    return NULL;
+
+  *p = start;
+  while (**p && **p != ' ' && **p != '\t' && **p != '\r')
+    (*p)++;
+  if (**p)
+    *(*p)++ = '\0';
+
+  return start;
+}
+
+static void serve_error(serve_slot *slot, const char *msg, const char *arg) {
+  if (slot->error.size)
+    return;
+  cmark_strbuf_puts(&slot->error, msg);
+  if (arg) {
+    cmark_strbuf_puts(&slot->error, " ");
+    cmark_strbuf_puts(&slot->error, arg);
+  }
+}
+
+// Read one request into 'slot'.  Returns 1 if a frame was read (with
+// slot->error set if the request itself is invalid), 0 at the end of
+// input and -1 if the stream is broken; in that case slot->error holds
+// the last response to send.
+static int serve_read_request(serve_state *st, serve_slot *slot) {
+  cmark_strbuf *header = &st->header;
+  char *p, *tok, *arg, *end;
+  long len;
+  int c;
+
+  cmark_strbuf_clear(&slot->error);
+  cmark_strbuf_clear(&slot->input);
+  cmark_strbuf_set(&slot->extensions, st->extensions.ptr,
+                   st->extensions.size);
+  slot->writer = st->writer;
+  slot->options = st->options;
+  slot->width = st->width;
+
+  cmark_strbuf_clear(header);
+  while ((c = getchar()) != EOF && c != '\n') {
+    if (header->size >= SERVE_MAX_HEADER) {
+      serve_error(slot, "Request header too long", NULL);
+      return -1;
+    }
+    cmark_strbuf_putc(header, c);
+  }
+  if (c == EOF) {
+    if (header->size == 0)
+      return 0;
+    serve_error(slot, "Truncated request header", NULL);
+    return -1;
+  }
+
+  p = (char *)header->ptr;
+  tok = next_token(&p);
+  len = tok ? strtol(tok, &end, 10) : -1;
+  if (tok == NULL || *end || len < 0 || len > SERVE_MAX_INPUT) {
+    serve_error(slot, "Invalid request length", tok);
+    return -1;
+  }
+
+  while ((tok = next_token(&p)) != NULL) {
+    int flag = option_flag(tok);
+    if (flag) {
+      slot->options |= flag;
+    } else if (strcmp(tok, "-t") == 0 || strcmp(tok, "--to") == 0) {
+      arg = next_token(&p);
+      if (arg == NULL || !parse_format(arg, &slot->writer))
+        serve_error(slot, "Unknown format", arg);
+    } else if (strcmp(tok, "--width") == 0) {
+      arg = next_token(&p);
+      slot->width = arg ? (int)strtol(arg, &end, 10) : 0;
+      if (arg == NULL || *end)
+        serve_error(slot, "Invalid width", arg);
+    } else if (strcmp(tok, "-e") == 0 || strcmp(tok, "--extension") == 0) {
+      arg = next_token(&p);
+      if (arg == NULL || !cmark_find_syntax_extension(arg)) {
+        serve_error(slot, "Unknown extension", arg);
+      } else {
+        if (slot->extensions.size)
+          cmark_strbuf_putc(&slot->extensions, ' ');
+        cmark_strbuf_puts(&slot->extensions, arg);
+      }
+    } else {
+      serve_error(slot, "Unknown option", tok);
+    }
+  }
+
+  if (len > 0) {
+    cmark_strbuf_grow(&slot->input, (bufsize_t)len);
+    if (fread(slot->input.ptr, 1, (size_t)len, stdin) != (size_t)len) {
+      cmark_strbuf_clear(&slot->error);
+      serve_error(slot, "Truncated request body", NULL);
+      return -1;
+    }
+    slot->input.size = (bufsize_t)len;
+    slot->input.ptr[len] = '\0';
+  }
+
+  return 1;
+}
+
+static void serve_process(serve_worker *w, serve_slot *slot) {
+  cmark_node *document;
+
+  if (w->parser == NULL || w->options != slot->options ||
+      cmark_strbuf_cmp(&w->extensions, &slot->extensions) != 0) {
+    char *p, *name;
+
+    if (w->parser)
+      cmark_parser_free(w->parser);
+    w->parser = cmark_parser_new_with_mem(slot->options, w->st->mem);
+    cmark_parser_set_limits(w->parser, &w->st->limits);
+    w->options = slot->options;
+    cmark_strbuf_set(&w->extensions, slot->extensions.ptr,
+                     slot->extensions.size);
+
+    // Names were checked when the request was read.
+    p = (char *)slot->extensions.ptr;
+    while ((name = next_token(&p)) != NULL)
+      cmark_parser_attach_syntax_extension(w->parser,
+                                           cmark_find_syntax_extension(name));
+    // next_token() split the names in place; restore the separators.
+    cmark_strbuf_set(&slot->extensions, w->extensions.ptr,
+                     w->extensions.size);
+  }
+
+  cmark_parser_feed(w->parser, (const char *)slot->input.ptr,
+                    slot->input.size);
+  document = cmark_parser_finish(w->parser);
+  slot->result =
+      render_document(document, slot->writer, slot->options, slot->width);
+  cmark_node_free(document);
+
+  if (cmark_parser_get_error(w->parser) != CMARK_PARSER_OK)
+    serve_error(slot, "Input exceeds the limit on",
+                limit_name(cmark_parser_get_error(w->parser)));
+
+  if (slot->result == NULL)
+    serve_error(slot, "Rendering failed", NULL);
+}
+
+static void serve_write_response(serve_state *st, serve_slot *slot) {
+  const char *data;
+  size_t len;
+
+  if (slot->result && slot->error.size == 0) {
+    data = slot->result;
+    len = strlen(data);
+    printf("ok %lu\n", (unsigned long)len);
+  } else {
+    data = (const char *)slot->error.ptr;
+    len = (size_t)slot->error.size;
+    printf("error %lu\n", (unsigned long)len);
+  }
+  fwrite(data, 1, len, stdout);
+
+  if (slot->result) {
+    st->mem->free(slot->result);
+    slot->result = NULL;
+  }
+}
+
+static void serve_slots_init(serve_state *st, int nslots) {
+  int i;
+
+  st->nslots = nslots;
+  st->slots = (serve_slot *)calloc(nslots, sizeof(*st->slots));
+  for (i = 0; i < nslots; i++) {
+    cmark_strbuf_init(st->mem, &st->slots[i].extensions, 0);
+    cmark_strbuf_init(st->mem, &st->slots[i].input, 0);
+    cmark_strbuf_init(st->mem, &st->slots[i].error, 0);
+  }
+}
+
+static void serve_worker_init(serve_worker *w, serve_state *st) {
+  w->st = st;
+  w->parser = NULL;
+  w->options = 0;
+  cmark_strbuf_init(st->mem, &w->extensions, 0);
+}
+
+static void serve_worker_free(serve_worker *w) {
+  if (w->parser)
+    cmark_parser_free(w->parser);
+  cmark_strbuf_release(&w->extensions);
+}
+
+#ifdef HAVE_PTHREAD_H
+static void *serve_work_thread(void *data) {
+  serve_worker *w = (serve_worker *)data;
+  serve_state *st = w->st;
+
+  pthread_mutex_lock(&st->lock);
+  for (;;) {
+    serve_slot *slot;
+
+    // Requests that failed while being read are already DONE.
+    while (st->next_work < st->next_read &&
+           st->slots[st->next_work % st->nslots].state != SLOT_READY)
+      st->next_work++;
+
+    if (st->next_work < st->next_read) {
+      slot = &st->slots[st->next_work++ % st->nslots];
+      slot->state = SLOT_BUSY;
+      pthread_mutex_unlock(&st->lock);
+      serve_process(w, slot);
+      pthread_mutex_lock(&st->lock);
+      slot->state = SLOT_DONE;
+      pthread_cond_broadcast(&st->cond);
+    } else if (st->eof) {
+      break;
+    } else {
+      pthread_cond_wait(&st->cond, &st->lock);
+    }
+  }
+  pthread_mutex_unlock(&st->lock);
+
+  return NULL;
+}
+
+static void *serve_write_thread(void *data) {
+  serve_state *st = (serve_state *)data;
+
+  pthread_mutex_lock(&st->lock);
+  for (;;) {
+    serve_slot *slot = &st->slots[st->next_write % st->nslots];
+
+    if (st->next_write < st->next_read && slot->state == SLOT_DONE) {
+      bool more;
+
+      pthread_mutex_unlock(&st->lock);
+      serve_write_response(st, slot);
+      pthread_mutex_lock(&st->lock);
+      slot->state = SLOT_FREE;
+      st->next_write++;
+      pthread_cond_broadcast(&st->cond);
+
+      // Flush once the responses that are ready have all been written.
+      slot = &st->slots[st->next_write % st->nslots];
+      more = st->next_write < st->next_read && slot->state == SLOT_DONE;
+      if (!more) {
+        pthread_mutex_unlock(&st->lock);
+        fflush(stdout);
+        pthread_mutex_lock(&st->lock);
+      }
+    } else if (st->eof && st->next_write == st->next_read) {
+      break;
+    } else {
+      pthread_cond_wait(&st->cond, &st->lock);
+    }
+  }
+  pthread_mutex_unlock(&st->lock);
+
+  return NULL;
+}
+
+// Read requests on this thread while 'jobs' workers convert them and a
+// writer thread sends the responses back in order.
+static int serve_run_threaded(serve_state *st, int jobs) {
+  serve_worker *workers;
+  pthread_t *threads;
+  pthread_t writer;
+  int started = 0;
+  int i, r = -1;
+
+  serve_slots_init(st, 2 * jobs);
+  workers = (serve_worker *)calloc(jobs, sizeof(*workers));
+  threads = (pthread_t *)calloc(jobs, sizeof(*threads));
+  for (i = 0; i < jobs; i++)
+    serve_worker_init(&workers[i], st);
+  pthread_mutex_init(&st->lock, NULL);
+  pthread_cond_init(&st->cond, NULL);
+
+  if (pthread_create(&writer, NULL, serve_write_thread, st) != 0)
+    goto cleanup;
+  for (i = 0; i < jobs; i++) {
+    if (pthread_create(&threads[i], NULL, serve_work_thread, &workers[i]) != 0)
+      break;
+    started++;
+  }
+
+  do {
+    serve_slot *slot;
+
+    pthread_mutex_lock(&st->lock);
+    while (st->slots[st->next_read % st->nslots].state != SLOT_FREE)
+      pthread_cond_wait(&st->cond, &st->lock);
+    slot = &st->slots[st->next_read % st->nslots];
+    pthread_mutex_unlock(&st->lock);
+
+    r = started ? serve_read_request(st, slot) : 0;
+
+    pthread_mutex_lock(&st->lock);
+    if (r != 0) {
+      slot->state = slot->error.size ? SLOT_DONE : SLOT_READY;
+      st->next_read++;
+    }
+    if (r <= 0)
+      st->eof = true;
+    pthread_cond_broadcast(&st->cond);
+    pthread_mutex_unlock(&st->lock);
+  } while (r > 0);
+
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+  pthread_join(writer, NULL);
+
+cleanup:
+  for (i = 0; i < jobs; i++)
+    serve_worker_free(&workers[i]);
+  pthread_cond_destroy(&st->cond);
+  pthread_mutex_destroy(&st->lock);
+  free(threads);
+  free(workers);
+
+  return (started && r == 0) ? 0 : 1;
+}
+#endif
+
+// Serve requests until the end of input.  Returns the exit status, which
+// is non-zero if the stream ended in a malformed frame.
+static int serve_run(serve_state *st, int jobs) {
+  serve_worker w;
+  serve_slot *slot;
+  int r;
+
+#ifdef HAVE_PTHREAD_H
+  if (jobs > 1)
+    return serve_run_threaded(st, jobs);
+#else
+  (void)jobs;
+#endif
+
+  serve_slots_init(st, 1);
+  serve_worker_init(&w, st);
+  slot = &st->slots[0];
+
+  while ((r = serve_read_request(st, slot)) != 0) {
+    if (slot->error.size == 0)
+      serve_process(&w, slot);
+    serve_write_response(st, slot);
+    fflush(stdout);
+    if (r < 0)
+      break;
+  }
+
+  serve_worker_free(&w);
+  return r < 0 ? 1 : 0;
+}
+
 static void print_extensions(void) {
   cmark_llist *syntax_extensions;
   cmark_llist *tmp;
@@ -88,14 +987,18 @@ static void print_extensions(void) {
 int main(int argc, char *argv[]) {
   int i, numfps = 0;
   int *files;
-  char buffer[4096];
   cmark_parser *parser = NULL;
-  size_t bytes;
   cmark_node *document = NULL;
   int width = 0;
   char *unparsed;
   writer_format writer = FORMAT_HTML;
   int options = CMARK_OPT_DEFAULT;
+  int flag;
+  bool batch = false;
+  bool serve = false;
+  const char *outdir = NULL;
+  int jobs = 0;
+  cmark_parser_limits limits;
   int res = 1;
 
   cmark_init();
@@ -106,6 +1009,7 @@ int main(int argc, char *argv[]) {
 #endif
 
   files = (int *)calloc(argc, sizeof(*files));
+  memset(&limits, 0, sizeof(limits));
 
   for (i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--version") == 0) {
@@ -115,18 +1019,8 @@ int main(int argc, char *argv[]) {
     } else if (strcmp(argv[i], "--list-extensions") == 0) {
       print_extensions();
       goto success;
-    } else if (strcmp(argv[i], "--sourcepos") == 0) {
-      options |= CMARK_OPT_SOURCEPOS;
-    } else if (strcmp(argv[i], "--hardbreaks") == 0) {
-      options |= CMARK_OPT_HARDBREAKS;
-    } else if (strcmp(argv[i], "--nobreaks") == 0) {
-      options |= CMARK_OPT_NOBREAKS;
-    } else if (strcmp(argv[i], "--smart") == 0) {
-      options |= CMARK_OPT_SMART;
-    } else if (strcmp(argv[i], "--safe") == 0) {
-      options |= CMARK_OPT_SAFE;
-    } else if (strcmp(argv[i], "--validate-utf8") == 0) {
-      options |= CMARK_OPT_VALIDATE_UTF8;
+    } else if ((flag = option_flag(argv[i])) != 0) {
+      options |= flag;
     } else if ((strcmp(argv[i], "--help") == 0) ||
                (strcmp(argv[i], "-h") == 0)) {
       print_usage();
@@ -147,17 +1041,7 @@ int main(int argc, char *argv[]) {
     } else if ((strcmp(argv[i], "-t") == 0) || (strcmp(argv[i], "--to") == 0)) {
       i += 1;
       if (i < argc) {
-        if (strcmp(argv[i], "man") == 0) {
-          writer = FORMAT_MAN;
-        } else if (strcmp(argv[i], "html") == 0) {
-          writer = FORMAT_HTML;
-        } else if (strcmp(argv[i], "xml") == 0) {
-          writer = FORMAT_XML;
-        } else if (strcmp(argv[i], "commonmark") == 0) {
-          writer = FORMAT_COMMONMARK;
-        } else if (strcmp(argv[i], "latex") == 0) {
-          writer = FORMAT_LATEX;
-        } else {
+        if (!parse_format(argv[i], &writer)) {
           fprintf(stderr, "Unknown format %s\n", argv[i]);
           goto failure;
         }
@@ -165,6 +1049,45 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "No argument provided for %s\n", argv[i - 1]);
         goto failure;
       }
+    } else if (strcmp(argv[i], "--batch") == 0) {
+      batch = true;
+    } else if (strcmp(argv[i], "--serve") == 0) {
+      serve = true;
+    } else if ((strcmp(argv[i], "-o") == 0) ||
+               (strcmp(argv[i], "--output") == 0)) {
+      i += 1;
+      if (i < argc) {
+        outdir = argv[i];
+      } else {
+        fprintf(stderr, "No argument provided for %s\n", argv[i - 1]);
+        goto failure;
+      }
+    } else if ((strcmp(argv[i], "-j") == 0) ||
+               (strcmp(argv[i], "--jobs") == 0)) {
+      i += 1;
+      if (i < argc) {
+        jobs = (int)strtol(argv[i], &unparsed, 10);
+        if ((unparsed && strlen(unparsed) > 0) || jobs < 1) {
+          fprintf(stderr, "failed parsing jobs '%s'\n", argv[i]);
+          goto failure;
+        }
+      } else {
+        fprintf(stderr, "No argument provided for %s\n", argv[i - 1]);
+        goto failure;
+      }
+    } else if (set_limit(&limits, argv[i], 0)) {
+      i += 1;
+      if (i < argc) {
+        unsigned long value = strtoul(argv[i], &unparsed, 10);
+        if ((unparsed && strlen(unparsed) > 0) || *argv[i] == '-') {
+          fprintf(stderr, "failed parsing %s '%s'\n", argv[i - 1], argv[i]);
+          goto failure;
+        }
+        set_limit(&limits, argv[i - 1], (size_t)value);
+      } else {
+        fprintf(stderr, "No argument provided for %s\n", argv[i - 1]);
+        goto failure;
+      }
     } else if ((strcmp(argv[i], "-e") == 0) || (strcmp(argv[i], "--extension") == 0)) {
       i += 1; // Simpler to handle extensions in a second pass, as we can directly register
               // them with the parser.
@@ -176,7 +1099,7 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  parser = cmark_parser_new(options);
+  parser = new_limited_parser(options, &limits);
 
   for (i = 1; i < argc; i++) {
     if ((strcmp(argv[i], "-e") == 0) || (strcmp(argv[i], "--extension") == 0)) {
@@ -195,6 +1118,41 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  if (serve) {
+    serve_state st;
+
+    serve_init(&st, writer, options, width, parser->syntax_extensions,
+               &limits);
+    res = serve_run(&st, jobs > 0 ? jobs : 1);
+    serve_free(&st);
+    if (res != 0)
+      goto failure;
+    goto success;
+  }
+
+  if (batch) {
+    batch_job job;
+
+    if (outdir == NULL || numfps == 0) {
+      fprintf(stderr, "--batch requires --output and at least one file\n");
+      goto failure;
+    }
+
+    job.paths = argv;
+    job.files = files;
+    job.numfps = numfps;
+    job.outdir = outdir;
+    job.writer = writer;
+    job.options = options;
+    job.width = width;
+    job.extensions = parser->syntax_extensions;
+    job.limits = limits;
+
+    if (run_batch(&job, jobs > 0 ? jobs : default_jobs()) > 0)
+      goto failure;
+    goto success;
+  }
+
   for (i = 0; i < numfps; i++) {
     FILE *fp = fopen(argv[files[i]], "rb");
     if (fp == NULL) {
@@ -203,24 +1161,13 @@ int main(int argc, char *argv[]) {
       goto failure;
     }
 
-    while ((bytes = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
-      cmark_parser_feed(parser, buffer, bytes);
-      if (bytes < sizeof(buffer)) {
-        break;
-      }
-    }
+    cmark_parser_feed_file(parser, fp, true);
 
     fclose(fp);
   }
 
   if (numfps == 0) {
-
-    while ((bytes = fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
-      cmark_parser_feed(parser, buffer, bytes);
-      if (bytes < sizeof(buffer)) {
-        break;
-      }
-    }
+    cmark_parser_feed_file(parser, stdin, true);
   }
 
   document = cmark_parser_finish(parser);
@@ -228,6 +1175,12 @@ int main(int argc, char *argv[]) {
   if (!print_document(document, writer, options, width))
     goto failure;
 
+  if (cmark_parser_get_error(parser) != CMARK_PARSER_OK) {
+    fprintf(stderr, "Input exceeds the limit on %s; output is truncated\n",
+            limit_name(cmark_parser_get_error(parser)));
+    goto failure;
+  }
+
 
 success:
   res = 0;
@@ -304,5 +304,5 @@ static int S_render_node(cmark_renderer *renderer, cmark_node *node,
 }
 
 char *cmark_render_man(cmark_node *root, int options, int width) {
-  return cmark_render(root, options, width, S_outc, S_render_node);
+  return cmark_render(root, options, width, CMARK_PHASE_RENDER_MAN, S_outc, S_render_node);
 }
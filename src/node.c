@@ -2,44 +2,22 @@
 #include <string.h>
 
 #include "node.h"
+#include "references.h"
 
 static void S_node_unlink(cmark_node *node);
 
 #define NODE_MEM(node) cmark_node_mem(node)
 
-static CMARK_INLINE bool S_is_block(cmark_node *node) {
-  if (node == NULL) {
-    return false;
-  }
-  return node->type >= CMARK_NODE_FIRST_BLOCK &&
-         node->type <= CMARK_NODE_LAST_BLOCK;
+static CMARK_INLINE bool S_is_block_type(cmark_node_type type) {
+  return type >= CMARK_NODE_FIRST_BLOCK && type <= CMARK_NODE_LAST_BLOCK;
 }
 
-static CMARK_INLINE bool S_is_inline(cmark_node *node) {
-  if (node == NULL) {
-    return false;
-  }
-  return node->type >= CMARK_NODE_FIRST_INLINE &&
-         node->type <= CMARK_NODE_LAST_INLINE;
+static CMARK_INLINE bool S_is_inline_type(cmark_node_type type) {
+  return type >= CMARK_NODE_FIRST_INLINE && type <= CMARK_NODE_LAST_INLINE;
 }
 
-static bool S_can_contain(cmark_node *node, cmark_node *child) {
-  cmark_node *cur;
-
-  if (node == NULL || child == NULL) {
-    return false;
-  }
-
-  // Verify that child is not an ancestor of node or equal to node.
-  cur = node;
-  do {
-    if (cur == child) {
-      return false;
-    }
-    cur = cur->parent;
-  } while (cur != NULL);
-
-  if (child->type == CMARK_NODE_DOCUMENT) {
+bool cmark_node_can_contain_type(cmark_node *node, cmark_node_type child_type) {
+  if (child_type == CMARK_NODE_DOCUMENT) {
     return false;
   }
 
@@ -47,10 +25,10 @@ static bool S_can_contain(cmark_node *node, cmark_node *child) {
   case CMARK_NODE_DOCUMENT:
   case CMARK_NODE_BLOCK_QUOTE:
   case CMARK_NODE_ITEM:
-    return S_is_block(child) && child->type != CMARK_NODE_ITEM;
+    return S_is_block_type(child_type) && child_type != CMARK_NODE_ITEM;
 
   case CMARK_NODE_LIST:
-    return child->type == CMARK_NODE_ITEM;
+    return child_type == CMARK_NODE_ITEM;
 
   case CMARK_NODE_CUSTOM_BLOCK:
     return true;
@@ -63,20 +41,20 @@ static bool S_can_contain(cmark_node *node, cmark_node *child) {
   case CMARK_NODE_IMAGE:
   case CMARK_NODE_STRIKETHROUGH:
   case CMARK_NODE_CUSTOM_INLINE:
-    return S_is_inline(child);
+    return S_is_inline_type(child_type);
   case CMARK_NODE_TABLE:
-    return child->type == CMARK_NODE_TABLE_ROW;
+    return child_type == CMARK_NODE_TABLE_ROW;
   case CMARK_NODE_TABLE_ROW:
-    return child->type == CMARK_NODE_TABLE_CELL;
+    return child_type == CMARK_NODE_TABLE_CELL;
   case CMARK_NODE_TABLE_CELL:
-    return child->type == CMARK_NODE_TEXT ||
-           child->type == CMARK_NODE_CODE ||
-           child->type == CMARK_NODE_EMPH ||
-           child->type == CMARK_NODE_STRONG ||
-           child->type == CMARK_NODE_LINK ||
-           child->type == CMARK_NODE_IMAGE ||
-           child->type == CMARK_NODE_HTML_INLINE ||
-           child->type == CMARK_NODE_STRIKETHROUGH;
+    return child_type == CMARK_NODE_TEXT ||
+           child_type == CMARK_NODE_CODE ||
+           child_type == CMARK_NODE_EMPH ||
+           child_type == CMARK_NODE_STRONG ||
+           child_type == CMARK_NODE_LINK ||
+           child_type == CMARK_NODE_IMAGE ||
+           child_type == CMARK_NODE_HTML_INLINE ||
+           child_type == CMARK_NODE_STRIKETHROUGH;
 
   default:
     break;
@@ -85,8 +63,29 @@ static bool S_can_contain(cmark_node *node, cmark_node *child) {
   return false;
 }
 
+static bool S_can_contain(cmark_node *node, cmark_node *child) {
+  cmark_node *cur;
+
+  if (node == NULL || child == NULL) {
+    return false;
+  }
+
+  // Verify that child is not an ancestor of node or equal to node.
+  cur = node;
+  do {
+    if (cur == child) {
+      return false;
+    }
+    cur = cur->parent;
+  } while (cur != NULL);
+
+  return cmark_node_can_contain_type(node, (cmark_node_type)child->type);
+}
+
 cmark_node *cmark_node_new_with_mem(cmark_node_type type, cmark_mem *mem) {
-  cmark_node *node = (cmark_node *)mem->calloc(1, sizeof(*node));
+  cmark_node *node;
+  CMARK_ALLOC_NODE_SITE(mem, type);
+  node = (cmark_node *)mem->calloc(1, sizeof(*node));
   cmark_strbuf_init(mem, &node->content, 0);
   node->type = (uint16_t)type;
 
@@ -137,6 +136,14 @@ static void free_node_as(cmark_node *node) {
        cmark_chunk_free(NODE_MEM(node), &node->as.custom.on_enter);
        cmark_chunk_free(NODE_MEM(node), &node->as.custom.on_exit);
        break;
+     case CMARK_NODE_DOCUMENT:
+       if (node->as.document.profile) {
+         NODE_MEM(node)->free(node->as.document.profile);
+         node->as.document.profile = NULL;
+       }
+       cmark_reference_map_free(node->as.document.refmap);
+       node->as.document.refmap = NULL;
+       break;
      default:
        break;
   }
@@ -172,6 +179,34 @@ void cmark_node_free(cmark_node *node) {
   S_free_nodes(node);
 }
 
+void cmark_node_chunks(cmark_node *node, cmark_chunk **a, cmark_chunk **b) {
+  *a = *b = NULL;
+  switch (node->type) {
+  case CMARK_NODE_TEXT:
+  case CMARK_NODE_HTML_INLINE:
+  case CMARK_NODE_CODE:
+  case CMARK_NODE_HTML_BLOCK:
+    *a = &node->as.literal;
+    break;
+  case CMARK_NODE_CODE_BLOCK:
+    *a = &node->as.code.info;
+    *b = &node->as.code.literal;
+    break;
+  case CMARK_NODE_LINK:
+  case CMARK_NODE_IMAGE:
+    *a = &node->as.link.url;
+    *b = &node->as.link.title;
+    break;
+  case CMARK_NODE_CUSTOM_BLOCK:
+  case CMARK_NODE_CUSTOM_INLINE:
+    *a = &node->as.custom.on_enter;
+    *b = &node->as.custom.on_exit;
+    break;
+  default:
+    break;
+  }
+}
+
 cmark_node_type cmark_node_get_type(cmark_node *node) {
   if (node == NULL) {
     return CMARK_NODE_NONE;
@@ -185,6 +220,9 @@ bool cmark_node_set_type(cmark_node * node, cmark_node_type type) {
     return true;
 
   free_node_as(node);
+  // Nothing of the old type may be read as data of the new one, such
+  // as a document's profile.
+  memset(&node->as, 0, sizeof(node->as));
   node->type = type;
   return true;
 }
@@ -293,6 +331,17 @@ cmark_node *cmark_node_last_child(cmark_node *node) {
   }
 }
 
+bool cmark_node_get_profile(cmark_node *node, cmark_profile *profile) {
+  cmark_profile *recorded = node ? cmark_node_profile(node) : NULL;
+
+  if (recorded == NULL) {
+    memset(profile, 0, sizeof(*profile));
+    return false;
+  }
+  *profile = *recorded;
+  return true;
+}
+
 void *cmark_node_get_user_data(cmark_node *node) {
   if (node == NULL) {
     return NULL;
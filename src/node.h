@@ -93,14 +93,31 @@ struct cmark_node {
     cmark_table table;
     cmark_table_row table_row;
     int html_block_type;
+    struct {
+      cmark_profile *profile; /* see cmark_parser_set_profiler */
+      struct cmark_reference_map *refmap; /* see CMARK_OPT_INCREMENTAL */
+    } document;
   } as;
 };
 
 static CMARK_INLINE cmark_mem *cmark_node_mem(cmark_node *node) {
   return node->content.mem;
 }
+// The profile recorded for 'node' if it is a profiled document.
+static CMARK_INLINE cmark_profile *cmark_node_profile(cmark_node *node) {
+  return node->type == CMARK_NODE_DOCUMENT ? node->as.document.profile : NULL;
+}
+
 CMARK_EXPORT int cmark_node_check(cmark_node *node, FILE *out);
 
+// Whether a node of 'child_type' may be a child of 'node', following
+// the rules of cmark_node_append_child.
+bool cmark_node_can_contain_type(cmark_node *node, cmark_node_type child_type);
+
+// The chunks holding the text of 'node' for its type, if any, in '*a'
+// and '*b'.
+void cmark_node_chunks(cmark_node *node, cmark_chunk **a, cmark_chunk **b);
+
 #ifdef __cplusplus
 }
 #endif
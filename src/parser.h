@@ -47,8 +47,62 @@ struct cmark_parser {
   bool last_buffer_ended_with_cr;
   cmark_llist *syntax_extensions;
   cmark_llist *inline_syntax_extensions;
+  /* Characters that stop a run of literal text: the core set plus the
+   * special characters of every attached inline extension */
+  int8_t special_chars[256];
+  /* For each byte, the extensions whose 'try_opening_block' should be
+   * tried on a line whose first non-space character is that byte.  NULL
+   * until an extension with 'try_opening_block' is attached. */
+  cmark_llist **block_dispatch;
+  /* For each byte, the inline extensions that listed it in
+   * 'special_inline_chars', or listed none.  NULL until an inline
+   * extension is attached. */
+  cmark_llist **inline_dispatch;
+  /* Collects cmark_parser_stats; NULL unless the parser was created with
+   * the instrumented allocator. */
+  struct cmark_stats_collector *stats;
+  /* See cmark_parser_set_limits(); 'has_limits' is set if any is non-zero */
+  cmark_parser_limits limits;
+  bool has_limits;
+  /* Work done on the current document, counted against 'limits' */
+  size_t num_nodes;
+  size_t num_delimiter_steps;
+  /* The limit the current document ran into, after which the rest of it
+   * is skipped, and the limit the last finished document ran into */
+  cmark_parser_error error;
+  cmark_parser_error finished_error;
+  /* See cmark_parser_set_profiler() */
+  bool profiling;
 };
 
+/* Discard the document being parsed and start an empty one, keeping the
+ * attached extensions and the capacity of the parser's buffers.
+ */
+void cmark_parser_reset(cmark_parser *parser);
+
+/* The profile of the document being parsed, which is created on first
+ * use, or NULL if profiling is off.
+ */
+cmark_profile *cmark_parser_profile(cmark_parser *parser);
+
+/* Record in parser->error whether a limit has been exceeded.  Returns
+ * true if parsing must stop.
+ */
+bool cmark_parser_check_limits(cmark_parser *parser);
+
+/* Parse the inline content of the blocks under 'root' again against
+ * 'refmap', replacing the inlines they had.
+ */
+void cmark_parser_reparse_inlines(cmark_parser *parser, cmark_node *root,
+                                  struct cmark_reference_map *refmap);
+
+/* Feed the remaining contents of 'f' to 'parser'.  If 'map' is true,
+ * regular files are mapped into memory and fed as a single span where
+ * possible; a file that is truncated meanwhile then raises SIGBUS.
+ * Otherwise, and for pipes and terminals, 'f' is read in chunks.
+ */
+void cmark_parser_feed_file(cmark_parser *parser, FILE *f, bool map);
+
 #ifdef __cplusplus
 }
 #endif
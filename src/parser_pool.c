@@ -0,0 +1,118 @@
+#include <stdlib.h>
+
+#include "cmark.h"
+#include "parser.h"
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#define LOCK(pool) pthread_mutex_lock(&(pool)->lock)
+#define UNLOCK(pool) pthread_mutex_unlock(&(pool)->lock)
+#else
+#define LOCK(pool)
+#define UNLOCK(pool)
+#endif
+
+/* Idle parsers are kept on a stack, so the one checked out next is the
+ * one returned most recently and the most likely to still be in cache.
+ * 'options' and 'extensions' are fixed once the first parser has been
+ * created, which is what lets checkout configure new parsers without
+ * holding the lock.
+ */
+struct cmark_parser_pool {
+  cmark_mem *mem;
+  int options;
+  cmark_llist *extensions;
+  bool started;
+  cmark_parser **idle;
+  size_t n_idle;
+  size_t idle_size;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock;
+#endif
+};
+
+cmark_parser_pool *cmark_parser_pool_new_with_mem(int options, cmark_mem *mem) {
+  cmark_parser_pool *pool =
+      (cmark_parser_pool *)mem->calloc(1, sizeof(cmark_parser_pool));
+  pool->mem = mem;
+  pool->options = options;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&pool->lock, NULL);
+#endif
+  return pool;
+}
+
+cmark_parser_pool *cmark_parser_pool_new(int options) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  return cmark_parser_pool_new_with_mem(options, &DEFAULT_MEM_ALLOCATOR);
+}
+
+void cmark_parser_pool_free(cmark_parser_pool *pool) {
+  size_t i;
+
+  if (pool == NULL)
+    return;
+
+  for (i = 0; i < pool->n_idle; i++)
+    cmark_parser_free(pool->idle[i]);
+  pool->mem->free(pool->idle);
+  cmark_llist_free_full(pool->extensions,
+                        (CMarkListFreeFunc) cmark_syntax_extension_free);
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_destroy(&pool->lock);
+#endif
+  pool->mem->free(pool);
+}
+
+bool cmark_parser_pool_attach_syntax_extension(cmark_parser_pool *pool,
+                                               cmark_syntax_extension *extension) {
+  bool res = false;
+
+  LOCK(pool);
+  if (!pool->started) {
+    pool->extensions = cmark_llist_append(pool->extensions,
+                                          cmark_syntax_extension_ref(extension));
+    res = true;
+  }
+  UNLOCK(pool);
+  return res;
+}
+
+cmark_parser *cmark_parser_pool_checkout(cmark_parser_pool *pool) {
+  cmark_parser *parser = NULL;
+  cmark_llist *tmp;
+
+  LOCK(pool);
+  pool->started = true;
+  if (pool->n_idle > 0)
+    parser = pool->idle[--pool->n_idle];
+  UNLOCK(pool);
+
+  if (parser)
+    return parser;
+
+  parser = cmark_parser_new_with_mem(pool->options, pool->mem);
+  for (tmp = pool->extensions; tmp; tmp = tmp->next)
+    cmark_parser_attach_syntax_extension(parser,
+                                         (cmark_syntax_extension *)tmp->data);
+  return parser;
+}
+
+void cmark_parser_pool_return(cmark_parser_pool *pool, cmark_parser *parser) {
+  if (parser == NULL)
+    return;
+
+  // Drop whatever the caller left behind: a document that was fed but
+  // not finished, or references added with cmark_parser_add_reference.
+  cmark_parser_reset(parser);
+
+  LOCK(pool);
+  if (pool->n_idle == pool->idle_size) {
+    size_t new_size = pool->idle_size ? 2 * pool->idle_size : 8;
+    pool->idle = (cmark_parser **)pool->mem->realloc(
+        pool->idle, new_size * sizeof(cmark_parser *));
+    pool->idle_size = new_size;
+  }
+  pool->idle[pool->n_idle++] = parser;
+  UNLOCK(pool);
+}
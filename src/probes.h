@@ -0,0 +1,52 @@
+#ifndef CMARK_PROBES_H
+#define CMARK_PROBES_H
+
+#include "cmark.h"
+
+#ifdef HAVE_USDT
+#include <sys/sdt.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Static tracepoints in the "cmark" provider, for tracing a slow
+ * document with bpftrace, perf or SystemTap without rebuilding.  They
+ * are compiled in only when the library is configured with CMARK_USDT,
+ * and are then a single nop each until a tracer attaches.
+ *
+ *   block__open(type, line, column)      a block is added to the tree
+ *   block__close(type, start_line, end_line)
+ *                                        a block is finalized
+ *   inline__start(char, offset, line)    parse_inline dispatches on char
+ *   inline__done(char, offset, line)     ... and is at offset after it
+ *   emphasis__start(line)                process_emphasis is entered
+ *   emphasis__done(line, steps)          ... and has taken steps in all
+ *   reference__create(label, url)        a definition is added
+ *   reference__lookup(label, found)      a label is looked up
+ *   render__start(phase)                 a renderer is entered
+ *   render__done(phase, bytes)           ... and has written bytes
+ *
+ * Labels and URLs are NUL-terminated strings, labels normalized;
+ * phase is a cmark_phase.
+ */
+#ifdef HAVE_USDT
+
+#define CMARK_PROBE1(name, a) DTRACE_PROBE1(cmark, name, a)
+#define CMARK_PROBE2(name, a, b) DTRACE_PROBE2(cmark, name, a, b)
+#define CMARK_PROBE3(name, a, b, c) DTRACE_PROBE3(cmark, name, a, b, c)
+
+#else
+
+#define CMARK_PROBE1(name, a) ((void)0)
+#define CMARK_PROBE2(name, a, b) ((void)0)
+#define CMARK_PROBE3(name, a, b, c) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
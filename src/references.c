@@ -4,6 +4,7 @@
 #include "references.h"
 #include "inlines.h"
 #include "chunk.h"
+#include "probes.h"
 
 static unsigned int refhash(const unsigned char *link_ref) {
   unsigned int hash = 0;
@@ -24,6 +25,13 @@ static void reference_free(cmark_reference_map *map, cmark_reference *ref) {
   }
 }
 
+// Case folding of an ASCII byte of a reference label, or 0 for
+// whitespace (as defined by cmark_isspace); bytes >= 0x80 are
+// handled by cmark_utf8proc_case_fold.
+static CMARK_INLINE unsigned char fold_ascii(unsigned char c) {
+  return cmark_isspace((char)c) ? 0 : (unsigned char)cmark_tolower((char)c);
+}
+
 // normalize reference:  collapse internal whitespace to single space,
 // remove leading/trailing whitespace, case fold
 // Return NULL if the reference name is actually empty (i.e. composed
@@ -31,6 +39,8 @@ static void reference_free(cmark_reference_map *map, cmark_reference *ref) {
 static unsigned char *normalize_reference(cmark_mem *mem, cmark_chunk *ref) {
   cmark_strbuf normalized = CMARK_BUF_INIT(mem);
   unsigned char *result;
+  bufsize_t r, org;
+  bool pending_space = false;
 
   if (ref == NULL)
     return NULL;
@@ -38,9 +48,46 @@ static unsigned char *normalize_reference(cmark_mem *mem, cmark_chunk *ref) {
   if (ref->len == 0)
     return NULL;
 
-  cmark_utf8proc_case_fold(&normalized, ref->data, ref->len);
-  cmark_strbuf_trim(&normalized);
-  cmark_strbuf_normalize_whitespace(&normalized);
+  cmark_strbuf_grow(&normalized, ref->len);
+
+  // Everything is done in a single pass.  ASCII bytes are folded
+  // through fold_ascii(); runs of non-ASCII bytes go through the
+  // full Unicode case folding.  A pending space is only emitted
+  // once something follows it, which trims both ends.
+  r = 0;
+  while (r < ref->len) {
+    unsigned char c = ref->data[r];
+
+    if (c < 0x80) {
+      unsigned char folded = fold_ascii(c);
+      r++;
+
+      if (folded == 0) {
+        pending_space = normalized.size > 0;
+        continue;
+      }
+
+      // Room for a pending space, the folded byte and the terminator.
+      if (normalized.size + 2 >= normalized.asize)
+        cmark_strbuf_grow(&normalized, normalized.size + 2);
+      if (pending_space) {
+        normalized.ptr[normalized.size++] = ' ';
+        pending_space = false;
+      }
+      normalized.ptr[normalized.size++] = folded;
+    } else {
+      org = r;
+      while (r < ref->len && ref->data[r] >= 0x80)
+        r++;
+
+      if (pending_space) {
+        cmark_strbuf_putc(&normalized, ' ');
+        pending_space = false;
+      }
+      cmark_utf8proc_case_fold(&normalized, ref->data + org, r - org);
+    }
+  }
+  normalized.ptr[normalized.size] = '\0';
 
   result = cmark_strbuf_detach(&normalized);
   assert(result);
@@ -53,19 +100,64 @@ static unsigned char *normalize_reference(cmark_mem *mem, cmark_chunk *ref) {
   return result;
 }
 
-static void add_reference(cmark_reference_map *map, cmark_reference *ref) {
-  cmark_reference *t = ref->next = map->table[ref->hash % REFMAP_SIZE];
+static void keep_definition(cmark_reference_map *map, cmark_reference *ref) {
+  if (map->num_defs == map->defs_size) {
+    size_t new_size = map->defs_size ? map->defs_size * 2 : 16;
+    CMARK_ALLOC_SITE(map->mem, CMARK_ALLOC_REFERENCE);
+    map->defs = (cmark_reference **)map->mem->realloc(
+        map->defs, new_size * sizeof(*map->defs));
+    map->defs_size = new_size;
+  }
+  map->defs[map->num_defs++] = ref;
+}
 
-  while (t) {
-    if (t->hash == ref->hash && !strcmp((char *)t->label, (char *)ref->label)) {
-      reference_free(map, ref);
-      return;
-    }
+static bool same_label(cmark_reference *a, cmark_reference *b) {
+  return a->hash == b->hash && !strcmp((char *)a->label, (char *)b->label);
+}
 
-    t = t->next;
+// Make 'ref' the definition of its label, unless the label is already
+// defined.  A map that keeps its definitions may be given them out of
+// order, so that the one on the earliest line wins.  Returns false if
+// 'ref' is not in the table.
+static bool table_insert(cmark_reference_map *map, cmark_reference *ref) {
+  cmark_reference **slot = &map->table[ref->hash % REFMAP_SIZE];
+  cmark_reference *t;
+
+  for (; (t = *slot) != NULL; slot = &t->next) {
+    if (same_label(t, ref)) {
+      if (!map->keep_definitions || ref->line >= t->line)
+        return false;
+      ref->next = t->next;
+      t->next = NULL;
+      *slot = ref;
+      return true;
+    }
   }
 
+  ref->next = map->table[ref->hash % REFMAP_SIZE];
   map->table[ref->hash % REFMAP_SIZE] = ref;
+  return true;
+}
+
+// Returns false if 'ref' is not in the table.
+static bool table_remove(cmark_reference_map *map, cmark_reference *ref) {
+  cmark_reference **slot = &map->table[ref->hash % REFMAP_SIZE];
+
+  for (; *slot != NULL; slot = &(*slot)->next) {
+    if (*slot == ref) {
+      *slot = ref->next;
+      ref->next = NULL;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void add_reference(cmark_reference_map *map, cmark_reference *ref) {
+  if (map->keep_definitions)
+    keep_definition(map, ref);
+  if (!table_insert(map, ref) && !map->keep_definitions)
+    reference_free(map, ref);
 }
 
 void cmark_reference_create(cmark_reference_map *map, cmark_chunk *label,
@@ -77,16 +169,179 @@ void cmark_reference_create(cmark_reference_map *map, cmark_chunk *label,
   if (reflabel == NULL)
     return;
 
+  CMARK_ALLOC_SITE(map->mem, CMARK_ALLOC_REFERENCE);
   ref = (cmark_reference *)map->mem->calloc(1, sizeof(*ref));
   ref->label = reflabel;
   ref->hash = refhash(ref->label);
   ref->url = cmark_clean_url(map->mem, url);
   ref->title = cmark_clean_title(map->mem, title);
   ref->next = NULL;
+  ref->line = map->line;
 
+  CMARK_PROBE2(reference__create, ref->label, ref->url.data);
   add_reference(map, ref);
 }
 
+cmark_reference **cmark_reference_map_cut(cmark_reference_map *map,
+                                          int from, int to, int delta,
+                                          size_t *num_cut) {
+  cmark_mem *mem = map->mem;
+  cmark_reference **cut, *ref;
+  size_t i, j, n = 0, kept = 0;
+
+  for (i = 0; i < map->num_defs; i++) {
+    if (map->defs[i]->line >= from && map->defs[i]->line < to)
+      n++;
+  }
+  cut = (cmark_reference **)mem->calloc(n ? n : 1, sizeof(*cut));
+  n = 0;
+  for (i = 0; i < map->num_defs; i++) {
+    ref = map->defs[i];
+    if (ref->line >= from && ref->line < to) {
+      cut[n++] = ref;
+    } else {
+      if (ref->line >= to)
+        ref->line += delta;
+      map->defs[kept++] = ref;
+    }
+  }
+  map->num_defs = kept;
+
+  // A label that loses its definition falls to the next one left.
+  for (i = 0; i < n; i++) {
+    if (!table_remove(map, cut[i]))
+      continue;
+    for (j = 0; j < map->num_defs; j++) {
+      if (same_label(map->defs[j], cut[i])) {
+        table_insert(map, map->defs[j]);
+        break;
+      }
+    }
+  }
+
+  *num_cut = n;
+  return cut;
+}
+
+void cmark_reference_map_splice(cmark_reference_map *map,
+                                cmark_reference_map *from) {
+  size_t i, at = map->num_defs, n = from->num_defs;
+
+  if (n == 0)
+    return;
+  while (at > 0 && map->defs[at - 1]->line >= from->defs[0]->line)
+    at--;
+  if (map->num_defs + n > map->defs_size) {
+    CMARK_ALLOC_SITE(map->mem, CMARK_ALLOC_REFERENCE);
+    map->defs = (cmark_reference **)map->mem->realloc(
+        map->defs, (map->num_defs + n) * sizeof(*map->defs));
+    map->defs_size = map->num_defs + n;
+  }
+  memmove(map->defs + at + n, map->defs + at,
+          (map->num_defs - at) * sizeof(*map->defs));
+  for (i = 0; i < n; i++) {
+    cmark_reference *ref = from->defs[i];
+
+    map->defs[at + i] = ref;
+    ref->next = NULL;
+    table_insert(map, ref);
+  }
+  map->num_defs += n;
+
+  from->num_defs = 0;
+  memset(from->table, 0, sizeof(from->table));
+}
+
+void cmark_reference_list_free(cmark_reference_map *map,
+                               cmark_reference **refs, size_t num) {
+  size_t i;
+
+  for (i = 0; i < num; i++)
+    reference_free(map, refs[i]);
+  map->mem->free(refs);
+}
+
+// Whether 'ref' normalizes to 'label', as normalize_reference() would
+// have it, or -1 if that takes more than ASCII case folding to tell.
+static int ascii_label_matches(cmark_chunk *ref, const unsigned char *label) {
+  bool pending_space = false, started = false;
+  bufsize_t r;
+
+  for (r = 0; r < ref->len; r++) {
+    unsigned char c = ref->data[r], folded;
+
+    if (c >= 0x80)
+      return -1;
+    folded = fold_ascii(c);
+    if (folded == 0) {
+      pending_space = started;
+      continue;
+    }
+    if (pending_space) {
+      if (*label++ != ' ')
+        return 0;
+      pending_space = false;
+    }
+    if (*label++ != folded)
+      return 0;
+    started = true;
+  }
+  return *label == '\0';
+}
+
+bool cmark_reference_mentions(cmark_mem *mem, const unsigned char *text,
+                              bufsize_t len, cmark_reference **refs,
+                              size_t num) {
+  bufsize_t i, j;
+  size_t k;
+
+  for (i = 0; i < len; i++) {
+    if (text[i] != '[')
+      continue;
+    // A label has no unescaped brackets in it.
+    for (j = i + 1; j < len && text[j] != '[' && text[j] != ']'; j++) {
+      if (text[j] == '\\' && j + 1 < len)
+        j++;
+    }
+    if (j < len && text[j] == ']' && j - i - 1 <= MAX_LINK_LABEL_LENGTH) {
+      cmark_chunk label = {(unsigned char *)text + i + 1, j - i - 1, 0};
+      unsigned char *norm;
+      int ascii;
+
+      for (k = 0; k < num; k++) {
+        ascii = ascii_label_matches(&label, refs[k]->label);
+        if (ascii < 0)
+          break;
+        if (ascii)
+          return true;
+      }
+      if (k == num)
+        continue;
+
+      norm = normalize_reference(mem, &label);
+      if (norm == NULL)
+        continue;
+      for (k = 0; k < num; k++) {
+        if (!strcmp((char *)norm, (char *)refs[k]->label))
+          break;
+      }
+      mem->free(norm);
+      if (k < num)
+        return true;
+    }
+  }
+  return false;
+}
+
+bool cmark_reference_equal(cmark_reference *a, cmark_reference *b) {
+  return a->hash == b->hash && a->url.len == b->url.len &&
+         a->title.len == b->title.len &&
+         !strcmp((char *)a->label, (char *)b->label) &&
+         (a->url.len == 0 || !memcmp(a->url.data, b->url.data, a->url.len)) &&
+         (a->title.len == 0 ||
+          !memcmp(a->title.data, b->title.data, a->title.len));
+}
+
 // Returns reference if refmap contains a reference with matching
 // label, otherwise NULL.
 cmark_reference *cmark_reference_lookup(cmark_reference_map *map,
@@ -114,16 +369,25 @@ cmark_reference *cmark_reference_lookup(cmark_reference_map *map,
     ref = ref->next;
   }
 
+  CMARK_PROBE2(reference__lookup, norm, ref != NULL);
   map->mem->free(norm);
   return ref;
 }
 
-void cmark_reference_map_free(cmark_reference_map *map) {
-  unsigned int i;
+void cmark_reference_map_clear(cmark_reference_map *map) {
+  size_t i;
 
   if (map == NULL)
     return;
 
+  if (map->keep_definitions) {
+    for (i = 0; i < map->num_defs; ++i)
+      reference_free(map, map->defs[i]);
+    map->num_defs = 0;
+    memset(map->table, 0, sizeof(map->table));
+    return;
+  }
+
   for (i = 0; i < REFMAP_SIZE; ++i) {
     cmark_reference *ref = map->table[i];
     cmark_reference *next;
@@ -133,14 +397,23 @@ void cmark_reference_map_free(cmark_reference_map *map) {
       reference_free(map, ref);
       ref = next;
     }
+    map->table[i] = NULL;
   }
+}
+
+void cmark_reference_map_free(cmark_reference_map *map) {
+  if (map == NULL)
+    return;
 
+  cmark_reference_map_clear(map);
+  map->mem->free(map->defs);
   map->mem->free(map);
 }
 
 cmark_reference_map *cmark_reference_map_new(cmark_mem *mem) {
-  cmark_reference_map *map =
-      (cmark_reference_map *)mem->calloc(1, sizeof(cmark_reference_map));
+  cmark_reference_map *map;
+  CMARK_ALLOC_SITE(mem, CMARK_ALLOC_REFERENCE);
+  map = (cmark_reference_map *)mem->calloc(1, sizeof(cmark_reference_map));
   map->mem = mem;
   return map;
 }
@@ -16,6 +16,8 @@ struct cmark_reference {
   cmark_chunk url;
   cmark_chunk title;
   unsigned int hash;
+  /* The line of the paragraph it was defined in, or 0 */
+  int line;
 };
 
 typedef struct cmark_reference cmark_reference;
@@ -23,16 +25,48 @@ typedef struct cmark_reference cmark_reference;
 struct cmark_reference_map {
   cmark_mem *mem;
   cmark_reference *table[REFMAP_SIZE];
+  /* The line given to new definitions */
+  int line;
+  /* If set, every definition, including those whose label was already
+   * defined, is also kept in 'defs' in the order it was made, and the
+   * map is kept with the document; see CMARK_OPT_INCREMENTAL.  'defs'
+   * then owns the references in 'table'. */
+  bool keep_definitions;
+  cmark_reference **defs;
+  size_t num_defs;
+  size_t defs_size;
 };
 
 typedef struct cmark_reference_map cmark_reference_map;
 
 cmark_reference_map *cmark_reference_map_new(cmark_mem *mem);
 void cmark_reference_map_free(cmark_reference_map *map);
+/* Remove every reference, keeping the map itself for reuse. */
+void cmark_reference_map_clear(cmark_reference_map *map);
 cmark_reference *cmark_reference_lookup(cmark_reference_map *map,
                                         cmark_chunk *label);
 extern void cmark_reference_create(cmark_reference_map *map, cmark_chunk *label,
                                    cmark_chunk *url, cmark_chunk *title);
+/* Take the definitions made on lines from 'from' to before 'to' out
+ * of a map that keeps its definitions, and move those on later lines
+ * by 'delta' lines.  Returns the definitions taken, in order, and their
+ * number in '*num_cut'; free them with cmark_reference_list_free(). */
+cmark_reference **cmark_reference_map_cut(cmark_reference_map *map,
+                                          int from, int to, int delta,
+                                          size_t *num_cut);
+/* Move the definitions of 'from' into 'map', both keeping their
+ * definitions, in order of their lines. */
+void cmark_reference_map_splice(cmark_reference_map *map,
+                                cmark_reference_map *from);
+void cmark_reference_list_free(cmark_reference_map *map,
+                               cmark_reference **refs, size_t num);
+/* Whether the 'len' bytes at 'text' have a label in brackets that is
+ * the label of one of the 'num' references in 'refs'. */
+bool cmark_reference_mentions(cmark_mem *mem, const unsigned char *text,
+                              bufsize_t len, cmark_reference **refs,
+                              size_t num);
+/* Whether 'a' and 'b' define the same label as the same link. */
+bool cmark_reference_equal(cmark_reference *a, cmark_reference *b);
 
 #ifdef __cplusplus
 }
@@ -7,12 +7,176 @@
 #include "cmark.h"
 #include "registry.h"
 #include "plugin.h"
+#include "cmark_atomic.h"
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK() pthread_mutex_lock(&registry_lock)
+#define UNLOCK() pthread_mutex_unlock(&registry_lock)
+#else
+#define LOCK()
+#define UNLOCK()
+#endif
 
+/* Registration happens under registry_lock and ends by publishing a new
+ * immutable table.  Lookups only read the published table, so they need
+ * no lock and may run concurrently with each other and with a
+ * registration.  Tables that have been replaced are kept until
+ * cmark_release_plugins, since a reader may still be using one.
+ */
+typedef struct {
+  size_t count;
+  size_t mask;
+  cmark_syntax_extension **slots; /* open addressing, mask + 1 entries */
+  cmark_syntax_extension **list;  /* registration order */
+} registry_table;
+
+/* A dynamic library and the extensions that were registered from it. */
+typedef struct {
+  void *libhandle;
+  cmark_llist *extensions;
+} loaded_plugin;
+
+/* Guarded by registry_lock. */
 static cmark_llist *syntax_extensions = NULL;
 static cmark_llist *plugin_handles = NULL;
+static cmark_llist *retired_tables = NULL;
+static bool builtins_registered = false;
+
+static registry_table *published = NULL;
+static int plugins_discovered = 0;
+
+#ifdef HAVE_BUILTIN_EXTENSIONS
+bool init_libcmarkextensions(cmark_plugin *plugin);
+#endif
+
+static size_t hash_name(const char *name) {
+  size_t h = 2166136261u;
+
+  while (*name)
+    h = (h ^ (unsigned char)*name++) * 16777619u;
+  return h;
+}
+
+static cmark_syntax_extension *table_lookup(const registry_table *table,
+                                            const char *name) {
+  size_t i;
+
+  if (table == NULL)
+    return NULL;
+
+  for (i = hash_name(name) & table->mask; table->slots[i];
+       i = (i + 1) & table->mask) {
+    if (!strcmp(table->slots[i]->name, name))
+      return table->slots[i];
+  }
+  return NULL;
+}
+
+static void table_free(void *data) {
+  registry_table *table = (registry_table *) data;
+
+  free(table->slots);
+  free(table->list);
+  free(table);
+}
 
-static cmark_plugin *scan_file(char* filename) {
+// Freeze the current registrations into a new table and make it the one
+// that lookups see.
+static void publish_table(void) {
+  registry_table *table = (registry_table *) calloc(1, sizeof(*table));
+  registry_table *old = published;
+  cmark_llist *tmp;
+  size_t size = 8;
+
+  for (tmp = syntax_extensions; tmp; tmp = tmp->next)
+    table->count++;
+  while (size < 2 * table->count)
+    size *= 2;
+
+  table->mask = size - 1;
+  table->slots = (cmark_syntax_extension **) calloc(size, sizeof(*table->slots));
+  table->list = (cmark_syntax_extension **) calloc(table->count + 1,
+                                                   sizeof(*table->list));
+  table->count = 0;
+
+  for (tmp = syntax_extensions; tmp; tmp = tmp->next) {
+    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
+    size_t i = hash_name(ext->name) & table->mask;
+
+    while (table->slots[i])
+      i = (i + 1) & table->mask;
+    table->slots[i] = ext;
+    table->list[table->count++] = ext;
+  }
+
+  cmark_atomic_store(&published, table);
+  if (old)
+    retired_tables = cmark_llist_append(retired_tables, old);
+}
+
+static cmark_syntax_extension *find_registered(const char *name) {
+  cmark_llist *tmp;
+
+  for (tmp = syntax_extensions; tmp; tmp = tmp->next) {
+    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
+    if (!strcmp(ext->name, name))
+      return ext;
+  }
+  return NULL;
+}
+
+// Move the plugin's extensions into the registry, remembering which
+// library they came from.  An extension whose name is already taken
+// (e.g. a core extension that is also installed as a plugin) is dropped,
+// so the first registration wins.
+static void register_plugin(cmark_plugin *plugin, void *libhandle) {
+  cmark_llist *syntax_extensions_list = cmark_plugin_steal_syntax_extensions(plugin);
+  cmark_llist *tmp;
+  loaded_plugin *loaded = NULL;
+
+  if (libhandle) {
+    loaded = (loaded_plugin *) calloc(1, sizeof(*loaded));
+    loaded->libhandle = libhandle;
+    plugin_handles = cmark_llist_append(plugin_handles, loaded);
+  }
+
+  for (tmp = syntax_extensions_list; tmp; tmp=tmp->next) {
+    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
+    if (find_registered(ext->name)) {
+      cmark_syntax_extension_free(ext);
+    } else {
+      syntax_extensions = cmark_llist_append(syntax_extensions, ext);
+      if (loaded)
+        loaded->extensions = cmark_llist_append(loaded->extensions, ext);
+    }
+  }
+
+  cmark_llist_free(syntax_extensions_list);
+  cmark_plugin_free(plugin);
+}
+
+void cmark_register_builtin_extensions(void) {
+#ifdef HAVE_BUILTIN_EXTENSIONS
+  cmark_plugin *plugin;
+
+  LOCK();
+  if (!builtins_registered) {
+    builtins_registered = true;
+
+    plugin = cmark_plugin_new();
+    if (init_libcmarkextensions(plugin))
+      register_plugin(plugin, NULL);
+    else
+      cmark_plugin_free(plugin);
+    publish_table();
+  }
+  UNLOCK();
+#endif
+}
+
+static cmark_plugin *scan_file(char* filename, void **handle) {
   char* last_slash = strrchr(filename, '/');
   char* name_start = last_slash ? last_slash + 1 : filename;
   char* last_dot = strrchr(filename, '.');
@@ -55,7 +219,7 @@ static cmark_plugin *scan_file(char* filename) {
 
   if (initfunc) {
     if (initfunc(plugin)) {
-      plugin_handles = cmark_llist_append(plugin_handles, libhandle);
+      *handle = libhandle;
     } else {
       cmark_plugin_free(plugin);
       printf("Error Initializing plugin %s\n", name_start);
@@ -79,61 +243,100 @@ static void scan_path(char *path) {
     return;
 
   while ((direntry = readdir(dir))) {
-    cmark_plugin *plugin = scan_file(direntry->d_name);
-    if (plugin) {
-      cmark_llist *syntax_extensions_list = cmark_plugin_steal_syntax_extensions(plugin);
-      cmark_llist *tmp;
-
-      for (tmp = syntax_extensions_list; tmp; tmp=tmp->next) {
-        syntax_extensions = cmark_llist_append(syntax_extensions, tmp->data);
-      }
-
-      cmark_llist_free(syntax_extensions_list);
-      cmark_plugin_free(plugin);
-    }
+    void *libhandle = NULL;
+    cmark_plugin *plugin = scan_file(direntry->d_name, &libhandle);
+    if (plugin)
+      register_plugin(plugin, libhandle);
   }
 
  closedir(dir);
 }
 
 void cmark_discover_plugins(void) {
-  cmark_release_plugins();
-  scan_path(EXTENSION_DIR);
+  if (cmark_atomic_load(&plugins_discovered))
+    return;
+
+  LOCK();
+  if (!plugins_discovered) {
+    scan_path(EXTENSION_DIR);
+    publish_table();
+    cmark_atomic_store(&plugins_discovered, 1);
+  }
+  UNLOCK();
 }
 
-static void
-release_plugin_handle(void *libhandle) {
-  dlclose(libhandle);
+// A library can only be unloaded once nothing but the registry refers to
+// its extensions; otherwise a parser that is still alive would be left
+// calling into unmapped code.
+static bool plugin_in_use(loaded_plugin *loaded) {
+  cmark_llist *tmp;
+
+  for (tmp = loaded->extensions; tmp; tmp = tmp->next) {
+    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
+    if (cmark_atomic_load(&ext->refcount) > 1)
+      return true;
+  }
+  return false;
 }
 
 void cmark_release_plugins(void) {
-  if (syntax_extensions) {
-    cmark_llist_free_full(syntax_extensions,
-        (CMarkListFreeFunc) cmark_syntax_extension_free);
-    syntax_extensions = NULL;
-  }
+  cmark_llist *closable = NULL;
+  cmark_llist *tmp;
+
+  LOCK();
 
-  cmark_llist_free_full(plugin_handles, release_plugin_handle);
+  for (tmp = plugin_handles; tmp; tmp = tmp->next) {
+    loaded_plugin *loaded = (loaded_plugin *) tmp->data;
+    if (!plugin_in_use(loaded))
+      closable = cmark_llist_append(closable, loaded->libhandle);
+    cmark_llist_free(loaded->extensions);
+    free(loaded);
+  }
+  cmark_llist_free(plugin_handles);
   plugin_handles = NULL;
+
+  // Drop the registry's references; extensions still attached to a
+  // parser stay alive until that parser is freed.
+  cmark_llist_free_full(syntax_extensions,
+      (CMarkListFreeFunc) cmark_syntax_extension_free);
+  syntax_extensions = NULL;
+
+  for (tmp = closable; tmp; tmp = tmp->next)
+    dlclose(tmp->data);
+  cmark_llist_free(closable);
+
+  if (published)
+    table_free(published);
+  cmark_atomic_store(&published, (registry_table *) NULL);
+  cmark_llist_free_full(retired_tables, table_free);
+  retired_tables = NULL;
+
+  builtins_registered = false;
+  cmark_atomic_store(&plugins_discovered, 0);
+
+  UNLOCK();
 }
 
 cmark_llist *cmark_list_syntax_extensions(void) {
-  cmark_llist *tmp;
+  registry_table *table;
   cmark_llist *res = NULL;
+  size_t i;
 
-  for (tmp = syntax_extensions; tmp; tmp = tmp->next) {
-    res = cmark_llist_append(res, tmp->data);
-  }
+  cmark_discover_plugins();
+
+  table = cmark_atomic_load(&published);
+  for (i = 0; table && i < table->count; i++)
+    res = cmark_llist_append(res, table->list[i]);
   return res;
 }
 
 cmark_syntax_extension *cmark_find_syntax_extension(const char *name) {
-  cmark_llist *tmp;
+  cmark_syntax_extension *ext =
+      table_lookup(cmark_atomic_load(&published), name);
 
-  for (tmp = syntax_extensions; tmp; tmp = tmp->next) {
-    cmark_syntax_extension *ext = (cmark_syntax_extension *) tmp->data;
-    if (!strcmp(ext->name, name))
-      return ext;
+  if (ext == NULL && !cmark_atomic_load(&plugins_discovered)) {
+    cmark_discover_plugins();
+    ext = table_lookup(cmark_atomic_load(&published), name);
   }
-  return NULL;
+  return ext;
 }
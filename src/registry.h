@@ -7,6 +7,7 @@ extern "C" {
 
 #include "cmark.h"
 
+/* Scan EXTENSION_DIR for plugins, unless that has already been done. */
 void cmark_discover_plugins(void);
 void cmark_release_plugins(void);
 cmark_llist *cmark_list_syntax_extensions(void);
@@ -5,6 +5,9 @@
 #include "utf8.h"
 #include "render.h"
 #include "node.h"
+#include "cmark_clock.h"
+#include "work.h"
+#include "probes.h"
 
 static CMARK_INLINE void S_cr(cmark_renderer *renderer) {
   if (renderer->need_cr < 1) {
@@ -143,6 +146,7 @@ void cmark_render_code_point(cmark_renderer *renderer, uint32_t c) {
 }
 
 char *cmark_render(cmark_node *root, int options, int width,
+                   cmark_phase phase,
                    void (*outc)(cmark_renderer *, cmark_escaping, int32_t,
                                 unsigned char),
                    int (*render_node)(cmark_renderer *renderer,
@@ -154,12 +158,15 @@ char *cmark_render(cmark_node *root, int options, int width,
   cmark_node *cur;
   cmark_event_type ev_type;
   char *result;
+  cmark_profile *profile = cmark_node_profile(root);
+  uint64_t start = profile ? cmark_clock_ns() : 0;
   cmark_iter *iter = cmark_iter_new(root);
 
   cmark_renderer renderer = {mem,   &buf, &pref, 0,           width,
                              0,     0,    true,  true,        false,
                              false, outc, S_cr,  S_blankline, S_out};
 
+  CMARK_PROBE1(render__start, phase);
   while ((ev_type = cmark_iter_next(iter)) != CMARK_EVENT_DONE) {
     cur = cmark_iter_get_node(iter);
     if (!render_node(&renderer, cur, ev_type, options)) {
@@ -175,11 +182,15 @@ char *cmark_render(cmark_node *root, int options, int width,
     cmark_strbuf_putc(renderer.buffer, '\n');
   }
 
+  CMARK_PROBE2(render__done, phase, renderer.buffer->size);
+  CMARK_COUNT_WORK_UNITS(output_bytes, renderer.buffer->size);
   result = (char *)cmark_strbuf_detach(renderer.buffer);
 
   cmark_iter_free(iter);
   cmark_strbuf_release(renderer.prefix);
   cmark_strbuf_release(renderer.buffer);
 
+  if (profile)
+    cmark_profile_add(profile, phase, start, cmark_clock_ns());
   return result;
 }
@@ -36,7 +36,9 @@ void cmark_render_ascii(cmark_renderer *renderer, const char *s);
 
 void cmark_render_code_point(cmark_renderer *renderer, uint32_t c);
 
+// Render 'root', adding the time taken to 'phase' of its profile.
 char *cmark_render(cmark_node *root, int options, int width,
+                   cmark_phase phase,
                    void (*outc)(cmark_renderer *, cmark_escaping, int32_t,
                                 unsigned char),
                    int (*render_node)(cmark_renderer *renderer,
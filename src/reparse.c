@@ -0,0 +1,338 @@
+#include <limits.h>
+#include <string.h>
+
+#include "cmark.h"
+#include "node.h"
+#include "parser.h"
+#include "references.h"
+
+/* When a line is parsed, the only top-level block that can still change
+ * is the last one; every one before it has been finalized.  After an
+ * edit, parsing is therefore restarted at the last top-level block
+ * that starts on a line before the edit, with a parser that numbers its
+ * lines from there, and it goes on past the edit until it starts a
+ * top-level block on a line where the old tree started one of the same
+ * type.  From that line on, both the text and the state of the parser
+ * are what they were, so the rest of the old blocks are kept and only
+ * their line numbers are shifted.
+ *
+ * That holds only for blocks started when no other block was open: a
+ * list, for one, stays open over the line that ends it, and the way a
+ * line is parsed depends on the open block it is tried in.  A block
+ * that is open when the next one starts ends on the line before, so
+ * blocks that follow another without a line between them are not
+ * parsing starts, nor points at which it can stop.
+ *
+ * The inlines of every block depend on the reference definitions of the
+ * whole document, which it keeps with it for this (see
+ * CMARK_OPT_INCREMENTAL); those of the section parsed again are swapped
+ * for the new ones in place.  If they differ, the blocks that are kept
+ * and mention one of their labels have their inlines parsed again.  A
+ * document that has not kept its definitions is parsed in full.
+ */
+
+// The length of the line at 'p', including its line ending.
+static size_t line_length(const char *p, const char *end, bool has_cr) {
+  const char *q = p;
+
+  if (!has_cr) {
+    q = (const char *)memchr(p, '\n', (size_t)(end - p));
+    return q ? (size_t)(q + 1 - p) : (size_t)(end - p);
+  }
+  while (q < end && *q != '\n' && *q != '\r')
+    q++;
+  if (q < end && *q == '\r' && q + 1 < end && q[1] == '\n')
+    q += 2;
+  else if (q < end)
+    q++;
+  return (size_t)(q - p);
+}
+
+// The numbers of the lines that contain the bytes at 'offset' and at
+// 'end_offset', and the number of lines in 'text', counted as the
+// parser does.
+static void count_lines(const char *text, size_t len, bool has_cr,
+                        size_t offset, size_t end_offset, int *line,
+                        int *end_line, int *num_lines) {
+  const char *p = text, *end = text + len;
+  int n = 0;
+
+  *line = *end_line = 0;
+  while (p < end) {
+    p += line_length(p, end, has_cr);
+    n++;
+    if (*line == 0 && (size_t)(p - text) > offset)
+      *line = n;
+    if (*end_line == 0 && (size_t)(p - text) > end_offset)
+      *end_line = n;
+  }
+  if (*line == 0)
+    *line = n + 1;
+  if (*end_line == 0)
+    *end_line = n + 1;
+  *num_lines = n;
+}
+
+static void shift_lines(cmark_node *block, int delta) {
+  cmark_node *node = block;
+
+  while (node) {
+    // Some inlines are given no position at all.
+    if (node->start_line != 0) {
+      node->start_line += delta;
+      node->end_line += delta;
+    }
+    if (node->first_child) {
+      node = node->first_child;
+      continue;
+    }
+    while (node != block && node->next == NULL)
+      node = node->parent;
+    node = node == block ? NULL : node->next;
+  }
+}
+
+// Whether the content of a block under 'block' mentions the label of
+// one of the 'num' references in 'refs'.
+static bool mentions(cmark_node *block, cmark_reference **refs, size_t num) {
+  cmark_node *node = block;
+
+  while (node) {
+    if (node->content.size > 0 &&
+        cmark_reference_mentions(cmark_node_mem(block), node->content.ptr,
+                                 node->content.size, refs, num))
+      return true;
+    if (node->first_child) {
+      node = node->first_child;
+      continue;
+    }
+    while (node != block && node->next == NULL)
+      node = node->parent;
+    node = node == block ? NULL : node->next;
+  }
+  return false;
+}
+
+// The first definition of the label of 'ref' among the 'num' in 'defs'.
+static cmark_reference *first_definition(cmark_reference **defs, size_t num,
+                                         cmark_reference *ref) {
+  size_t i;
+
+  for (i = 0; i < num; i++) {
+    if (defs[i]->hash == ref->hash &&
+        !strcmp((char *)defs[i]->label, (char *)ref->label))
+      return defs[i];
+  }
+  return NULL;
+}
+
+// The definitions among 'old' and 'new' whose labels the section no
+// longer defines as it did; since the rest of the document is the
+// same, these are the only labels that can now be resolved otherwise.
+static cmark_reference **changed_labels(cmark_mem *mem, cmark_reference **old,
+                                        size_t num_old, cmark_reference **new,
+                                        size_t num_new, size_t *num_changed) {
+  cmark_reference **changed, *a, *b;
+  size_t i, n = 0;
+
+  changed = (cmark_reference **)mem->calloc(num_old + num_new + 1,
+                                            sizeof(*changed));
+  for (i = 0; i < num_old + num_new; i++) {
+    cmark_reference *ref = i < num_old ? old[i] : new[i - num_old];
+
+    a = first_definition(old, num_old, ref);
+    b = first_definition(new, num_new, ref);
+    if (a == NULL || b == NULL || !cmark_reference_equal(a, b))
+      changed[n++] = ref;
+  }
+  *num_changed = n;
+  return changed;
+}
+
+// Whether no block was open when the top-level 'block' was started.
+static bool follows_gap(cmark_node *block) {
+  return block->prev == NULL || block->prev->end_line < block->start_line - 1;
+}
+
+cmark_node *cmark_parser_reparse(cmark_parser *parser, cmark_node *root,
+                                 const char *text, size_t len,
+                                 size_t edit_start, size_t edit_old_len,
+                                 size_t edit_new_len) {
+  cmark_reference_map *refmap, *region_refmap = parser->refmap;
+  cmark_reference **old_defs = NULL, **new_defs = NULL, **changed;
+  cmark_node *first = NULL, *resync = NULL, *fresh, *first_new, *node;
+  const char *p, *end = text + len;
+  bool has_cr = memchr(text, '\r', len) != NULL;
+  int edit_line, edit_end_line, num_lines, delta, start_line, i;
+  int new_end = INT_MAX;
+  size_t num_old_defs = 0, num_new_defs = 0, num_changed, d;
+
+  if (root == NULL || root->type != CMARK_NODE_DOCUMENT ||
+      edit_start > len || edit_new_len > len - edit_start ||
+      parser->root == NULL || parser->root->first_child != NULL ||
+      parser->line_number != 0 || parser->linebuf.size != 0)
+    return NULL;
+
+  if (edit_old_len == 0 && edit_new_len == 0)
+    return root;
+
+  refmap = root->as.document.refmap;
+  count_lines(text, len, has_cr, edit_start ? edit_start - 1 : 0,
+              edit_start + edit_new_len, &edit_line, &edit_end_line,
+              &num_lines);
+  delta = num_lines - root->end_line;
+
+  // Parsing starts again at the last top-level block that starts
+  // before the edit.  If there is none, there may still have been a
+  // paragraph of definitions, which leaves no block behind, so it starts
+  // at the top, as it does if the definitions are unknown.
+  if (refmap) {
+    for (node = root->first_child; node && node->start_line < edit_line;
+         node = node->next)
+      first = node;
+  }
+  while (first && !follows_gap(first))
+    first = first->prev;
+  start_line = first ? first->start_line : 1;
+  if (first == NULL)
+    first = root->first_child;
+
+  // The line before is parsed and what it opened thrown away, since the
+  // position at which a block is closed can depend on it.
+  p = text;
+  for (i = 2; i < start_line && p < end; i++)
+    p += line_length(p, end, has_cr);
+  parser->refmap->keep_definitions = true;
+  if (start_line > 1) {
+    size_t n = line_length(p, end, has_cr);
+
+    parser->line_number = start_line - 2;
+    cmark_parser_feed(parser, p, n);
+    p += n;
+    while (parser->root->first_child)
+      cmark_node_free(parser->root->first_child);
+    parser->current = parser->root;
+  }
+
+  node = first;
+  while (p < end) {
+    size_t n = line_length(p, end, has_cr);
+    cmark_node *last;
+
+    cmark_parser_feed(parser, p, n);
+    p += n;
+    last = parser->root->last_child;
+    if (refmap == NULL || parser->line_number <= edit_end_line + 1 ||
+        last == NULL || last->start_line != parser->line_number ||
+        !follows_gap(last) || (p[-1] != '\n' && p[-1] != '\r'))
+      continue;
+
+    // A block has just been started on this line, and neither it nor
+    // the line before, at whose end a block can be closed, was edited;
+    // see whether the old tree started one on the same line.
+    while (node && node->start_line < parser->line_number - delta)
+      node = node->next;
+    if (node && node->start_line == parser->line_number - delta &&
+        node->type == last->type && follows_gap(node)) {
+      resync = node;
+      break;
+    }
+  }
+
+  if (resync) {
+    new_end = parser->line_number;
+    cmark_node_free(parser->root->last_child);
+    parser->current = parser->root;
+  }
+
+  // The definitions of the section are swapped for those found so far,
+  // and whatever is found when the last block is closed is added after.
+  if (refmap) {
+    old_defs = cmark_reference_map_cut(
+        refmap, start_line, resync ? resync->start_line : INT_MAX, delta,
+        &num_old_defs);
+    cmark_reference_map_splice(refmap, region_refmap);
+    root->as.document.refmap = NULL;
+    parser->refmap = refmap;
+  }
+
+  fresh = cmark_parser_finish(parser);
+
+  // Replace the blocks that were parsed again.
+  while (first && first != resync) {
+    node = first->next;
+    cmark_node_free(first);
+    first = node;
+  }
+  first_new = fresh->first_child;
+  while ((node = fresh->first_child) != NULL) {
+    if (resync)
+      cmark_node_insert_before(resync, node);
+    else
+      cmark_node_append_child(root, node);
+  }
+  if (delta != 0) {
+    for (node = resync; node; node = node->next)
+      shift_lines(node, delta);
+  }
+
+  root->as.document.refmap = fresh->as.document.refmap;
+  fresh->as.document.refmap = NULL;
+  if (root->as.document.profile)
+    parser->mem->free(root->as.document.profile);
+  root->as.document.profile = fresh->as.document.profile;
+  fresh->as.document.profile = NULL;
+  if (resync) {
+    root->end_line += delta;
+  } else {
+    root->end_line = fresh->end_line;
+    root->end_column = fresh->end_column;
+  }
+  cmark_node_free(fresh);
+
+  if (refmap == NULL)
+    return root;
+  cmark_reference_map_free(region_refmap);
+
+  // The definitions the section made before and after.
+  for (d = 0; d < refmap->num_defs && refmap->defs[d]->line < start_line; d++)
+    ;
+  new_defs = refmap->defs + d;
+  while (d < refmap->num_defs && refmap->defs[d]->line < new_end) {
+    num_new_defs++;
+    d++;
+  }
+
+  changed = changed_labels(parser->mem, old_defs, num_old_defs, new_defs,
+                           num_new_defs, &num_changed);
+  if (num_changed > 0) {
+    for (node = root->first_child; node; node = node->next) {
+      if (node == first_new) {
+        while (node->next && node->next != resync)
+          node = node->next;
+        continue;
+      }
+      if (mentions(node, changed, num_changed))
+        cmark_parser_reparse_inlines(parser, node, refmap);
+    }
+  }
+  parser->mem->free(changed);
+  cmark_reference_list_free(refmap, old_defs, num_old_defs);
+
+  return root;
+}
+
+cmark_node *cmark_reparse(cmark_node *root, const char *text, size_t len,
+                          size_t edit_start, size_t edit_old_len,
+                          size_t edit_new_len, int options) {
+  cmark_parser *parser;
+  cmark_node *result;
+
+  if (root == NULL)
+    return NULL;
+  parser = cmark_parser_new_with_mem(options, cmark_node_mem(root));
+  result = cmark_parser_reparse(parser, root, text, len, edit_start,
+                                edit_old_len, edit_new_len);
+  cmark_parser_free(parser);
+  return result;
+}
@@ -2,33 +2,38 @@
 #include <stdlib.h>
 #include "chunk.h"
 #include "scanners.h"
+#include "work.h"
 
-bufsize_t _scan_at(bufsize_t (*scanner)(const unsigned char *), cmark_chunk *c,
-                   bufsize_t offset) {
-  bufsize_t res;
-  unsigned char *ptr = (unsigned char *)c->data;
+/* The scanners use re2c's generic input API, so that every read is
+ * checked against the end of the input instead of relying on a NUL
+ * sentinel.  Bytes past the end read as '\0', which no rule below
+ * accepts.  The input is never written to, so it can live in
+ * read-only memory and be scanned from several threads at once.
+ */
+#define YYPEEK() (p < end ? *p : 0)
+#define YYSKIP() (CMARK_COUNT_WORK_UNITS(scanned_bytes, 1), ++p)
+#define YYBACKUP() marker = p
+#define YYRESTORE() p = marker
+#define YYBACKUPCTX() marker = p
+#define YYRESTORECTX() p = marker
 
-  if (ptr == NULL || offset > c->len) {
+bufsize_t _scan_at(bufsize_t (*scanner)(const unsigned char *, bufsize_t),
+                   cmark_chunk *c, bufsize_t offset) {
+  if (c->data == NULL || offset > c->len)
     return 0;
-  } else {
-    unsigned char lim = ptr[c->len];
 
-    ptr[c->len] = '\0';
-    res = scanner(ptr + offset);
-    ptr[c->len] = lim;
-  }
-
-  return res;
+  return scanner(c->data + offset, c->len - offset);
 }
 
 // Try to match a scheme including colon.
-bufsize_t _scan_scheme(const unsigned char *p) {
+bufsize_t _scan_scheme(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
   {
     unsigned char yych;
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= '@')
       goto yy2;
     if (yych <= 'Z')
@@ -38,10 +43,12 @@ bufsize_t _scan_scheme(const unsigned char *p) {
     if (yych <= 'z')
       goto yy4;
   yy2:
-    ++p;
+    YYSKIP();
   yy3 : { return 0; }
   yy4:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= '+') {
         if (yych <= '*')
@@ -66,7 +73,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
       }
     }
   yy5:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych == '+')
@@ -89,10 +97,11 @@ bufsize_t _scan_scheme(const unsigned char *p) {
       }
     }
   yy6:
-    p = marker;
+    YYRESTORE();
     goto yy3;
   yy7:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych == '+')
@@ -119,10 +128,11 @@ bufsize_t _scan_scheme(const unsigned char *p) {
       }
     }
   yy8:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   yy10:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -144,7 +154,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -166,7 +177,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -188,7 +200,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -210,7 +223,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -232,7 +246,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -254,7 +269,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -276,7 +292,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -298,7 +315,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -320,7 +338,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -342,7 +361,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -364,7 +384,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -386,7 +407,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -408,7 +430,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -430,7 +453,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -452,7 +476,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -474,7 +499,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -496,7 +522,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -518,7 +545,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -540,7 +568,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -562,7 +591,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -584,7 +614,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -606,7 +637,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -628,7 +660,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -650,7 +683,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -672,7 +706,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -694,7 +729,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -716,7 +752,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -738,7 +775,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
           goto yy6;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == ':')
       goto yy8;
     goto yy6;
@@ -746,7 +784,8 @@ bufsize_t _scan_scheme(const unsigned char *p) {
 }
 
 // Try to match URI autolink after first <, returning number of chars matched.
-bufsize_t _scan_autolink_uri(const unsigned char *p) {
+bufsize_t _scan_autolink_uri(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -773,7 +812,7 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
         0,   0,   0,   0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= '@')
       goto yy41;
     if (yych <= 'Z')
@@ -783,10 +822,12 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
     if (yych <= 'z')
       goto yy43;
   yy41:
-    ++p;
+    YYSKIP();
   yy42 : { return 0; }
   yy43:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= '+') {
         if (yych <= '*')
@@ -811,7 +852,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
       }
     }
   yy44:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych == '+')
@@ -834,10 +876,11 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
       }
     }
   yy45:
-    p = marker;
+    YYRESTORE();
     goto yy42;
   yy46:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych == '+')
@@ -864,7 +907,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
       }
     }
   yy47:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy47;
     }
@@ -898,7 +942,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
       }
     }
   yy49:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych == '+')
@@ -925,59 +970,67 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
       }
     }
   yy50:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   yy52:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy45;
     if (yych <= 0xBF)
       goto yy47;
     goto yy45;
   yy53:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy45;
     if (yych <= 0xBF)
       goto yy52;
     goto yy45;
   yy54:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy45;
     if (yych <= 0xBF)
       goto yy52;
     goto yy45;
   yy55:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy45;
     if (yych <= 0x9F)
       goto yy52;
     goto yy45;
   yy56:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy45;
     if (yych <= 0xBF)
       goto yy54;
     goto yy45;
   yy57:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy45;
     if (yych <= 0xBF)
       goto yy54;
     goto yy45;
   yy58:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy45;
     if (yych <= 0x8F)
       goto yy54;
     goto yy45;
   yy59:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -999,7 +1052,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1021,7 +1075,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1043,7 +1098,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1065,7 +1121,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1087,7 +1144,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1109,7 +1167,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1131,7 +1190,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1153,7 +1213,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1175,7 +1236,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1197,7 +1259,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1219,7 +1282,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1241,7 +1305,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1263,7 +1328,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1285,7 +1351,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1307,7 +1374,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1329,7 +1397,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1351,7 +1420,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1373,7 +1443,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1395,7 +1466,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1417,7 +1489,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1439,7 +1512,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1461,7 +1535,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1483,7 +1558,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1505,7 +1581,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1527,7 +1604,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1549,7 +1627,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= ',') {
         if (yych != '+')
@@ -1571,7 +1650,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
           goto yy45;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == ':')
       goto yy47;
     goto yy45;
@@ -1579,7 +1659,8 @@ bufsize_t _scan_autolink_uri(const unsigned char *p) {
 }
 
 // Try to match email autolink after first <, returning num of chars matched.
-bufsize_t _scan_autolink_email(const unsigned char *p) {
+bufsize_t _scan_autolink_email(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -1606,7 +1687,7 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
         0,   0,   0,   0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych <= '\'') {
         if (yych == '!')
@@ -1638,10 +1719,12 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy89:
-    ++p;
+    YYSKIP();
   yy90 : { return 0; }
   yy91:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= ',') {
       if (yych <= '"') {
         if (yych == '!')
@@ -1674,7 +1757,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy92:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy93:
     if (yybm[0 + yych] & 128) {
       goto yy92;
@@ -1684,10 +1768,11 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
     if (yych <= '@')
       goto yy95;
   yy94:
-    p = marker;
+    YYRESTORE();
     goto yy90;
   yy95:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '@') {
       if (yych <= '/')
         goto yy94;
@@ -1702,7 +1787,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
         goto yy94;
     }
   yy96:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -1731,7 +1817,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
         goto yy94;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy101;
@@ -1752,7 +1839,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy98:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -1783,10 +1871,11 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy99:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   yy101:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy103;
@@ -1807,7 +1896,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy102:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -1837,7 +1927,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy103:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy105;
@@ -1858,7 +1949,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy104:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -1888,7 +1980,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy105:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy107;
@@ -1909,7 +2002,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy106:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -1939,7 +2033,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy107:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy109;
@@ -1960,7 +2055,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy108:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -1990,7 +2086,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy109:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy111;
@@ -2011,7 +2108,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy110:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2041,7 +2139,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy111:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy113;
@@ -2062,7 +2161,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy112:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2092,7 +2192,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy113:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy115;
@@ -2113,7 +2214,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy114:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2143,7 +2245,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy115:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy117;
@@ -2164,7 +2267,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy116:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2194,7 +2298,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy117:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy119;
@@ -2215,7 +2320,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy118:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2245,7 +2351,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy119:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy121;
@@ -2266,7 +2373,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy120:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2296,7 +2404,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy121:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy123;
@@ -2317,7 +2426,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy122:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2347,7 +2457,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy123:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy125;
@@ -2368,7 +2479,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy124:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2398,7 +2510,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy125:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy127;
@@ -2419,7 +2532,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy126:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2449,7 +2563,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy127:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy129;
@@ -2470,7 +2585,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy128:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2500,7 +2616,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy129:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy131;
@@ -2521,7 +2638,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy130:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2551,7 +2669,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy131:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy133;
@@ -2572,7 +2691,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy132:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2602,7 +2722,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy133:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy135;
@@ -2623,7 +2744,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy134:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2653,7 +2775,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy135:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy137;
@@ -2674,7 +2797,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy136:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2704,7 +2828,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy137:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy139;
@@ -2725,7 +2850,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy138:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2755,7 +2881,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy139:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy141;
@@ -2776,7 +2903,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy140:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2806,7 +2934,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy141:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy143;
@@ -2827,7 +2956,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy142:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2857,7 +2987,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy143:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy145;
@@ -2878,7 +3009,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy144:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2908,7 +3040,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy145:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy147;
@@ -2929,7 +3062,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy146:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -2959,7 +3093,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy147:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy149;
@@ -2980,7 +3115,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy148:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3010,7 +3146,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy149:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy151;
@@ -3031,7 +3168,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy150:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3061,7 +3199,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy151:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy153;
@@ -3082,7 +3221,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy152:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3112,7 +3252,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy153:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy155;
@@ -3133,7 +3274,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy154:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3163,7 +3305,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy155:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy157;
@@ -3184,7 +3327,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy156:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3214,7 +3358,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy157:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy159;
@@ -3235,7 +3380,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy158:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3265,7 +3411,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy159:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy161;
@@ -3286,7 +3433,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy160:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3316,7 +3464,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy161:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy163;
@@ -3337,7 +3486,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy162:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3367,7 +3517,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy163:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy165;
@@ -3388,7 +3539,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy164:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3418,7 +3570,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy165:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy167;
@@ -3439,7 +3592,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy166:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3469,7 +3623,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy167:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy169;
@@ -3490,7 +3645,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy168:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3520,7 +3676,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy169:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy171;
@@ -3541,7 +3698,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy170:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3571,7 +3729,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy171:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy173;
@@ -3592,7 +3751,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy172:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3622,7 +3782,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy173:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy175;
@@ -3643,7 +3804,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy174:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3673,7 +3835,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy175:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy177;
@@ -3694,7 +3857,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy176:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3724,7 +3888,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy177:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy179;
@@ -3745,7 +3910,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy178:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3775,7 +3941,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy179:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy181;
@@ -3796,7 +3963,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy180:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3826,7 +3994,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy181:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy183;
@@ -3847,7 +4016,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy182:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3877,7 +4047,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy183:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy185;
@@ -3898,7 +4069,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy184:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3928,7 +4100,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy185:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy187;
@@ -3949,7 +4122,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy186:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -3979,7 +4153,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy187:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy189;
@@ -4000,7 +4175,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy188:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4030,7 +4206,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy189:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy191;
@@ -4051,7 +4228,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy190:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4081,7 +4259,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy191:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy193;
@@ -4102,7 +4281,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy192:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4132,7 +4312,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy193:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy195;
@@ -4153,7 +4334,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy194:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4183,7 +4365,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy195:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy197;
@@ -4204,7 +4387,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy196:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4234,7 +4418,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy197:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy199;
@@ -4255,7 +4440,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy198:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4285,7 +4471,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy199:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy201;
@@ -4306,7 +4493,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy200:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4336,7 +4524,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy201:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy203;
@@ -4357,7 +4546,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy202:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4387,7 +4577,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy203:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy205;
@@ -4408,7 +4599,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy204:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4438,7 +4630,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy205:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy207;
@@ -4459,7 +4652,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy206:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4489,7 +4683,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy207:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy209;
@@ -4510,7 +4705,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy208:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4540,7 +4736,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy209:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy211;
@@ -4561,7 +4758,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy210:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4591,7 +4789,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy211:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy213;
@@ -4612,7 +4811,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy212:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4642,7 +4842,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy213:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy215;
@@ -4663,7 +4864,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy214:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4693,7 +4895,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy215:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy217;
@@ -4714,7 +4917,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy216:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4744,7 +4948,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy217:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '9') {
       if (yych == '-')
         goto yy219;
@@ -4765,7 +4970,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy218:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= ',')
@@ -4795,7 +5001,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy219:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '@') {
       if (yych <= '/')
         goto yy94;
@@ -4812,7 +5019,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       goto yy94;
     }
   yy220:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= '.') {
         if (yych <= '-')
@@ -4838,7 +5046,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
       }
     }
   yy221:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == '.')
       goto yy95;
     if (yych == '>')
@@ -4848,7 +5057,8 @@ bufsize_t _scan_autolink_email(const unsigned char *p) {
 }
 
 // Try to match an HTML tag after first <, returning num of chars matched.
-bufsize_t _scan_html_tag(const unsigned char *p) {
+bufsize_t _scan_html_tag(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -4888,7 +5098,7 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
         0, 0, 0, 0, 0, 0, 0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= '>') {
       if (yych <= '!') {
         if (yych >= '!')
@@ -4911,10 +5121,12 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy224:
-    ++p;
+    YYSKIP();
   yy225 : { return 0; }
   yy226:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[256 + yych] & 32) {
       goto yy232;
     }
@@ -4926,7 +5138,9 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       goto yy234;
     goto yy225;
   yy227:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '@')
       goto yy225;
     if (yych <= 'Z')
@@ -4937,7 +5151,9 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       goto yy235;
     goto yy225;
   yy228:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x00)
       goto yy225;
     if (yych <= 0x7F)
@@ -4948,7 +5164,9 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       goto yy238;
     goto yy225;
   yy229:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '.') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -4981,14 +5199,16 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy230:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == '-')
       goto yy254;
   yy231:
-    p = marker;
+    YYRESTORE();
     goto yy225;
   yy232:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[256 + yych] & 32) {
       goto yy232;
     }
@@ -5000,14 +5220,16 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       goto yy255;
     goto yy231;
   yy234:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy257;
     if (yych == 'c')
       goto yy257;
     goto yy231;
   yy235:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[256 + yych] & 64) {
       goto yy235;
     }
@@ -5025,7 +5247,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       goto yy231;
     }
   yy237:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy238:
     if (yybm[256 + yych] & 128) {
       goto yy237;
@@ -5058,7 +5281,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
         goto yy231;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0xE0) {
       if (yych <= '>') {
         if (yych <= 0x00)
@@ -5090,56 +5314,64 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy240:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy237;
     goto yy231;
   yy241:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy240;
     goto yy231;
   yy242:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy240;
     goto yy231;
   yy243:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x9F)
       goto yy240;
     goto yy231;
   yy244:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy242;
     goto yy231;
   yy245:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy242;
     goto yy231;
   yy246:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x8F)
       goto yy242;
     goto yy231;
   yy247:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 1) {
       goto yy247;
     }
@@ -5171,7 +5403,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy249:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy250:
     if (yybm[0 + yych] & 1) {
       goto yy247;
@@ -5204,21 +5437,24 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy251:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych != '>')
       goto yy231;
   yy252:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   yy254:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == '-')
       goto yy264;
     if (yych == '>')
       goto yy231;
     goto yy263;
   yy255:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 2) {
       goto yy255;
     }
@@ -5252,14 +5488,16 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy257:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy279;
     if (yych == 'd')
       goto yy279;
     goto yy231;
   yy258:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych <= 0x08)
         goto yy231;
@@ -5274,7 +5512,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       goto yy231;
     }
   yy260:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 4) {
       goto yy260;
     }
@@ -5302,7 +5541,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy262:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy263:
     if (yybm[0 + yych] & 8) {
       goto yy262;
@@ -5337,119 +5577,136 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy264:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == '-')
       goto yy251;
     if (yych == '>')
       goto yy231;
     goto yy263;
   yy265:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy262;
     goto yy231;
   yy266:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy265;
     goto yy231;
   yy267:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy265;
     goto yy231;
   yy268:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x9F)
       goto yy265;
     goto yy231;
   yy269:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy267;
     goto yy231;
   yy270:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy267;
     goto yy231;
   yy271:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x8F)
       goto yy267;
     goto yy231;
   yy272:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy255;
     goto yy231;
   yy273:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy272;
     goto yy231;
   yy274:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy272;
     goto yy231;
   yy275:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x9F)
       goto yy272;
     goto yy231;
   yy276:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy274;
     goto yy231;
   yy277:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy274;
     goto yy231;
   yy278:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x8F)
       goto yy274;
     goto yy231;
   yy279:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy285;
     if (yych == 'a')
       goto yy285;
     goto yy231;
   yy280:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '<') {
       if (yych <= ' ') {
         if (yych <= 0x08)
@@ -5494,7 +5751,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy282:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy286;
     }
@@ -5530,7 +5788,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy284:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 8) {
       goto yy262;
     }
@@ -5564,14 +5823,16 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy285:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy299;
     if (yych == 't')
       goto yy299;
     goto yy231;
   yy286:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy286;
     }
@@ -5607,7 +5868,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy288:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy288;
     }
@@ -5641,7 +5903,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy290:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy290;
     }
@@ -5675,63 +5938,72 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy292:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy286;
     goto yy231;
   yy293:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy292;
     goto yy231;
   yy294:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy292;
     goto yy231;
   yy295:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x9F)
       goto yy292;
     goto yy231;
   yy296:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy294;
     goto yy231;
   yy297:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy294;
     goto yy231;
   yy298:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x8F)
       goto yy294;
     goto yy231;
   yy299:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy315;
     if (yych == 'a')
       goto yy315;
     goto yy231;
   yy300:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 1) {
       goto yy247;
     }
@@ -5741,109 +6013,125 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       goto yy252;
     goto yy231;
   yy301:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy288;
     goto yy231;
   yy302:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy301;
     goto yy231;
   yy303:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy301;
     goto yy231;
   yy304:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x9F)
       goto yy301;
     goto yy231;
   yy305:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy303;
     goto yy231;
   yy306:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy303;
     goto yy231;
   yy307:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x8F)
       goto yy303;
     goto yy231;
   yy308:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy290;
     goto yy231;
   yy309:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy308;
     goto yy231;
   yy310:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy308;
     goto yy231;
   yy311:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x9F)
       goto yy308;
     goto yy231;
   yy312:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy310;
     goto yy231;
   yy313:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy310;
     goto yy231;
   yy314:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x8F)
       goto yy310;
     goto yy231;
   yy315:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych != '[')
       goto yy231;
   yy316:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy316;
     }
@@ -5875,7 +6163,8 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
         goto yy231;
       }
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy316;
     }
@@ -5909,56 +6198,64 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
       }
     }
   yy319:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy316;
     goto yy231;
   yy320:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy319;
     goto yy231;
   yy321:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy319;
     goto yy231;
   yy322:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x9F)
       goto yy319;
     goto yy231;
   yy323:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy321;
     goto yy231;
   yy324:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0xBF)
       goto yy321;
     goto yy231;
   yy325:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy231;
     if (yych <= 0x8F)
       goto yy321;
     goto yy231;
   yy326:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0xE0) {
       if (yych <= '>') {
         if (yych <= 0x00)
@@ -5996,18 +6293,21 @@ bufsize_t _scan_html_tag(const unsigned char *p) {
 // Try to match an HTML block tag start line, returning
 // an integer code for the type of block (1-6, matching the spec).
 // #7 is handled by a separate function, below.
-bufsize_t _scan_html_block_start(const unsigned char *p) {
+bufsize_t _scan_html_block_start(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
 
   {
     unsigned char yych;
-    yych = *p;
+    yych = YYPEEK();
     if (yych == '<')
       goto yy331;
-    ++p;
+    YYSKIP();
   yy330 : { return 0; }
   yy331:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     switch (yych) {
     case '!':
       goto yy332;
@@ -6064,7 +6364,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       goto yy330;
     }
   yy332:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '@') {
       if (yych == '-')
         goto yy352;
@@ -6075,10 +6376,11 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
         goto yy355;
     }
   yy333:
-    p = marker;
+    YYRESTORE();
     goto yy330;
   yy334:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     switch (yych) {
     case 'A':
     case 'a':
@@ -6129,10 +6431,11 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       goto yy333;
     }
   yy335:
-    ++p;
+    YYSKIP();
     { return 3; }
   yy337:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'S') {
       if (yych <= 'D') {
         if (yych <= 'C')
@@ -6159,7 +6462,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy338:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'O') {
       if (yych <= 'K') {
         if (yych == 'A')
@@ -6186,7 +6490,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy339:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'O') {
       if (yych <= 'D') {
         if (yych == 'A')
@@ -6213,7 +6518,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy340:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     switch (yych) {
     case 'D':
     case 'L':
@@ -6232,7 +6538,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       goto yy333;
     }
   yy341:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'R') {
       if (yych <= 'N') {
         if (yych == 'I')
@@ -6259,7 +6566,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy342:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'S') {
       if (yych <= 'D') {
         if (yych <= '0')
@@ -6290,14 +6598,16 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy343:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'F')
       goto yy375;
     if (yych == 'f')
       goto yy375;
     goto yy333;
   yy344:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'I') {
       if (yych == 'E')
         goto yy376;
@@ -6316,7 +6626,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy345:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'E') {
       if (yych == 'A')
         goto yy378;
@@ -6335,7 +6646,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy346:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'O') {
       if (yych == 'A')
         goto yy380;
@@ -6354,7 +6666,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy347:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'P') {
       if (yych == 'L')
         goto yy367;
@@ -6373,7 +6686,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy348:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '>') {
       if (yych <= ' ') {
         if (yych <= 0x08)
@@ -6410,7 +6724,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy349:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     switch (yych) {
     case 'C':
     case 'c':
@@ -6431,7 +6746,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       goto yy333;
     }
   yy350:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     switch (yych) {
     case 'A':
     case 'a':
@@ -6458,29 +6774,33 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       goto yy333;
     }
   yy351:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy367;
     if (yych == 'l')
       goto yy367;
     goto yy333;
   yy352:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == '-')
       goto yy399;
     goto yy333;
   yy353:
-    ++p;
+    YYSKIP();
     { return 4; }
   yy355:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy401;
     if (yych == 'c')
       goto yy401;
     goto yy333;
   yy356:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -6509,7 +6829,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy357:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'U') {
       if (yych <= 'N') {
         if (yych == 'E')
@@ -6536,70 +6857,80 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy358:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy402;
     if (yych == 'd')
       goto yy402;
     goto yy333;
   yy359:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy403;
     if (yych == 't')
       goto yy403;
     goto yy333;
   yy360:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy404;
     if (yych == 'i')
       goto yy404;
     goto yy333;
   yy361:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'S')
       goto yy405;
     if (yych == 's')
       goto yy405;
     goto yy333;
   yy362:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy406;
     if (yych == 'o')
       goto yy406;
     goto yy333;
   yy363:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy407;
     if (yych == 'd')
       goto yy407;
     goto yy333;
   yy364:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'P')
       goto yy408;
     if (yych == 'p')
       goto yy408;
     goto yy333;
   yy365:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'N')
       goto yy409;
     if (yych == 'n')
       goto yy409;
     goto yy333;
   yy366:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy410;
     if (yych == 'l')
       goto yy410;
     goto yy333;
   yy367:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ' ') {
       if (yych <= 0x08)
         goto yy333;
@@ -6620,14 +6951,16 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy368:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy411;
     if (yych == 't')
       goto yy411;
     goto yy333;
   yy369:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'V') {
       if (yych <= 'Q') {
         if (yych == 'A')
@@ -6654,7 +6987,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy370:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'G') {
       if (yych == 'E')
         goto yy413;
@@ -6673,7 +7007,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy371:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'R') {
       if (yych == 'O')
         goto yy409;
@@ -6692,42 +7027,48 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy372:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy416;
     if (yych == 'a')
       goto yy416;
     goto yy333;
   yy373:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy417;
     if (yych == 'a')
       goto yy417;
     goto yy333;
   yy374:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy351;
     if (yych == 'm')
       goto yy351;
     goto yy333;
   yy375:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy418;
     if (yych == 'r')
       goto yy418;
     goto yy333;
   yy376:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'G')
       goto yy419;
     if (yych == 'g')
       goto yy419;
     goto yy333;
   yy377:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -6756,120 +7097,137 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy378:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy421;
     if (yych == 'i')
       goto yy421;
     goto yy333;
   yy379:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'N')
       goto yy422;
     if (yych == 'n')
       goto yy422;
     goto yy333;
   yy380:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'V')
       goto yy367;
     if (yych == 'v')
       goto yy367;
     goto yy333;
   yy381:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'F')
       goto yy423;
     if (yych == 'f')
       goto yy423;
     goto yy333;
   yy382:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy424;
     if (yych == 't')
       goto yy424;
     goto yy333;
   yy383:
-    ++p;
+    YYSKIP();
     { return 6; }
   yy385:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == '>')
       goto yy383;
     goto yy333;
   yy386:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy425;
     if (yych == 'r')
       goto yy425;
     goto yy333;
   yy387:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy426;
     if (yych == 'e')
       goto yy426;
     goto yy333;
   yy388:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy427;
     if (yych == 'r')
       goto yy427;
     goto yy333;
   yy389:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy408;
     if (yych == 'c')
       goto yy408;
     goto yy333;
   yy390:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'U')
       goto yy428;
     if (yych == 'u')
       goto yy428;
     goto yy333;
   yy391:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'Y')
       goto yy429;
     if (yych == 'y')
       goto yy429;
     goto yy333;
   yy392:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy430;
     if (yych == 'm')
       goto yy430;
     goto yy333;
   yy393:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'B')
       goto yy431;
     if (yych == 'b')
       goto yy431;
     goto yy333;
   yy394:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy363;
     if (yych == 'o')
       goto yy363;
     goto yy333;
   yy395:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy432;
     if (yych == 'o')
       goto yy432;
     goto yy333;
   yy396:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -6898,14 +7256,16 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy397:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy431;
     if (yych == 't')
       goto yy431;
     goto yy333;
   yy398:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -6934,73 +7294,83 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy399:
-    ++p;
+    YYSKIP();
     { return 2; }
   yy401:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy435;
     if (yych == 'd')
       goto yy435;
     goto yy333;
   yy402:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy436;
     if (yych == 'r')
       goto yy436;
     goto yy333;
   yy403:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy437;
     if (yych == 'i')
       goto yy437;
     goto yy333;
   yy404:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy438;
     if (yych == 'd')
       goto yy438;
     goto yy333;
   yy405:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy439;
     if (yych == 'e')
       goto yy439;
     goto yy333;
   yy406:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy440;
     if (yych == 'c')
       goto yy440;
     goto yy333;
   yy407:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'Y')
       goto yy367;
     if (yych == 'y')
       goto yy367;
     goto yy333;
   yy408:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy441;
     if (yych == 't')
       goto yy441;
     goto yy333;
   yy409:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy442;
     if (yych == 't')
       goto yy442;
     goto yy333;
   yy410:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -7029,28 +7399,32 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy411:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy444;
     if (yych == 'a')
       goto yy444;
     goto yy333;
   yy412:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy445;
     if (yych == 'l')
       goto yy445;
     goto yy333;
   yy413:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy446;
     if (yych == 'l')
       goto yy446;
     goto yy333;
   yy414:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'U') {
       if (yych == 'C')
         goto yy447;
@@ -7069,70 +7443,80 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy415:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy367;
     if (yych == 'm')
       goto yy367;
     goto yy333;
   yy416:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy449;
     if (yych == 'm')
       goto yy449;
     goto yy333;
   yy417:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy450;
     if (yych == 'd')
       goto yy450;
     goto yy333;
   yy418:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy451;
     if (yych == 'a')
       goto yy451;
     goto yy333;
   yy419:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy452;
     if (yych == 'e')
       goto yy452;
     goto yy333;
   yy420:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'K')
       goto yy367;
     if (yych == 'k')
       goto yy367;
     goto yy333;
   yy421:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'N')
       goto yy367;
     if (yych == 'n')
       goto yy367;
     goto yy333;
   yy422:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'U')
       goto yy453;
     if (yych == 'u')
       goto yy453;
     goto yy333;
   yy423:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy454;
     if (yych == 'r')
       goto yy454;
     goto yy333;
   yy424:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'I') {
       if (yych == 'G')
         goto yy443;
@@ -7151,14 +7535,16 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy425:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy415;
     if (yych == 'a')
       goto yy415;
     goto yy333;
   yy426:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych <= 0x08)
         goto yy333;
@@ -7173,91 +7559,104 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       goto yy333;
     }
   yy427:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy458;
     if (yych == 'i')
       goto yy458;
     goto yy333;
   yy428:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy459;
     if (yych == 'r')
       goto yy459;
     goto yy333;
   yy429:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy387;
     if (yych == 'l')
       goto yy387;
     goto yy333;
   yy430:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy460;
     if (yych == 'm')
       goto yy460;
     goto yy333;
   yy431:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy438;
     if (yych == 'l')
       goto yy438;
     goto yy333;
   yy432:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy461;
     if (yych == 'o')
       goto yy461;
     goto yy333;
   yy433:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy462;
     if (yych == 'a')
       goto yy462;
     goto yy333;
   yy434:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy420;
     if (yych == 'c')
       goto yy420;
     goto yy333;
   yy435:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy463;
     if (yych == 'a')
       goto yy463;
     goto yy333;
   yy436:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy464;
     if (yych == 'e')
       goto yy464;
     goto yy333;
   yy437:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy431;
     if (yych == 'c')
       goto yy431;
     goto yy333;
   yy438:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy367;
     if (yych == 'e')
       goto yy367;
     goto yy333;
   yy439:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -7286,77 +7685,88 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy440:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'K')
       goto yy466;
     if (yych == 'k')
       goto yy466;
     goto yy333;
   yy441:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy455;
     if (yych == 'i')
       goto yy455;
     goto yy333;
   yy442:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy467;
     if (yych == 'e')
       goto yy467;
     goto yy333;
   yy443:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy468;
     if (yych == 'r')
       goto yy468;
     goto yy333;
   yy444:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy469;
     if (yych == 'i')
       goto yy469;
     goto yy333;
   yy445:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy470;
     if (yych == 'o')
       goto yy470;
     goto yy333;
   yy446:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy471;
     if (yych == 'd')
       goto yy471;
     goto yy333;
   yy447:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy364;
     if (yych == 'a')
       goto yy364;
     goto yy333;
   yy448:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy438;
     if (yych == 'r')
       goto yy438;
     goto yy333;
   yy449:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy472;
     if (yych == 'e')
       goto yy472;
     goto yy333;
   yy450:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -7385,21 +7795,24 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy451:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy438;
     if (yych == 'm')
       goto yy438;
     goto yy333;
   yy452:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'N')
       goto yy462;
     if (yych == 'n')
       goto yy462;
     goto yy333;
   yy453:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -7428,122 +7841,139 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy454:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy474;
     if (yych == 'a')
       goto yy474;
     goto yy333;
   yy455:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy421;
     if (yych == 'o')
       goto yy421;
     goto yy333;
   yy456:
-    ++p;
+    YYSKIP();
     { return 1; }
   yy458:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'P')
       goto yy475;
     if (yych == 'p')
       goto yy475;
     goto yy333;
   yy459:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy438;
     if (yych == 'c')
       goto yy438;
     goto yy333;
   yy460:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy476;
     if (yych == 'a')
       goto yy476;
     goto yy333;
   yy461:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy367;
     if (yych == 't')
       goto yy367;
     goto yy333;
   yy462:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'D')
       goto yy367;
     if (yych == 'd')
       goto yy367;
     goto yy333;
   yy463:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy477;
     if (yych == 't')
       goto yy477;
     goto yy333;
   yy464:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'S')
       goto yy478;
     if (yych == 's')
       goto yy478;
     goto yy333;
   yy465:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy479;
     if (yych == 'o')
       goto yy479;
     goto yy333;
   yy466:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'Q')
       goto yy480;
     if (yych == 'q')
       goto yy480;
     goto yy333;
   yy467:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy367;
     if (yych == 'r')
       goto yy367;
     goto yy333;
   yy468:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy481;
     if (yych == 'o')
       goto yy481;
     goto yy333;
   yy469:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy478;
     if (yych == 'l')
       goto yy478;
     goto yy333;
   yy470:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'G')
       goto yy367;
     if (yych == 'g')
       goto yy367;
     goto yy333;
   yy471:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'S')
       goto yy482;
     if (yych == 's')
       goto yy482;
     goto yy333;
   yy472:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -7572,113 +8002,129 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
       }
     }
   yy473:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy483;
     if (yych == 't')
       goto yy483;
     goto yy333;
   yy474:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy484;
     if (yych == 'm')
       goto yy484;
     goto yy333;
   yy475:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy426;
     if (yych == 't')
       goto yy426;
     goto yy333;
   yy476:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy407;
     if (yych == 'r')
       goto yy407;
     goto yy333;
   yy477:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy485;
     if (yych == 'a')
       goto yy485;
     goto yy333;
   yy478:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'S')
       goto yy367;
     if (yych == 's')
       goto yy367;
     goto yy333;
   yy479:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'N')
       goto yy461;
     if (yych == 'n')
       goto yy461;
     goto yy333;
   yy480:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'U')
       goto yy486;
     if (yych == 'u')
       goto yy486;
     goto yy333;
   yy481:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'U')
       goto yy487;
     if (yych == 'u')
       goto yy487;
     goto yy333;
   yy482:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy461;
     if (yych == 'e')
       goto yy461;
     goto yy333;
   yy483:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy415;
     if (yych == 'e')
       goto yy415;
     goto yy333;
   yy484:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy478;
     if (yych == 'e')
       goto yy478;
     goto yy333;
   yy485:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == '[')
       goto yy488;
     goto yy333;
   yy486:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'O')
       goto yy490;
     if (yych == 'o')
       goto yy490;
     goto yy333;
   yy487:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'P')
       goto yy367;
     if (yych == 'p')
       goto yy367;
     goto yy333;
   yy488:
-    ++p;
+    YYSKIP();
     { return 5; }
   yy490:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy438;
     if (yych == 't')
@@ -7689,7 +8135,8 @@ bufsize_t _scan_html_block_start(const unsigned char *p) {
 
 // Try to match an HTML block tag start line of type 7, returning
 // 7 if successful, 0 if not.
-bufsize_t _scan_html_block_start_7(const unsigned char *p) {
+bufsize_t _scan_html_block_start_7(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
 
   {
@@ -7716,14 +8163,16 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
         0,   0,   0,   0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych == '<')
       goto yy495;
-    ++p;
+    YYSKIP();
   yy494 : { return 0; }
   yy495:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '@') {
       if (yych != '/')
         goto yy494;
@@ -7736,7 +8185,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
         goto yy498;
       goto yy494;
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '@')
       goto yy497;
     if (yych <= 'Z')
@@ -7746,14 +8196,15 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
     if (yych <= 'z')
       goto yy500;
   yy497:
-    p = marker;
+    YYRESTORE();
     if (yyaccept == 0) {
       goto yy494;
     } else {
       goto yy513;
     }
   yy498:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 2) {
       goto yy502;
     }
@@ -7785,7 +8236,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy500:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/') {
       if (yych <= 0x1F) {
         if (yych <= 0x08)
@@ -7818,7 +8270,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy502:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 2) {
       goto yy502;
     }
@@ -7849,11 +8302,13 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy504:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych != '>')
       goto yy497;
   yy505:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 4) {
       goto yy505;
     }
@@ -7867,7 +8322,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       goto yy514;
     goto yy497;
   yy507:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych <= 0x08)
         goto yy497;
@@ -7882,7 +8338,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       goto yy497;
     }
   yy509:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 8) {
       goto yy509;
     }
@@ -7911,7 +8368,9 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
     }
   yy511:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 4) {
       goto yy505;
     }
@@ -7925,10 +8384,11 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       goto yy514;
   yy513 : { return 7; }
   yy514:
-    ++p;
+    YYSKIP();
     goto yy513;
   yy515:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '<') {
       if (yych <= ' ') {
         if (yych <= 0x08)
@@ -7973,7 +8433,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy517:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy519;
     }
@@ -8009,7 +8470,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy519:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy519;
     }
@@ -8045,7 +8507,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy521:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy521;
     }
@@ -8079,7 +8542,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy523:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy523;
     }
@@ -8113,56 +8577,64 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       }
     }
   yy525:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy519;
     goto yy497;
   yy526:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy525;
     goto yy497;
   yy527:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy525;
     goto yy497;
   yy528:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0x9F)
       goto yy525;
     goto yy497;
   yy529:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy527;
     goto yy497;
   yy530:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy527;
     goto yy497;
   yy531:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0x8F)
       goto yy527;
     goto yy497;
   yy532:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 2) {
       goto yy502;
     }
@@ -8172,98 +8644,112 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
       goto yy505;
     goto yy497;
   yy533:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy521;
     goto yy497;
   yy534:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy533;
     goto yy497;
   yy535:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy533;
     goto yy497;
   yy536:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0x9F)
       goto yy533;
     goto yy497;
   yy537:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy535;
     goto yy497;
   yy538:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy535;
     goto yy497;
   yy539:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0x8F)
       goto yy535;
     goto yy497;
   yy540:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy523;
     goto yy497;
   yy541:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy540;
     goto yy497;
   yy542:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy540;
     goto yy497;
   yy543:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0x9F)
       goto yy540;
     goto yy497;
   yy544:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy542;
     goto yy497;
   yy545:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0xBF)
       goto yy542;
     goto yy497;
   yy546:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy497;
     if (yych <= 0x8F)
@@ -8273,7 +8759,8 @@ bufsize_t _scan_html_block_start_7(const unsigned char *p) {
 }
 
 // Try to match an HTML block end line of type 1
-bufsize_t _scan_html_block_end_1(const unsigned char *p) {
+bufsize_t _scan_html_block_end_1(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -8297,7 +8784,7 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
         0,  0,  0,  0,  0,  0,  0,   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
         0,  0,  0,  0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= 0xDF) {
       if (yych <= ';') {
         if (yych <= 0x00)
@@ -8329,11 +8816,13 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy549:
-    ++p;
+    YYSKIP();
   yy550 : { return 0; }
   yy551:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '\n') {
       if (yych <= 0x00)
         goto yy550;
@@ -8351,7 +8840,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     }
   yy552:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '.') {
       if (yych <= 0x00)
         goto yy550;
@@ -8373,7 +8864,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     }
   yy553:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy550;
     if (yych <= 0xBF)
@@ -8381,7 +8874,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     goto yy550;
   yy554:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy550;
     if (yych <= 0xBF)
@@ -8389,7 +8884,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     goto yy550;
   yy555:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy550;
     if (yych <= 0xBF)
@@ -8397,7 +8894,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     goto yy550;
   yy556:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy550;
     if (yych <= 0x9F)
@@ -8405,7 +8904,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     goto yy550;
   yy557:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy550;
     if (yych <= 0xBF)
@@ -8413,7 +8914,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     goto yy550;
   yy558:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy550;
     if (yych <= 0xBF)
@@ -8421,14 +8924,17 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     goto yy550;
   yy559:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy550;
     if (yych <= 0x8F)
       goto yy567;
     goto yy550;
   yy560:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy561:
     if (yybm[0 + yych] & 64) {
       goto yy560;
@@ -8461,14 +8967,15 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy562:
-    p = marker;
+    YYRESTORE();
     if (yyaccept == 0) {
       goto yy550;
     } else {
       goto yy582;
     }
   yy563:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8505,56 +9012,64 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy565:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy562;
     if (yych <= 0xBF)
       goto yy560;
     goto yy562;
   yy566:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy562;
     if (yych <= 0xBF)
       goto yy565;
     goto yy562;
   yy567:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy562;
     if (yych <= 0xBF)
       goto yy565;
     goto yy562;
   yy568:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy562;
     if (yych <= 0x9F)
       goto yy565;
     goto yy562;
   yy569:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy562;
     if (yych <= 0xBF)
       goto yy567;
     goto yy562;
   yy570:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy562;
     if (yych <= 0xBF)
       goto yy567;
     goto yy562;
   yy571:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy562;
     if (yych <= 0x8F)
       goto yy567;
     goto yy562;
   yy572:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8613,7 +9128,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy573:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8661,7 +9177,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy574:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8721,7 +9238,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy575:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8769,7 +9287,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy576:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8817,7 +9336,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy577:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8865,7 +9385,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy578:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8903,7 +9424,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy579:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -8951,7 +9473,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy580:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -9000,7 +9523,9 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     }
   yy581:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy560;
     }
@@ -9033,7 +9558,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
     }
   yy582 : { return (bufsize_t)(p - start); }
   yy583:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -9080,7 +9606,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
       }
     }
   yy584:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy563;
     }
@@ -9131,7 +9658,8 @@ bufsize_t _scan_html_block_end_1(const unsigned char *p) {
 }
 
 // Try to match an HTML block end line of type 2
-bufsize_t _scan_html_block_end_2(const unsigned char *p) {
+bufsize_t _scan_html_block_end_2(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -9155,7 +9683,7 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   0,  0,  0,  0,  0,  0,  0,  0,
         0,  0,  0,  0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= 0xDF) {
       if (yych <= ',') {
         if (yych <= 0x00)
@@ -9187,11 +9715,13 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
       }
     }
   yy587:
-    ++p;
+    YYSKIP();
   yy588 : { return 0; }
   yy589:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '\n') {
       if (yych <= 0x00)
         goto yy588;
@@ -9209,7 +9739,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     }
   yy590:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy609;
     }
@@ -9230,7 +9762,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     }
   yy591:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy588;
     if (yych <= 0xBF)
@@ -9238,7 +9772,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     goto yy588;
   yy592:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy588;
     if (yych <= 0xBF)
@@ -9246,7 +9782,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     goto yy588;
   yy593:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy588;
     if (yych <= 0xBF)
@@ -9254,7 +9792,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     goto yy588;
   yy594:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy588;
     if (yych <= 0x9F)
@@ -9262,7 +9802,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     goto yy588;
   yy595:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy588;
     if (yych <= 0xBF)
@@ -9270,7 +9812,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     goto yy588;
   yy596:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy588;
     if (yych <= 0xBF)
@@ -9278,14 +9822,17 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     goto yy588;
   yy597:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy588;
     if (yych <= 0x8F)
       goto yy604;
     goto yy588;
   yy598:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy599:
     if (yybm[0 + yych] & 64) {
       goto yy598;
@@ -9318,14 +9865,15 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
       }
     }
   yy600:
-    p = marker;
+    YYRESTORE();
     if (yyaccept == 0) {
       goto yy588;
     } else {
       goto yy612;
     }
   yy601:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy598;
     }
@@ -9359,56 +9907,64 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
       }
     }
   yy602:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy600;
     if (yych <= 0xBF)
       goto yy598;
     goto yy600;
   yy603:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy600;
     if (yych <= 0xBF)
       goto yy602;
     goto yy600;
   yy604:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy600;
     if (yych <= 0xBF)
       goto yy602;
     goto yy600;
   yy605:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy600;
     if (yych <= 0x9F)
       goto yy602;
     goto yy600;
   yy606:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy600;
     if (yych <= 0xBF)
       goto yy604;
     goto yy600;
   yy607:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy600;
     if (yych <= 0xBF)
       goto yy604;
     goto yy600;
   yy608:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy600;
     if (yych <= 0x8F)
       goto yy604;
     goto yy600;
   yy609:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy609;
     }
@@ -9447,7 +10003,9 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
     }
   yy611:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy598;
     }
@@ -9483,7 +10041,8 @@ bufsize_t _scan_html_block_end_2(const unsigned char *p) {
 }
 
 // Try to match an HTML block end line of type 3
-bufsize_t _scan_html_block_end_3(const unsigned char *p) {
+bufsize_t _scan_html_block_end_3(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -9507,7 +10066,7 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,   0,  0,  0,  0,  0,  0,  0,  0,
         0,  0,  0,  0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= 0xDF) {
       if (yych <= '>') {
         if (yych <= 0x00)
@@ -9539,11 +10098,13 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
       }
     }
   yy615:
-    ++p;
+    YYSKIP();
   yy616 : { return 0; }
   yy617:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '\n') {
       if (yych <= 0x00)
         goto yy616;
@@ -9561,7 +10122,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     }
   yy618:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '=') {
       if (yych <= 0x00)
         goto yy616;
@@ -9583,7 +10146,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     }
   yy619:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy616;
     if (yych <= 0xBF)
@@ -9591,7 +10156,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     goto yy616;
   yy620:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy616;
     if (yych <= 0xBF)
@@ -9599,7 +10166,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     goto yy616;
   yy621:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy616;
     if (yych <= 0xBF)
@@ -9607,7 +10176,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     goto yy616;
   yy622:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy616;
     if (yych <= 0x9F)
@@ -9615,7 +10186,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     goto yy616;
   yy623:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy616;
     if (yych <= 0xBF)
@@ -9623,7 +10196,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     goto yy616;
   yy624:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy616;
     if (yych <= 0xBF)
@@ -9631,14 +10206,17 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     goto yy616;
   yy625:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy616;
     if (yych <= 0x8F)
       goto yy633;
     goto yy616;
   yy626:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy627:
     if (yybm[0 + yych] & 64) {
       goto yy626;
@@ -9671,14 +10249,15 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
       }
     }
   yy628:
-    p = marker;
+    YYRESTORE();
     if (yyaccept == 0) {
       goto yy616;
     } else {
       goto yy639;
     }
   yy629:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy629;
     }
@@ -9715,49 +10294,56 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
       }
     }
   yy631:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy628;
     if (yych <= 0xBF)
       goto yy626;
     goto yy628;
   yy632:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy628;
     if (yych <= 0xBF)
       goto yy631;
     goto yy628;
   yy633:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy628;
     if (yych <= 0xBF)
       goto yy631;
     goto yy628;
   yy634:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy628;
     if (yych <= 0x9F)
       goto yy631;
     goto yy628;
   yy635:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy628;
     if (yych <= 0xBF)
       goto yy633;
     goto yy628;
   yy636:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy628;
     if (yych <= 0xBF)
       goto yy633;
     goto yy628;
   yy637:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy628;
     if (yych <= 0x8F)
@@ -9765,7 +10351,9 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
     goto yy628;
   yy638:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy626;
     }
@@ -9801,7 +10389,8 @@ bufsize_t _scan_html_block_end_3(const unsigned char *p) {
 }
 
 // Try to match an HTML block end line of type 4
-bufsize_t _scan_html_block_end_4(const unsigned char *p) {
+bufsize_t _scan_html_block_end_4(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -9829,7 +10418,7 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
         0,   0,   0,   0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy645;
     }
@@ -9863,11 +10452,13 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
       }
     }
   yy642:
-    ++p;
+    YYSKIP();
   yy643 : { return 0; }
   yy644:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '\n') {
       if (yych <= 0x00)
         goto yy643;
@@ -9885,7 +10476,9 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
     }
   yy645:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy655;
     }
@@ -9919,7 +10512,9 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
   yy647 : { return (bufsize_t)(p - start); }
   yy648:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy643;
     if (yych <= 0xBF)
@@ -9927,7 +10522,9 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
     goto yy643;
   yy649:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy643;
     if (yych <= 0xBF)
@@ -9935,7 +10532,9 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
     goto yy643;
   yy650:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy643;
     if (yych <= 0xBF)
@@ -9943,7 +10542,9 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
     goto yy643;
   yy651:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy643;
     if (yych <= 0x9F)
@@ -9951,7 +10552,9 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
     goto yy643;
   yy652:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy643;
     if (yych <= 0xBF)
@@ -9959,7 +10562,9 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
     goto yy643;
   yy653:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy643;
     if (yych <= 0xBF)
@@ -9967,14 +10572,17 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
     goto yy643;
   yy654:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy643;
     if (yych <= 0x8F)
       goto yy660;
     goto yy643;
   yy655:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy656:
     if (yybm[0 + yych] & 128) {
       goto yy655;
@@ -10007,56 +10615,63 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
       }
     }
   yy657:
-    p = marker;
+    YYRESTORE();
     if (yyaccept == 0) {
       goto yy643;
     } else {
       goto yy647;
     }
   yy658:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy657;
     if (yych <= 0xBF)
       goto yy655;
     goto yy657;
   yy659:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy657;
     if (yych <= 0xBF)
       goto yy658;
     goto yy657;
   yy660:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy657;
     if (yych <= 0xBF)
       goto yy658;
     goto yy657;
   yy661:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy657;
     if (yych <= 0x9F)
       goto yy658;
     goto yy657;
   yy662:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy657;
     if (yych <= 0xBF)
       goto yy660;
     goto yy657;
   yy663:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy657;
     if (yych <= 0xBF)
       goto yy660;
     goto yy657;
   yy664:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy657;
     if (yych <= 0x8F)
@@ -10066,7 +10681,8 @@ bufsize_t _scan_html_block_end_4(const unsigned char *p) {
 }
 
 // Try to match an HTML block end line of type 5
-bufsize_t _scan_html_block_end_5(const unsigned char *p) {
+bufsize_t _scan_html_block_end_5(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -10090,7 +10706,7 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
         0,  0,  0,  0,   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
         0,  0,  0,  0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= 0xDF) {
       if (yych <= '\\') {
         if (yych <= 0x00)
@@ -10122,11 +10738,13 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
       }
     }
   yy667:
-    ++p;
+    YYSKIP();
   yy668 : { return 0; }
   yy669:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '\n') {
       if (yych <= 0x00)
         goto yy668;
@@ -10144,7 +10762,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     }
   yy670:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy689;
     }
@@ -10165,7 +10785,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     }
   yy671:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy668;
     if (yych <= 0xBF)
@@ -10173,7 +10795,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     goto yy668;
   yy672:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy668;
     if (yych <= 0xBF)
@@ -10181,7 +10805,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     goto yy668;
   yy673:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy668;
     if (yych <= 0xBF)
@@ -10189,7 +10815,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     goto yy668;
   yy674:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy668;
     if (yych <= 0x9F)
@@ -10197,7 +10825,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     goto yy668;
   yy675:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy668;
     if (yych <= 0xBF)
@@ -10205,7 +10835,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     goto yy668;
   yy676:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy668;
     if (yych <= 0xBF)
@@ -10213,14 +10845,17 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     goto yy668;
   yy677:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy668;
     if (yych <= 0x8F)
       goto yy684;
     goto yy668;
   yy678:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy679:
     if (yybm[0 + yych] & 64) {
       goto yy678;
@@ -10253,14 +10888,15 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
       }
     }
   yy680:
-    p = marker;
+    YYRESTORE();
     if (yyaccept == 0) {
       goto yy668;
     } else {
       goto yy692;
     }
   yy681:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy678;
     }
@@ -10294,56 +10930,64 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
       }
     }
   yy682:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy680;
     if (yych <= 0xBF)
       goto yy678;
     goto yy680;
   yy683:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy680;
     if (yych <= 0xBF)
       goto yy682;
     goto yy680;
   yy684:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy680;
     if (yych <= 0xBF)
       goto yy682;
     goto yy680;
   yy685:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy680;
     if (yych <= 0x9F)
       goto yy682;
     goto yy680;
   yy686:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy680;
     if (yych <= 0xBF)
       goto yy684;
     goto yy680;
   yy687:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy680;
     if (yych <= 0xBF)
       goto yy684;
     goto yy680;
   yy688:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy680;
     if (yych <= 0x8F)
       goto yy684;
     goto yy680;
   yy689:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy689;
     }
@@ -10382,7 +11026,9 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
     }
   yy691:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy678;
     }
@@ -10420,7 +11066,8 @@ bufsize_t _scan_html_block_end_5(const unsigned char *p) {
 // Try to match a link title (in single quotes, in double quotes, or
 // in parentheses), returning number of chars matched.  Allow one
 // level of internal nesting (quotes within quotes).
-bufsize_t _scan_link_title(const unsigned char *p) {
+bufsize_t _scan_link_title(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -10448,7 +11095,7 @@ bufsize_t _scan_link_title(const unsigned char *p) {
         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
         0,   0,   0,   0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= '&') {
       if (yych == '"')
         goto yy697;
@@ -10458,11 +11105,13 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       if (yych <= '(')
         goto yy699;
     }
-    ++p;
+    YYSKIP();
   yy696 : { return 0; }
   yy697:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x00)
       goto yy696;
     if (yych <= 0x7F)
@@ -10474,7 +11123,9 @@ bufsize_t _scan_link_title(const unsigned char *p) {
     goto yy696;
   yy698:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x00)
       goto yy696;
     if (yych <= 0x7F)
@@ -10486,7 +11137,9 @@ bufsize_t _scan_link_title(const unsigned char *p) {
     goto yy696;
   yy699:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x00)
       goto yy696;
     if (yych <= 0x7F)
@@ -10497,7 +11150,8 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       goto yy728;
     goto yy696;
   yy700:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy701:
     if (yybm[0 + yych] & 16) {
       goto yy700;
@@ -10531,7 +11185,7 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       }
     }
   yy702:
-    p = marker;
+    YYRESTORE();
     if (yyaccept <= 1) {
       if (yyaccept == 0) {
         goto yy696;
@@ -10546,10 +11200,11 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       }
     }
   yy703:
-    ++p;
+    YYSKIP();
   yy704 : { return (bufsize_t)(p - start); }
   yy705:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy700;
     }
@@ -10582,56 +11237,64 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       }
     }
   yy707:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy700;
     goto yy702;
   yy708:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy707;
     goto yy702;
   yy709:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy707;
     goto yy702;
   yy710:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0x9F)
       goto yy707;
     goto yy702;
   yy711:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy709;
     goto yy702;
   yy712:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy709;
     goto yy702;
   yy713:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0x8F)
       goto yy709;
     goto yy702;
   yy714:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy715:
     if (yybm[0 + yych] & 64) {
       goto yy714;
@@ -10665,10 +11328,11 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       }
     }
   yy716:
-    ++p;
+    YYSKIP();
   yy717 : { return (bufsize_t)(p - start); }
   yy718:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy714;
     }
@@ -10701,56 +11365,64 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       }
     }
   yy720:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy714;
     goto yy702;
   yy721:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy720;
     goto yy702;
   yy722:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy720;
     goto yy702;
   yy723:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0x9F)
       goto yy720;
     goto yy702;
   yy724:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy722;
     goto yy702;
   yy725:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy722;
     goto yy702;
   yy726:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0x8F)
       goto yy722;
     goto yy702;
   yy727:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy728:
     if (yybm[0 + yych] & 128) {
       goto yy727;
@@ -10784,10 +11456,11 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       }
     }
   yy729:
-    ++p;
+    YYSKIP();
   yy730 : { return (bufsize_t)(p - start); }
   yy731:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy727;
     }
@@ -10820,49 +11493,56 @@ bufsize_t _scan_link_title(const unsigned char *p) {
       }
     }
   yy733:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy727;
     goto yy702;
   yy734:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy733;
     goto yy702;
   yy735:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy733;
     goto yy702;
   yy736:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0x9F)
       goto yy733;
     goto yy702;
   yy737:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy735;
     goto yy702;
   yy738:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0xBF)
       goto yy735;
     goto yy702;
   yy739:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy702;
     if (yych <= 0x8F)
@@ -10870,7 +11550,9 @@ bufsize_t _scan_link_title(const unsigned char *p) {
     goto yy702;
   yy740:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy700;
     }
@@ -10905,7 +11587,9 @@ bufsize_t _scan_link_title(const unsigned char *p) {
     }
   yy741:
     yyaccept = 2;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy714;
     }
@@ -10940,7 +11624,9 @@ bufsize_t _scan_link_title(const unsigned char *p) {
     }
   yy742:
     yyaccept = 3;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy727;
     }
@@ -10977,7 +11663,8 @@ bufsize_t _scan_link_title(const unsigned char *p) {
 }
 
 // Match space characters, including newlines.
-bufsize_t _scan_spacechars(const unsigned char *p) {
+bufsize_t _scan_spacechars(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *start = p;
 
   {
@@ -10997,14 +11684,15 @@ bufsize_t _scan_spacechars(const unsigned char *p) {
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0,   0,   0,   0,   0, 0, 0, 0, 0, 0,
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0,   0,   0,   0,   0, 0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy747;
     }
-    ++p;
+    YYSKIP();
     { return 0; }
   yy747:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy747;
     }
@@ -11013,7 +11701,8 @@ bufsize_t _scan_spacechars(const unsigned char *p) {
 }
 
 // Match ATX heading start.
-bufsize_t _scan_atx_heading_start(const unsigned char *p) {
+bufsize_t _scan_atx_heading_start(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -11033,13 +11722,15 @@ bufsize_t _scan_atx_heading_start(const unsigned char *p) {
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0,   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   0,   0, 0, 0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych == '#')
       goto yy754;
-    ++p;
+    YYSKIP();
   yy753 : { return 0; }
   yy754:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy755;
     }
@@ -11057,16 +11748,18 @@ bufsize_t _scan_atx_heading_start(const unsigned char *p) {
       goto yy753;
     }
   yy755:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy755;
     }
   yy757 : { return (bufsize_t)(p - start); }
   yy758:
-    ++p;
+    YYSKIP();
     goto yy757;
   yy759:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy755;
     }
@@ -11082,10 +11775,11 @@ bufsize_t _scan_atx_heading_start(const unsigned char *p) {
         goto yy761;
     }
   yy760:
-    p = marker;
+    YYRESTORE();
     goto yy753;
   yy761:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy755;
     }
@@ -11101,7 +11795,8 @@ bufsize_t _scan_atx_heading_start(const unsigned char *p) {
       if (yych != '#')
         goto yy760;
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy755;
     }
@@ -11117,7 +11812,8 @@ bufsize_t _scan_atx_heading_start(const unsigned char *p) {
       if (yych != '#')
         goto yy760;
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy755;
     }
@@ -11133,7 +11829,8 @@ bufsize_t _scan_atx_heading_start(const unsigned char *p) {
       if (yych != '#')
         goto yy760;
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy755;
     }
@@ -11149,7 +11846,8 @@ bufsize_t _scan_atx_heading_start(const unsigned char *p) {
 
 // Match setext heading line.  Return 1 for level-1 heading,
 // 2 for level-2, 0 for no match.
-bufsize_t _scan_setext_heading_line(const unsigned char *p) {
+bufsize_t _scan_setext_heading_line(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
 
   {
@@ -11168,15 +11866,17 @@ bufsize_t _scan_setext_heading_line(const unsigned char *p) {
         0, 0,  0, 0, 0, 0, 0, 0, 0, 0,  0,  0, 0, 0, 0, 0, 0, 0,   0, 0, 0, 0,
         0, 0,  0, 0, 0, 0, 0, 0, 0, 0,  0,  0, 0, 0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych == '-')
       goto yy769;
     if (yych == '=')
       goto yy770;
-    ++p;
+    YYSKIP();
   yy768 : { return 0; }
   yy769:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy776;
     }
@@ -11194,7 +11894,9 @@ bufsize_t _scan_setext_heading_line(const unsigned char *p) {
       goto yy768;
     }
   yy770:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy782;
     }
@@ -11212,7 +11914,8 @@ bufsize_t _scan_setext_heading_line(const unsigned char *p) {
       goto yy768;
     }
   yy771:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy772:
     if (yybm[0 + yych] & 32) {
       goto yy771;
@@ -11224,13 +11927,14 @@ bufsize_t _scan_setext_heading_line(const unsigned char *p) {
     if (yych == '\r')
       goto yy774;
   yy773:
-    p = marker;
+    YYRESTORE();
     goto yy768;
   yy774:
-    ++p;
+    YYSKIP();
     { return 2; }
   yy776:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy771;
     }
@@ -11248,7 +11952,8 @@ bufsize_t _scan_setext_heading_line(const unsigned char *p) {
       goto yy773;
     }
   yy778:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
   yy779:
     if (yych <= '\f') {
       if (yych <= 0x08)
@@ -11265,10 +11970,11 @@ bufsize_t _scan_setext_heading_line(const unsigned char *p) {
       goto yy773;
     }
   yy780:
-    ++p;
+    YYSKIP();
     { return 1; }
   yy782:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy782;
     }
@@ -11293,7 +11999,8 @@ bufsize_t _scan_setext_heading_line(const unsigned char *p) {
 // Scan a thematic break line: "...three or more hyphens, asterisks,
 // or underscores on a line by themselves. If you wish, you may use
 // spaces between the hyphens or asterisks."
-bufsize_t _scan_thematic_break(const unsigned char *p) {
+bufsize_t _scan_thematic_break(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -11314,7 +12021,7 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
         0, 0, 0,  0, 0, 0,  0, 0, 0, 0,   0, 0, 0,   0, 0, 0,   0, 0, 0, 0,
         0, 0, 0,  0, 0, 0,  0, 0, 0, 0,   0, 0, 0,   0, 0, 0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= ',') {
       if (yych == '*')
         goto yy788;
@@ -11324,10 +12031,12 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       if (yych == '_')
         goto yy790;
     }
-    ++p;
+    YYSKIP();
   yy787 : { return 0; }
   yy788:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy791;
     }
@@ -11335,7 +12044,9 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy794;
     goto yy787;
   yy789:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych == '\t')
         goto yy796;
@@ -11348,7 +12059,9 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy787;
     }
   yy790:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych == '\t')
         goto yy800;
@@ -11361,17 +12074,19 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy787;
     }
   yy791:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy791;
     }
     if (yych == '*')
       goto yy794;
   yy793:
-    p = marker;
+    YYRESTORE();
     goto yy787;
   yy794:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych == '\t')
         goto yy794;
@@ -11384,7 +12099,8 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy793;
     }
   yy796:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych == '\t')
         goto yy796;
@@ -11396,7 +12112,8 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
         goto yy793;
     }
   yy798:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych == '\t')
         goto yy798;
@@ -11409,7 +12126,8 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy793;
     }
   yy800:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych == '\t')
         goto yy800;
@@ -11421,7 +12139,8 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
         goto yy793;
     }
   yy802:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x1F) {
       if (yych == '\t')
         goto yy802;
@@ -11434,7 +12153,8 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy793;
     }
   yy804:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy804;
     }
@@ -11446,7 +12166,8 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy810;
     goto yy793;
   yy806:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy806;
     }
@@ -11458,7 +12179,8 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy812;
     goto yy793;
   yy808:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy808;
     }
@@ -11470,19 +12192,20 @@ bufsize_t _scan_thematic_break(const unsigned char *p) {
       goto yy814;
     goto yy793;
   yy810:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   yy812:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   yy814:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   }
 }
 
 // Scan an opening code fence.
-bufsize_t _scan_open_code_fence(const unsigned char *p) {
+bufsize_t _scan_open_code_fence(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -11509,39 +12232,46 @@ bufsize_t _scan_open_code_fence(const unsigned char *p) {
         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
         0,   0,   0,   0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych == '`')
       goto yy820;
     if (yych == '~')
       goto yy821;
-    ++p;
+    YYSKIP();
   yy819 : { return 0; }
   yy820:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == '`')
       goto yy822;
     goto yy819;
   yy821:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == '~')
       goto yy824;
     goto yy819;
   yy822:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy825;
     }
   yy823:
-    p = marker;
+    YYRESTORE();
     goto yy819;
   yy824:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy827;
     }
     goto yy823;
   yy825:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 16) {
       goto yy825;
     }
@@ -11550,55 +12280,56 @@ bufsize_t _scan_open_code_fence(const unsigned char *p) {
         if (yych <= 0x00)
           goto yy823;
         if (yych == '\n') {
-          marker = p;
+          YYBACKUP();
           goto yy831;
         }
-        marker = p;
+        YYBACKUP();
         goto yy829;
       } else {
         if (yych <= '\r') {
-          marker = p;
+          YYBACKUP();
           goto yy831;
         }
         if (yych <= 0x7F) {
-          marker = p;
+          YYBACKUP();
           goto yy829;
         }
         if (yych <= 0xC1)
           goto yy823;
-        marker = p;
+        YYBACKUP();
         goto yy833;
       }
     } else {
       if (yych <= 0xEF) {
         if (yych <= 0xE0) {
-          marker = p;
+          YYBACKUP();
           goto yy834;
         }
         if (yych == 0xED) {
-          marker = p;
+          YYBACKUP();
           goto yy836;
         }
-        marker = p;
+        YYBACKUP();
         goto yy835;
       } else {
         if (yych <= 0xF0) {
-          marker = p;
+          YYBACKUP();
           goto yy837;
         }
         if (yych <= 0xF3) {
-          marker = p;
+          YYBACKUP();
           goto yy838;
         }
         if (yych <= 0xF4) {
-          marker = p;
+          YYBACKUP();
           goto yy839;
         }
         goto yy823;
       }
     }
   yy827:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy827;
     }
@@ -11607,55 +12338,56 @@ bufsize_t _scan_open_code_fence(const unsigned char *p) {
         if (yych <= 0x00)
           goto yy823;
         if (yych == '\n') {
-          marker = p;
+          YYBACKUP();
           goto yy842;
         }
-        marker = p;
+        YYBACKUP();
         goto yy840;
       } else {
         if (yych <= '\r') {
-          marker = p;
+          YYBACKUP();
           goto yy842;
         }
         if (yych <= 0x7F) {
-          marker = p;
+          YYBACKUP();
           goto yy840;
         }
         if (yych <= 0xC1)
           goto yy823;
-        marker = p;
+        YYBACKUP();
         goto yy844;
       }
     } else {
       if (yych <= 0xEF) {
         if (yych <= 0xE0) {
-          marker = p;
+          YYBACKUP();
           goto yy845;
         }
         if (yych == 0xED) {
-          marker = p;
+          YYBACKUP();
           goto yy847;
         }
-        marker = p;
+        YYBACKUP();
         goto yy846;
       } else {
         if (yych <= 0xF0) {
-          marker = p;
+          YYBACKUP();
           goto yy848;
         }
         if (yych <= 0xF3) {
-          marker = p;
+          YYBACKUP();
           goto yy849;
         }
         if (yych <= 0xF4) {
-          marker = p;
+          YYBACKUP();
           goto yy850;
         }
         goto yy823;
       }
     }
   yy829:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy829;
     }
@@ -11688,60 +12420,68 @@ bufsize_t _scan_open_code_fence(const unsigned char *p) {
       }
     }
   yy831:
-    ++p;
-    p = marker;
+    YYSKIP();
+    YYRESTORE();
     { return (bufsize_t)(p - start); }
   yy833:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy829;
     goto yy823;
   yy834:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy833;
     goto yy823;
   yy835:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy833;
     goto yy823;
   yy836:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0x9F)
       goto yy833;
     goto yy823;
   yy837:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy835;
     goto yy823;
   yy838:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy835;
     goto yy823;
   yy839:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0x8F)
       goto yy835;
     goto yy823;
   yy840:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy840;
     }
@@ -11774,53 +12514,60 @@ bufsize_t _scan_open_code_fence(const unsigned char *p) {
       }
     }
   yy842:
-    ++p;
-    p = marker;
+    YYSKIP();
+    YYRESTORE();
     { return (bufsize_t)(p - start); }
   yy844:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy840;
     goto yy823;
   yy845:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x9F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy844;
     goto yy823;
   yy846:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy844;
     goto yy823;
   yy847:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0x9F)
       goto yy844;
     goto yy823;
   yy848:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x8F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy846;
     goto yy823;
   yy849:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0xBF)
       goto yy846;
     goto yy823;
   yy850:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 0x7F)
       goto yy823;
     if (yych <= 0x8F)
@@ -11830,7 +12577,8 @@ bufsize_t _scan_open_code_fence(const unsigned char *p) {
 }
 
 // Scan a closing code fence with length at least len.
-bufsize_t _scan_close_code_fence(const unsigned char *p) {
+bufsize_t _scan_close_code_fence(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
@@ -11850,39 +12598,46 @@ bufsize_t _scan_close_code_fence(const unsigned char *p) {
         0, 0, 0, 0, 0, 0, 0, 0, 0,  0,   0,   0, 0, 0, 0, 0, 0,  0, 0, 0, 0, 0,
         0, 0, 0, 0, 0, 0, 0, 0, 0,  0,   0,   0, 0, 0,
     };
-    yych = *p;
+    yych = YYPEEK();
     if (yych == '`')
       goto yy855;
     if (yych == '~')
       goto yy856;
-    ++p;
+    YYSKIP();
   yy854 : { return 0; }
   yy855:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == '`')
       goto yy857;
     goto yy854;
   yy856:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == '~')
       goto yy859;
     goto yy854;
   yy857:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy860;
     }
   yy858:
-    p = marker;
+    YYRESTORE();
     goto yy854;
   yy859:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy862;
     }
     goto yy858;
   yy860:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 32) {
       goto yy860;
     }
@@ -11890,27 +12645,28 @@ bufsize_t _scan_close_code_fence(const unsigned char *p) {
       if (yych <= 0x08)
         goto yy858;
       if (yych <= '\t') {
-        marker = p;
+        YYBACKUP();
         goto yy864;
       }
       if (yych <= '\n') {
-        marker = p;
+        YYBACKUP();
         goto yy866;
       }
       goto yy858;
     } else {
       if (yych <= '\r') {
-        marker = p;
+        YYBACKUP();
         goto yy866;
       }
       if (yych == ' ') {
-        marker = p;
+        YYBACKUP();
         goto yy864;
       }
       goto yy858;
     }
   yy862:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 64) {
       goto yy862;
     }
@@ -11918,27 +12674,28 @@ bufsize_t _scan_close_code_fence(const unsigned char *p) {
       if (yych <= 0x08)
         goto yy858;
       if (yych <= '\t') {
-        marker = p;
+        YYBACKUP();
         goto yy868;
       }
       if (yych <= '\n') {
-        marker = p;
+        YYBACKUP();
         goto yy870;
       }
       goto yy858;
     } else {
       if (yych <= '\r') {
-        marker = p;
+        YYBACKUP();
         goto yy870;
       }
       if (yych == ' ') {
-        marker = p;
+        YYBACKUP();
         goto yy868;
       }
       goto yy858;
     }
   yy864:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yybm[0 + yych] & 128) {
       goto yy864;
     }
@@ -11949,11 +12706,12 @@ bufsize_t _scan_close_code_fence(const unsigned char *p) {
     if (yych != '\r')
       goto yy858;
   yy866:
-    ++p;
-    p = marker;
+    YYSKIP();
+    YYRESTORE();
     { return (bufsize_t)(p - start); }
   yy868:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '\f') {
       if (yych <= 0x08)
         goto yy858;
@@ -11969,27 +12727,30 @@ bufsize_t _scan_close_code_fence(const unsigned char *p) {
       goto yy858;
     }
   yy870:
-    ++p;
-    p = marker;
+    YYSKIP();
+    YYRESTORE();
     { return (bufsize_t)(p - start); }
   }
 }
 
 // Scans an entity.
 // Returns number of chars matched.
-bufsize_t _scan_entity(const unsigned char *p) {
+bufsize_t _scan_entity(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
   {
     unsigned char yych;
-    yych = *p;
+    yych = YYPEEK();
     if (yych == '&')
       goto yy876;
-    ++p;
+    YYSKIP();
   yy875 : { return 0; }
   yy876:
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych <= '@') {
       if (yych != '#')
         goto yy875;
@@ -12002,7 +12763,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
         goto yy879;
       goto yy875;
     }
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'W') {
       if (yych <= '/')
         goto yy878;
@@ -12015,10 +12777,11 @@ bufsize_t _scan_entity(const unsigned char *p) {
         goto yy881;
     }
   yy878:
-    p = marker;
+    YYRESTORE();
     goto yy875;
   yy879:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '@') {
       if (yych <= '/')
         goto yy878;
@@ -12035,7 +12798,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       goto yy878;
     }
   yy880:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/')
       goto yy878;
     if (yych <= '9')
@@ -12044,7 +12808,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       goto yy884;
     goto yy878;
   yy881:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '@') {
       if (yych <= '/')
         goto yy878;
@@ -12061,7 +12826,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       goto yy878;
     }
   yy882:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12084,7 +12850,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy883:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/')
       goto yy878;
     if (yych <= '9')
@@ -12092,10 +12859,11 @@ bufsize_t _scan_entity(const unsigned char *p) {
     if (yych != ';')
       goto yy878;
   yy884:
-    ++p;
+    YYSKIP();
     { return (bufsize_t)(p - start); }
   yy886:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12118,7 +12886,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy887:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12141,7 +12910,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy888:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/')
       goto yy878;
     if (yych <= '9')
@@ -12150,7 +12920,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       goto yy884;
     goto yy878;
   yy889:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12173,7 +12944,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy890:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12196,7 +12968,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy891:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/')
       goto yy878;
     if (yych <= '9')
@@ -12205,7 +12978,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       goto yy884;
     goto yy878;
   yy892:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12228,7 +13002,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy893:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12251,7 +13026,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy894:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/')
       goto yy878;
     if (yych <= '9')
@@ -12260,7 +13036,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       goto yy884;
     goto yy878;
   yy895:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12283,7 +13060,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy896:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12306,7 +13084,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy897:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= '/')
       goto yy878;
     if (yych <= '9')
@@ -12315,7 +13094,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       goto yy884;
     goto yy878;
   yy898:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12338,7 +13118,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy899:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12361,12 +13142,14 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy900:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == ';')
       goto yy884;
     goto yy878;
   yy901:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12387,7 +13170,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy902:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12408,7 +13192,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy903:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12429,7 +13214,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy904:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12450,7 +13236,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy905:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12471,7 +13258,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy906:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12492,7 +13280,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy907:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12513,7 +13302,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy908:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12534,7 +13324,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy909:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12555,7 +13346,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy910:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12576,7 +13368,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy911:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12597,7 +13390,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy912:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12618,7 +13412,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy913:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12639,7 +13434,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy914:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12660,7 +13456,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy915:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12681,7 +13478,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy916:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12702,7 +13500,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy917:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12723,7 +13522,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy918:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12744,7 +13544,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy919:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12765,7 +13566,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy920:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12786,7 +13588,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy921:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12807,7 +13610,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy922:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12828,7 +13632,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy923:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12849,7 +13654,8 @@ bufsize_t _scan_entity(const unsigned char *p) {
       }
     }
   yy924:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= ';') {
       if (yych <= '/')
         goto yy878;
@@ -12876,14 +13682,15 @@ bufsize_t _scan_entity(const unsigned char *p) {
 
 // Returns positive value if a URL begins in a way that is potentially
 // dangerous, with javascript:, vbscript:, file:, or data:, otherwise 0.
-bufsize_t _scan_dangerous_url(const unsigned char *p) {
+bufsize_t _scan_dangerous_url(const unsigned char *p, bufsize_t len) {
+  const unsigned char *end = p + len;
   const unsigned char *marker = NULL;
   const unsigned char *start = p;
 
   {
     unsigned char yych;
     unsigned int yyaccept = 0;
-    yych = *p;
+    yych = YYPEEK();
     if (yych <= 'V') {
       if (yych <= 'F') {
         if (yych == 'D')
@@ -12912,11 +13719,13 @@ bufsize_t _scan_dangerous_url(const unsigned char *p) {
         }
       }
     }
-    ++p;
+    YYSKIP();
   yy928 : { return 0; }
   yy929:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy933;
     if (yych == 'a')
@@ -12924,7 +13733,9 @@ bufsize_t _scan_dangerous_url(const unsigned char *p) {
     goto yy928;
   yy930:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy935;
     if (yych == 'i')
@@ -12932,7 +13743,9 @@ bufsize_t _scan_dangerous_url(const unsigned char *p) {
     goto yy928;
   yy931:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy936;
     if (yych == 'a')
@@ -12940,86 +13753,99 @@ bufsize_t _scan_dangerous_url(const unsigned char *p) {
     goto yy928;
   yy932:
     yyaccept = 0;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == 'B')
       goto yy937;
     if (yych == 'b')
       goto yy937;
     goto yy928;
   yy933:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy938;
     if (yych == 't')
       goto yy938;
   yy934:
-    p = marker;
+    YYRESTORE();
     if (yyaccept == 0) {
       goto yy928;
     } else {
       goto yy946;
     }
   yy935:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'L')
       goto yy939;
     if (yych == 'l')
       goto yy939;
     goto yy934;
   yy936:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'V')
       goto yy940;
     if (yych == 'v')
       goto yy940;
     goto yy934;
   yy937:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'S')
       goto yy941;
     if (yych == 's')
       goto yy941;
     goto yy934;
   yy938:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy942;
     if (yych == 'a')
       goto yy942;
     goto yy934;
   yy939:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy943;
     if (yych == 'e')
       goto yy943;
     goto yy934;
   yy940:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy937;
     if (yych == 'a')
       goto yy937;
     goto yy934;
   yy941:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'C')
       goto yy944;
     if (yych == 'c')
       goto yy944;
     goto yy934;
   yy942:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == ':')
       goto yy945;
     goto yy934;
   yy943:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == ':')
       goto yy947;
     goto yy934;
   yy944:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'R')
       goto yy948;
     if (yych == 'r')
@@ -13027,67 +13853,78 @@ bufsize_t _scan_dangerous_url(const unsigned char *p) {
     goto yy934;
   yy945:
     yyaccept = 1;
-    yych = *(marker = ++p);
+    YYSKIP();
+    YYBACKUP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy949;
     if (yych == 'i')
       goto yy949;
   yy946 : { return (bufsize_t)(p - start); }
   yy947:
-    ++p;
+    YYSKIP();
     goto yy946;
   yy948:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy950;
     if (yych == 'i')
       goto yy950;
     goto yy934;
   yy949:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'M')
       goto yy951;
     if (yych == 'm')
       goto yy951;
     goto yy934;
   yy950:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'P')
       goto yy952;
     if (yych == 'p')
       goto yy952;
     goto yy934;
   yy951:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'A')
       goto yy953;
     if (yych == 'a')
       goto yy953;
     goto yy934;
   yy952:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'T')
       goto yy943;
     if (yych == 't')
       goto yy943;
     goto yy934;
   yy953:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'G')
       goto yy954;
     if (yych != 'g')
       goto yy934;
   yy954:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy955;
     if (yych != 'e')
       goto yy934;
   yy955:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych != '/')
       goto yy934;
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych <= 'W') {
       if (yych <= 'J') {
         if (yych == 'G')
@@ -13122,65 +13959,74 @@ bufsize_t _scan_dangerous_url(const unsigned char *p) {
       }
     }
   yy957:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'I')
       goto yy961;
     if (yych == 'i')
       goto yy961;
     goto yy934;
   yy958:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'P')
       goto yy962;
     if (yych == 'p')
       goto yy962;
     goto yy934;
   yy959:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'N')
       goto yy963;
     if (yych == 'n')
       goto yy963;
     goto yy934;
   yy960:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy964;
     if (yych == 'e')
       goto yy964;
     goto yy934;
   yy961:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'F')
       goto yy965;
     if (yych == 'f')
       goto yy965;
     goto yy934;
   yy962:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'E')
       goto yy963;
     if (yych != 'e')
       goto yy934;
   yy963:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'G')
       goto yy965;
     if (yych == 'g')
       goto yy965;
     goto yy934;
   yy964:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'B')
       goto yy967;
     if (yych == 'b')
       goto yy967;
     goto yy934;
   yy965:
-    ++p;
+    YYSKIP();
     { return 0; }
   yy967:
-    yych = *++p;
+    YYSKIP();
+    yych = YYPEEK();
     if (yych == 'P')
       goto yy965;
     if (yych == 'p')
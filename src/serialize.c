@@ -0,0 +1,589 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmark.h"
+#include "node.h"
+#include "buffer.h"
+#include "chunk.h"
+
+/* A serialized tree is
+ *
+ *   "CMKB", SERIAL_VERSION and the number of nodes, each as four bytes
+ *   the number of syntax extensions used, and the name of each
+ *   the nodes, in document order
+ *
+ * in which every other number is a varint: seven bits to a byte, least
+ * significant first, with the top bit set on all but the last byte.
+ * Signed numbers that are usually small are zigzag encoded, and a
+ * string is its length followed by its bytes.  Nothing refers to an
+ * address, so a serialized tree can be loaded from anywhere, and
+ * strings are stored in place so that a view can point into them.
+ *
+ * A node is its type as one byte, followed by
+ *
+ *   a set of HAS_ bits for the optional fields below
+ *   its index minus that of its parent (0 for the root), which always
+ *   comes before it, so the tree can be rebuilt in a single pass
+ *   its source position, relative to the node before it
+ *   its flags, extension index, internal offset, string content and
+ *   HTML attributes, if the corresponding HAS_ bit is set
+ *   the chunks and numbers of its type (see cmark_node_chunks and
+ *   get_ints)
+ *
+ * Parsing leaves the literals of inlines pointing into the string
+ * content of the block that contains them; such a chunk is stored as
+ * an offset into that content instead of a string, and points into it
+ * again when it is loaded.
+ */
+
+#define SERIAL_MAGIC "CMKB"
+#define SERIAL_VERSION 1
+#define HEADER_SIZE 12
+
+#define HAS_FLAGS (1 << 0)
+#define HAS_EXTENSION (1 << 1)
+#define HAS_INTERNAL_OFFSET (1 << 2)
+#define HAS_CONTENT (1 << 3)
+#define HAS_ATTRS (1 << 4)
+
+#define MAX_INTS 7
+
+static void put_u32(cmark_strbuf *buf, uint32_t n) {
+  unsigned char bytes[4];
+
+  bytes[0] = (unsigned char)(n & 0xff);
+  bytes[1] = (unsigned char)((n >> 8) & 0xff);
+  bytes[2] = (unsigned char)((n >> 16) & 0xff);
+  bytes[3] = (unsigned char)((n >> 24) & 0xff);
+  cmark_strbuf_put(buf, bytes, 4);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+         (uint32_t)p[3] << 24;
+}
+
+static void put_varint(cmark_strbuf *buf, uint64_t n) {
+  unsigned char bytes[10];
+  bufsize_t len = 0;
+
+  while (n >= 0x80) {
+    bytes[len++] = (unsigned char)(n | 0x80);
+    n >>= 7;
+  }
+  bytes[len++] = (unsigned char)n;
+  cmark_strbuf_put(buf, bytes, len);
+}
+
+static uint64_t zigzag(int64_t n) {
+  return ((uint64_t)n << 1) ^ (uint64_t)(n >> 63);
+}
+
+static int64_t unzigzag(uint64_t n) {
+  return (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+}
+
+static void put_string(cmark_strbuf *buf, const unsigned char *data,
+                       bufsize_t len) {
+  put_varint(buf, (uint64_t)len);
+  if (len > 0)
+    cmark_strbuf_put(buf, data, len);
+}
+
+typedef struct {
+  const unsigned char *start;
+  const unsigned char *p;
+  const unsigned char *end;
+  bool error;
+} reader;
+
+static uint64_t get_varint(reader *r) {
+  uint64_t n = 0;
+  int shift;
+
+  for (shift = 0; shift < 64 && r->p < r->end; shift += 7) {
+    unsigned char byte = *r->p++;
+
+    n |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return n;
+  }
+  r->error = true;
+  return 0;
+}
+
+// A varint that must fit in a bufsize_t.
+static bufsize_t get_size(reader *r) {
+  uint64_t n = get_varint(r);
+
+  if (n > INT32_MAX) {
+    r->error = true;
+    return 0;
+  }
+  return (bufsize_t)n;
+}
+
+static const unsigned char *get_bytes(reader *r, bufsize_t len) {
+  const unsigned char *p = r->p;
+
+  if (len > r->end - r->p) {
+    r->error = true;
+    return NULL;
+  }
+  r->p += len;
+  return p;
+}
+
+// The rest of the data of 'node' for its type, as numbers; returns how
+// many.
+static int get_ints(cmark_node *node, int64_t *ints) {
+  switch (node->type) {
+  case CMARK_NODE_LIST:
+  case CMARK_NODE_ITEM:
+    ints[0] = node->as.list.list_type;
+    ints[1] = node->as.list.marker_offset;
+    ints[2] = node->as.list.padding;
+    ints[3] = node->as.list.start;
+    ints[4] = node->as.list.delimiter;
+    ints[5] = node->as.list.bullet_char;
+    ints[6] = node->as.list.tight;
+    return 7;
+  case CMARK_NODE_CODE_BLOCK:
+    ints[0] = node->as.code.fence_length;
+    ints[1] = node->as.code.fence_offset;
+    ints[2] = node->as.code.fence_char;
+    ints[3] = node->as.code.fenced;
+    return 4;
+  case CMARK_NODE_HEADING:
+    ints[0] = node->as.heading.level;
+    ints[1] = node->as.heading.setext;
+    return 2;
+  case CMARK_NODE_TABLE:
+    ints[0] = node->as.table.n_columns;
+    return 1;
+  case CMARK_NODE_TABLE_ROW:
+    ints[0] = node->as.table_row.is_header;
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// Set what get_ints returned, if the values are ones the setters in
+// node.c would accept.
+static bool set_ints(cmark_node *node, const int64_t *ints,
+                     int64_t max_columns) {
+  switch (node->type) {
+  case CMARK_NODE_LIST:
+  case CMARK_NODE_ITEM:
+    if (ints[0] < CMARK_NO_LIST || ints[0] > CMARK_ORDERED_LIST ||
+        ints[3] < 0 || ints[3] > INT32_MAX || ints[4] < CMARK_NO_DELIM ||
+        ints[4] > CMARK_PAREN_DELIM)
+      return false;
+    node->as.list.list_type = (cmark_list_type)ints[0];
+    node->as.list.marker_offset = (int)ints[1];
+    node->as.list.padding = (int)ints[2];
+    node->as.list.start = (int)ints[3];
+    node->as.list.delimiter = (cmark_delim_type)ints[4];
+    node->as.list.bullet_char = (unsigned char)ints[5];
+    node->as.list.tight = ints[6] != 0;
+    break;
+  case CMARK_NODE_CODE_BLOCK:
+    node->as.code.fence_length = (uint8_t)ints[0];
+    node->as.code.fence_offset = (uint8_t)ints[1];
+    node->as.code.fence_char = (unsigned char)ints[2];
+    node->as.code.fenced = (int8_t)ints[3];
+    break;
+  case CMARK_NODE_HEADING:
+    if (ints[0] < 1 || ints[0] > 6)
+      return false;
+    node->as.heading.level = (int)ints[0];
+    node->as.heading.setext = ints[1] != 0;
+    break;
+  case CMARK_NODE_TABLE:
+    if (ints[0] < 0 || ints[0] > max_columns)
+      return false;
+    node->as.table.n_columns = (int)ints[0];
+    break;
+  case CMARK_NODE_TABLE_ROW:
+    node->as.table_row.is_header = ints[0] != 0;
+    break;
+  default:
+    break;
+  }
+  return true;
+}
+
+typedef struct {
+  cmark_strbuf nodes;
+  cmark_strbuf extensions; // the cmark_syntax_extension pointers seen
+  int last_line;
+} writer;
+
+// The index of 'extension' in the extensions seen so far, adding it if
+// it is new.
+static uint32_t extension_index(writer *w, cmark_syntax_extension *extension) {
+  cmark_syntax_extension **seen =
+      (cmark_syntax_extension **)w->extensions.ptr;
+  uint32_t i, n = (uint32_t)(w->extensions.size / sizeof(*seen));
+
+  for (i = 0; i < n; i++) {
+    if (seen[i] == extension)
+      return i;
+  }
+  cmark_strbuf_put(&w->extensions, (unsigned char *)&extension,
+                   sizeof(extension));
+  return n;
+}
+
+// A chunk is stored as its length times two, plus one if it points
+// into 'owner', the string content of a block above it, in which case
+// its offset there follows instead of its bytes.
+static void put_chunk(cmark_strbuf *buf, cmark_chunk *c, cmark_node *owner) {
+  if (c->len > 0 && !c->alloc && owner != NULL &&
+      c->data >= owner->content.ptr &&
+      c->data + c->len <= owner->content.ptr + owner->content.size) {
+    put_varint(buf, (uint64_t)c->len << 1 | 1);
+    put_varint(buf, (uint64_t)(c->data - owner->content.ptr));
+  } else {
+    put_varint(buf, (uint64_t)c->len << 1);
+    if (c->len > 0)
+      cmark_strbuf_put(buf, c->data, c->len);
+  }
+}
+
+static void write_node(writer *w, cmark_node *node, uint32_t parent_delta,
+                       cmark_node *owner) {
+  cmark_strbuf *buf = &w->nodes;
+  int64_t ints[MAX_INTS];
+  cmark_chunk *a, *b;
+  int has = 0, i, n_ints;
+
+  if (node->flags)
+    has |= HAS_FLAGS;
+  if (node->extension)
+    has |= HAS_EXTENSION;
+  if (node->internal_offset)
+    has |= HAS_INTERNAL_OFFSET;
+  if (node->content.size)
+    has |= HAS_CONTENT;
+  if (node->html_attrs)
+    has |= HAS_ATTRS;
+
+  cmark_strbuf_putc(buf, node->type);
+  put_varint(buf, (uint64_t)has);
+  put_varint(buf, parent_delta);
+  put_varint(buf, zigzag((int64_t)node->start_line - w->last_line));
+  put_varint(buf, zigzag(node->start_column));
+  put_varint(buf, zigzag((int64_t)node->end_line - node->start_line));
+  put_varint(buf, zigzag(node->end_column));
+  w->last_line = node->start_line;
+
+  if (has & HAS_FLAGS)
+    put_varint(buf, node->flags);
+  if (has & HAS_EXTENSION)
+    put_varint(buf, extension_index(w, node->extension));
+  if (has & HAS_INTERNAL_OFFSET)
+    put_varint(buf, zigzag(node->internal_offset));
+  if (has & HAS_CONTENT)
+    put_string(buf, node->content.ptr, node->content.size);
+  if (has & HAS_ATTRS)
+    put_string(buf, (unsigned char *)node->html_attrs,
+               (bufsize_t)strlen(node->html_attrs));
+
+  cmark_node_chunks(node, &a, &b);
+  if (a)
+    put_chunk(buf, a, owner);
+  if (b)
+    put_chunk(buf, b, owner);
+  n_ints = get_ints(node, ints);
+  for (i = 0; i < n_ints; i++)
+    put_varint(buf, zigzag(ints[i]));
+}
+
+typedef struct {
+  uint32_t index;
+  cmark_node *owner; // the nearest block at or above with string content
+} path_entry;
+
+unsigned char *cmark_node_serialize(cmark_node *root, size_t *len) {
+  cmark_mem *mem = cmark_node_mem(root);
+  cmark_strbuf out = CMARK_BUF_INIT(mem);
+  writer w = {CMARK_BUF_INIT(mem), CMARK_BUF_INIT(mem), 0};
+  cmark_syntax_extension **seen;
+  cmark_node *node = root;
+  path_entry *path = NULL; // the nodes from the root to 'node'
+  size_t depth = 0, path_size = 0;
+  uint32_t index = 0, i, n_extensions;
+
+  while (node != NULL) {
+    cmark_node *owner = depth ? path[depth - 1].owner : NULL;
+
+    if (depth == path_size) {
+      path_size = path_size ? path_size * 2 : 64;
+      path = (path_entry *)mem->realloc(path, path_size * sizeof(*path));
+    }
+    write_node(&w, node, depth ? index - path[depth - 1].index : 0, owner);
+    path[depth].index = index++;
+    path[depth].owner = node->content.size ? node : owner;
+
+    if (node->first_child != NULL) {
+      node = node->first_child;
+      depth++;
+      continue;
+    }
+    while (node != root && node->next == NULL) {
+      node = node->parent;
+      depth--;
+    }
+    node = node == root ? NULL : node->next;
+  }
+  mem->free(path);
+
+  seen = (cmark_syntax_extension **)w.extensions.ptr;
+  n_extensions = (uint32_t)(w.extensions.size / sizeof(*seen));
+
+  cmark_strbuf_grow(&out, HEADER_SIZE + 64 + w.nodes.size);
+  cmark_strbuf_put(&out, (const unsigned char *)SERIAL_MAGIC, 4);
+  put_u32(&out, SERIAL_VERSION);
+  put_u32(&out, index);
+  put_varint(&out, n_extensions);
+  for (i = 0; i < n_extensions; i++)
+    put_string(&out, (unsigned char *)seen[i]->name,
+               (bufsize_t)strlen(seen[i]->name));
+  cmark_strbuf_put(&out, w.nodes.ptr, w.nodes.size);
+
+  cmark_strbuf_release(&w.extensions);
+  cmark_strbuf_release(&w.nodes);
+
+  *len = (size_t)out.size;
+  return cmark_strbuf_detach(&out);
+}
+
+// Read a chunk written by put_chunk.  Unless 'copy', its bytes are left
+// where they are.
+static void get_chunk(reader *r, cmark_mem *mem, cmark_node *owner, bool copy,
+                      cmark_chunk *c) {
+  uint64_t tag = get_varint(r);
+  bufsize_t len;
+
+  c->data = NULL;
+  c->len = 0;
+  c->alloc = 0;
+  if (tag >> 1 > INT32_MAX) {
+    r->error = true;
+    return;
+  }
+  len = (bufsize_t)(tag >> 1);
+  if (tag & 1) {
+    uint64_t offset = get_varint(r);
+
+    if (owner == NULL || offset > (uint64_t)owner->content.size ||
+        (uint64_t)len > owner->content.size - offset) {
+      r->error = true;
+      return;
+    }
+    c->data = owner->content.ptr + offset;
+    c->len = len;
+  } else if (len > 0) {
+    const unsigned char *data = get_bytes(r, len);
+
+    if (data == NULL)
+      return;
+    if (copy) {
+      c->data = (unsigned char *)mem->calloc(len + 1, 1);
+      memcpy(c->data, data, len);
+      c->alloc = 1;
+    } else {
+      c->data = (unsigned char *)data;
+    }
+    c->len = len;
+  }
+}
+
+// Read the node at 'index'; 'nodes' and 'owners' hold those before it
+// and the nearest block at or above each with string content.
+static cmark_node *read_node(reader *r, cmark_mem *mem, cmark_node **nodes,
+                             cmark_node **owners, uint32_t index,
+                             cmark_syntax_extension **extensions,
+                             uint32_t n_extensions, int *last_line,
+                             bool copy) {
+  cmark_node *node, *parent = NULL, *owner = NULL;
+  int64_t ints[MAX_INTS];
+  cmark_chunk *a, *b;
+  uint64_t has, parent_delta;
+  int type, i, n_ints;
+
+  if (r->p == r->end) {
+    r->error = true;
+    return NULL;
+  }
+  type = *r->p++;
+  has = get_varint(r);
+  parent_delta = get_varint(r);
+  if (type < CMARK_NODE_FIRST_BLOCK || type > CMARK_NODE_LAST_INLINE ||
+      (index == 0) != (parent_delta == 0) || parent_delta > index) {
+    r->error = true;
+    return NULL;
+  }
+  if (index > 0) {
+    parent = nodes[index - parent_delta];
+    owner = owners[index - parent_delta];
+    // The renderers rely on the tree being one that could have been
+    // built with cmark_node_append_child.
+    if (!cmark_node_can_contain_type(parent, (cmark_node_type)type)) {
+      r->error = true;
+      return NULL;
+    }
+  }
+
+  node = cmark_node_new_with_mem((cmark_node_type)type, mem);
+  node->start_line = (int)(*last_line + unzigzag(get_varint(r)));
+  node->start_column = (int)unzigzag(get_varint(r));
+  node->end_line = (int)(node->start_line + unzigzag(get_varint(r)));
+  node->end_column = (int)unzigzag(get_varint(r));
+  *last_line = node->start_line;
+
+  if (has & HAS_FLAGS)
+    node->flags = (uint16_t)get_varint(r);
+  if (has & HAS_EXTENSION) {
+    uint64_t ext = get_varint(r);
+
+    if (ext < n_extensions)
+      node->extension = extensions[ext];
+    else
+      r->error = true;
+  }
+  if (has & HAS_INTERNAL_OFFSET)
+    node->internal_offset = (int)unzigzag(get_varint(r));
+  if (has & HAS_CONTENT) {
+    bufsize_t len = get_size(r);
+    const unsigned char *data = get_bytes(r, len);
+
+    if (data != NULL)
+      cmark_strbuf_set(&node->content, data, len);
+  }
+  if (has & HAS_ATTRS) {
+    bufsize_t len = get_size(r);
+    const unsigned char *data = get_bytes(r, len);
+
+    if (data != NULL) {
+      // html_attrs is always released with free()
+      node->html_attrs = (char *)malloc((size_t)len + 1);
+      memcpy(node->html_attrs, data, (size_t)len);
+      node->html_attrs[len] = '\0';
+    }
+  }
+
+  cmark_node_chunks(node, &a, &b);
+  if (a)
+    get_chunk(r, mem, owner, copy, a);
+  if (b)
+    get_chunk(r, mem, owner, copy, b);
+  n_ints = get_ints(node, ints);
+  for (i = 0; i < n_ints; i++)
+    ints[i] = unzigzag(get_varint(r));
+  // The renderers write a delimiter row as wide as the table, so its
+  // width is limited to keep the output in proportion to the input.
+  if (!set_ints(node, ints, r->end - r->start))
+    r->error = true;
+
+  if (parent != NULL) {
+    node->parent = parent;
+    node->prev = parent->last_child;
+    if (parent->last_child)
+      parent->last_child->next = node;
+    else
+      parent->first_child = node;
+    parent->last_child = node;
+  }
+  owners[index] = node->content.size ? node : owner;
+  return node;
+}
+
+static cmark_node *deserialize(const unsigned char *data, size_t len,
+                               cmark_mem *mem, bool copy) {
+  reader r = {NULL, NULL, NULL, false};
+  cmark_syntax_extension **extensions = NULL;
+  cmark_node **nodes = NULL, **owners = NULL;
+  cmark_node *root = NULL;
+  uint32_t n_nodes, n_extensions = 0, i;
+  int last_line = 0;
+
+  if (data == NULL || len < HEADER_SIZE ||
+      memcmp(data, SERIAL_MAGIC, 4) != 0 ||
+      get_u32(data + 4) != SERIAL_VERSION)
+    return NULL;
+  n_nodes = get_u32(data + 8);
+  r.start = data;
+  r.p = data + HEADER_SIZE;
+  r.end = data + len;
+
+  // Every node takes at least seven bytes.
+  if (n_nodes == 0 || n_nodes > len / 7)
+    return NULL;
+
+  n_extensions = (uint32_t)get_varint(&r);
+  if (r.error || n_extensions > len)
+    return NULL;
+  if (n_extensions > 0) {
+    extensions = (cmark_syntax_extension **)mem->calloc(n_extensions,
+                                                        sizeof(*extensions));
+    for (i = 0; i < n_extensions && !r.error; i++) {
+      bufsize_t name_len = get_size(&r);
+      const unsigned char *name = get_bytes(&r, name_len);
+      char *cname;
+
+      if (name == NULL)
+        break;
+      cname = (char *)mem->calloc((size_t)name_len + 1, 1);
+      memcpy(cname, name, (size_t)name_len);
+      extensions[i] = cmark_find_syntax_extension(cname);
+      mem->free(cname);
+      if (extensions[i] == NULL)
+        r.error = true;
+    }
+  }
+
+  if (!r.error) {
+    nodes = (cmark_node **)mem->calloc(n_nodes, sizeof(*nodes));
+    owners = (cmark_node **)mem->calloc(n_nodes, sizeof(*owners));
+    for (i = 0; i < n_nodes && !r.error; i++) {
+      nodes[i] = read_node(&r, mem, nodes, owners, i, extensions,
+                           n_extensions, &last_line, copy);
+      if (nodes[i] == NULL)
+        break;
+    }
+    root = nodes[0];
+  }
+
+  // Anything left over means the data is not what it claims to be.
+  if (root != NULL && (r.error || r.p != r.end)) {
+    cmark_node_free(root);
+    root = NULL;
+  }
+  if (owners)
+    mem->free(owners);
+  if (nodes)
+    mem->free(nodes);
+  if (extensions)
+    mem->free(extensions);
+  return root;
+}
+
+cmark_node *cmark_node_deserialize_with_mem(const void *data, size_t len,
+                                            cmark_mem *mem) {
+  return deserialize((const unsigned char *)data, len, mem, true);
+}
+
+cmark_node *cmark_node_deserialize(const void *data, size_t len) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  return deserialize((const unsigned char *)data, len,
+                     &DEFAULT_MEM_ALLOCATOR, true);
+}
+
+cmark_node *cmark_node_deserialize_view(const void *data, size_t len) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  return deserialize((const unsigned char *)data, len,
+                     &DEFAULT_MEM_ALLOCATOR, false);
+}
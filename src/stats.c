@@ -0,0 +1,275 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmark.h"
+#include "node.h"
+#include "references.h"
+#include "stats.h"
+
+#if defined(_MSC_VER)
+#define CMARK_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define CMARK_THREAD_LOCAL __thread
+#else
+#define CMARK_THREAD_LOCAL
+#endif
+
+/* The sizes of the blocks allocated since the document started, keyed
+ * by address.  Blocks stay plain malloc memory, so anything the library
+ * hands out (rendered strings, for instance) can still be released with
+ * free(); frees of blocks from earlier documents are simply not found.
+ */
+typedef struct {
+  void *ptr;
+  size_t size;
+} tracked_block;
+
+struct cmark_stats_collector {
+  tracked_block *blocks; /* open addressing, linear probing */
+  size_t mask;
+  size_t count;
+  size_t live;
+  size_t delimiters_peak;
+  cmark_parser_stats current;
+  cmark_parser_stats finished;
+};
+
+static CMARK_THREAD_LOCAL cmark_stats_collector *active_collector = NULL;
+
+/* What the next allocation on this thread is for, as announced by
+ * cmark_stats_set_site.  Every allocation resets it. */
+static CMARK_THREAD_LOCAL cmark_alloc_site next_site = CMARK_ALLOC_OTHER;
+static CMARK_THREAD_LOCAL int next_node_type = -1;
+
+void cmark_stats_set_site(cmark_alloc_site site, int node_type) {
+  next_site = site;
+  next_node_type = node_type;
+}
+
+static size_t block_slot(cmark_stats_collector *c, void *ptr) {
+  uintptr_t h = (uintptr_t)ptr >> 4;
+  return (size_t)(h * 2654435761u) & c->mask;
+}
+
+static void track(cmark_stats_collector *c, void *ptr, size_t size);
+
+static void grow_blocks(cmark_stats_collector *c) {
+  tracked_block *old = c->blocks;
+  size_t old_size = c->mask + 1;
+  size_t i;
+
+  c->mask = old_size * 2 - 1;
+  c->blocks = (tracked_block *)calloc(c->mask + 1, sizeof(tracked_block));
+  if (c->blocks == NULL)
+    abort();
+  c->count = 0;
+  for (i = 0; i < old_size; i++) {
+    if (old[i].ptr)
+      track(c, old[i].ptr, old[i].size);
+  }
+  free(old);
+}
+
+static void track(cmark_stats_collector *c, void *ptr, size_t size) {
+  size_t i;
+
+  if (2 * (c->count + 1) > c->mask + 1)
+    grow_blocks(c);
+
+  for (i = block_slot(c, ptr); c->blocks[i].ptr; i = (i + 1) & c->mask) {
+    if (c->blocks[i].ptr == ptr)
+      break;
+  }
+  if (c->blocks[i].ptr == NULL)
+    c->count++;
+  c->blocks[i].ptr = ptr;
+  c->blocks[i].size = size;
+}
+
+// Remove 'ptr' and return its size, or return 0 if it is not tracked.
+// Entries after the hole are shifted back so probing needs no tombstones.
+static size_t untrack(cmark_stats_collector *c, void *ptr) {
+  size_t i, j, size;
+
+  for (i = block_slot(c, ptr); c->blocks[i].ptr != ptr; i = (i + 1) & c->mask) {
+    if (c->blocks[i].ptr == NULL)
+      return 0;
+  }
+
+  size = c->blocks[i].size;
+  c->count--;
+  for (j = (i + 1) & c->mask; c->blocks[j].ptr; j = (j + 1) & c->mask) {
+    size_t home = block_slot(c, c->blocks[j].ptr);
+    // Move the entry at 'j' into the hole unless its home slot lies
+    // cyclically in (i, j].
+    if ((j > i && (home <= i || home > j)) ||
+        (j < i && (home <= i && home > j))) {
+      c->blocks[i] = c->blocks[j];
+      i = j;
+    }
+  }
+  c->blocks[i].ptr = NULL;
+  c->blocks[i].size = 0;
+  return size;
+}
+
+static void note_alloc(cmark_stats_collector *c, size_t old_size,
+                       size_t new_size) {
+  cmark_parser_stats *stats = &c->current;
+
+  stats->allocations++;
+  stats->site_allocations[next_site]++;
+  if (new_size > old_size) {
+    stats->bytes_allocated += new_size - old_size;
+    stats->site_bytes[next_site] += new_size - old_size;
+  }
+  if (next_site == CMARK_ALLOC_NODE && next_node_type >= 0 &&
+      next_node_type <= CMARK_NODE_LAST_INLINE)
+    stats->node_allocations[next_node_type]++;
+  c->live = c->live - old_size + new_size;
+  if (c->live > stats->bytes_peak)
+    stats->bytes_peak = c->live;
+}
+
+static void *instrumented_calloc(size_t nmem, size_t size) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  void *ptr = DEFAULT_MEM_ALLOCATOR.calloc(nmem, size);
+  cmark_stats_collector *c = active_collector;
+
+  if (c) {
+    track(c, ptr, nmem * size);
+    note_alloc(c, 0, nmem * size);
+  }
+  cmark_stats_set_site(CMARK_ALLOC_OTHER, -1);
+  return ptr;
+}
+
+static void *instrumented_realloc(void *ptr, size_t size) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  cmark_stats_collector *c = active_collector;
+  size_t old_size = 0;
+  void *new_ptr;
+
+  if (c && ptr)
+    old_size = untrack(c, ptr);
+  new_ptr = DEFAULT_MEM_ALLOCATOR.realloc(ptr, size);
+  if (c) {
+    track(c, new_ptr, size);
+    note_alloc(c, old_size, size);
+  }
+  cmark_stats_set_site(CMARK_ALLOC_OTHER, -1);
+  return new_ptr;
+}
+
+static void instrumented_free(void *ptr) {
+  extern cmark_mem DEFAULT_MEM_ALLOCATOR;
+  cmark_stats_collector *c = active_collector;
+
+  if (c && ptr)
+    c->live -= untrack(c, ptr);
+  DEFAULT_MEM_ALLOCATOR.free(ptr);
+}
+
+cmark_mem INSTRUMENTED_MEM_ALLOCATOR = {
+    instrumented_calloc, instrumented_realloc, instrumented_free};
+
+cmark_mem *cmark_get_instrumented_mem_allocator(void) {
+  return &INSTRUMENTED_MEM_ALLOCATOR;
+}
+
+bool cmark_mem_is_instrumented(cmark_mem *mem) {
+  return mem == &INSTRUMENTED_MEM_ALLOCATOR;
+}
+
+cmark_stats_collector *cmark_stats_collector_new(void) {
+  cmark_stats_collector *c =
+      (cmark_stats_collector *)calloc(1, sizeof(cmark_stats_collector));
+  if (c == NULL)
+    abort();
+  c->mask = 63;
+  c->blocks = (tracked_block *)calloc(c->mask + 1, sizeof(tracked_block));
+  if (c->blocks == NULL)
+    abort();
+  return c;
+}
+
+void cmark_stats_collector_free(cmark_stats_collector *collector) {
+  if (collector == NULL)
+    return;
+  if (active_collector == collector)
+    active_collector = NULL;
+  free(collector->blocks);
+  free(collector);
+}
+
+cmark_stats_collector *cmark_stats_enter(cmark_stats_collector *collector) {
+  cmark_stats_collector *previous = active_collector;
+  active_collector = collector;
+  return previous;
+}
+
+void cmark_stats_leave(cmark_stats_collector *previous) {
+  active_collector = previous;
+}
+
+void cmark_stats_begin_document(cmark_stats_collector *collector) {
+  memset(collector->blocks, 0, (collector->mask + 1) * sizeof(tracked_block));
+  collector->count = 0;
+  collector->live = 0;
+  collector->delimiters_peak = 0;
+  memset(&collector->current, 0, sizeof(collector->current));
+}
+
+void cmark_stats_note_delimiters(cmark_stats_collector *collector,
+                                 size_t delimiters) {
+  if (delimiters > collector->delimiters_peak)
+    collector->delimiters_peak = delimiters;
+}
+
+void cmark_stats_finish_document(cmark_stats_collector *collector,
+                                 cmark_node *root,
+                                 cmark_reference_map *refmap) {
+  cmark_parser_stats *stats = &collector->current;
+  cmark_node *node = root;
+  int depth = 0;
+  unsigned int i;
+
+  while (node) {
+    if (node->type <= CMARK_NODE_LAST_INLINE)
+      stats->nodes[node->type]++;
+    stats->nodes_total++;
+    if (depth > stats->max_depth)
+      stats->max_depth = depth;
+
+    if (node->first_child) {
+      node = node->first_child;
+      depth++;
+      continue;
+    }
+    while (node && node != root && node->next == NULL) {
+      node = node->parent;
+      depth--;
+    }
+    node = (node == root || node == NULL) ? NULL : node->next;
+  }
+
+  for (i = 0; refmap && i < REFMAP_SIZE; i++) {
+    cmark_reference *ref;
+    for (ref = refmap->table[i]; ref; ref = ref->next)
+      stats->reference_definitions++;
+  }
+
+  stats->delimiters_peak = collector->delimiters_peak;
+  stats->bytes_live = collector->live;
+  collector->finished = *stats;
+}
+
+size_t cmark_stats_bytes_allocated(cmark_stats_collector *collector) {
+  return collector->current.bytes_allocated;
+}
+
+void cmark_stats_get(cmark_stats_collector *collector,
+                     cmark_parser_stats *stats) {
+  *stats = collector->finished;
+}
@@ -0,0 +1,71 @@
+#ifndef CMARK_STATS_H
+#define CMARK_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "cmark.h"
+
+/* Statistics collected by a parser that was created with the
+ * instrumented allocator.  Allocations are attributed to the collector
+ * that is active on the calling thread, which the parser sets around
+ * every call that works on its document.
+ */
+typedef struct cmark_stats_collector cmark_stats_collector;
+
+struct cmark_reference_map;
+
+extern cmark_mem INSTRUMENTED_MEM_ALLOCATOR;
+
+bool cmark_mem_is_instrumented(cmark_mem *mem);
+
+/* Attribute the next allocation on this thread to 'site' and, for
+ * nodes, to 'node_type' (or -1).  Allocations that are not announced
+ * count as CMARK_ALLOC_OTHER. */
+void cmark_stats_set_site(cmark_alloc_site site, int node_type);
+
+/* Announce the next allocation through 'mem'.  For allocators other
+ * than the instrumented one this costs a comparison. */
+#define CMARK_ALLOC_SITE(mem, site)                                            \
+  do {                                                                         \
+    if ((mem) == &INSTRUMENTED_MEM_ALLOCATOR)                                  \
+      cmark_stats_set_site((site), -1);                                        \
+  } while (0)
+
+#define CMARK_ALLOC_NODE_SITE(mem, node_type)                                  \
+  do {                                                                         \
+    if ((mem) == &INSTRUMENTED_MEM_ALLOCATOR)                                  \
+      cmark_stats_set_site(CMARK_ALLOC_NODE, (int)(node_type));                \
+  } while (0)
+
+cmark_stats_collector *cmark_stats_collector_new(void);
+void cmark_stats_collector_free(cmark_stats_collector *collector);
+
+/* Make 'collector' the active one on this thread, returning the one it
+ * replaces so that it can be handed back to cmark_stats_leave. */
+cmark_stats_collector *cmark_stats_enter(cmark_stats_collector *collector);
+void cmark_stats_leave(cmark_stats_collector *previous);
+
+/* Forget the blocks and counts of the previous document. */
+void cmark_stats_begin_document(cmark_stats_collector *collector);
+
+/* Record the shape of the finished document and make the statistics
+ * available to cmark_stats_get. */
+void cmark_stats_finish_document(cmark_stats_collector *collector,
+                                 cmark_node *root,
+                                 struct cmark_reference_map *refmap);
+
+void cmark_stats_note_delimiters(cmark_stats_collector *collector,
+                                 size_t delimiters);
+
+size_t cmark_stats_bytes_allocated(cmark_stats_collector *collector);
+
+void cmark_stats_get(cmark_stats_collector *collector,
+                     cmark_parser_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,13 +2,23 @@
 
 #include "cmark.h"
 #include "buffer.h"
+#include "cmark_atomic.h"
+
+cmark_syntax_extension *cmark_syntax_extension_ref(cmark_syntax_extension *extension) {
+  cmark_atomic_inc(&extension->refcount);
+  return extension;
+}
 
 void cmark_syntax_extension_free(cmark_syntax_extension *extension) {
+  if (cmark_atomic_dec(&extension->refcount) > 0)
+    return;
+
   if (extension->free_function && extension->priv) {
     extension->free_function(extension->priv);
   }
 
   cmark_llist_free(extension->special_inline_chars);
+  cmark_llist_free(extension->block_start_chars);
   free(extension->name);
   free(extension);
 }
@@ -19,5 +29,6 @@ cmark_syntax_extension *cmark_syntax_extension_new(const char *name) {
   cmark_strbuf name_buf = CMARK_BUF_INIT(&DEFAULT_MEM_ALLOCATOR);
   cmark_strbuf_sets(&name_buf, name);
   res->name = (char *) cmark_strbuf_detach(&name_buf);
+  res->refcount = 1;
   return res;
 }
@@ -4,6 +4,7 @@
 
 #include "cmark_ctype.h"
 #include "utf8.h"
+#include "case_fold.inc"
 
 static const int8_t utf8proc_utf8class[256] = {
     1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
@@ -224,17 +225,37 @@ void cmark_utf8proc_encode_char(int32_t uc, cmark_strbuf *buf) {
   cmark_strbuf_put(buf, dst, len);
 }
 
+static void S_case_fold_char(int32_t c, cmark_strbuf *dest) {
+  const struct cmark_case_fold *fold;
+
+  if (c >= CMARK_CASE_FOLD_LIMIT) {
+    cmark_utf8proc_encode_char(c, dest);
+    return;
+  }
+
+  fold = &cmark_case_folds[cmark_case_fold_blocks
+                               [cmark_case_fold_index[c >> CMARK_CASE_FOLD_SHIFT]]
+                               [c & ((1 << CMARK_CASE_FOLD_SHIFT) - 1)]];
+
+  if (fold->full[0]) {
+    cmark_utf8proc_encode_char(fold->full[0], dest);
+    cmark_utf8proc_encode_char(fold->full[1], dest);
+    if (fold->full[2])
+      cmark_utf8proc_encode_char(fold->full[2], dest);
+  } else {
+    cmark_utf8proc_encode_char(c + fold->delta, dest);
+  }
+}
+
 void cmark_utf8proc_case_fold(cmark_strbuf *dest, const uint8_t *str,
                               bufsize_t len) {
   int32_t c;
 
-#define bufpush(x) cmark_utf8proc_encode_char(x, dest)
-
   while (len > 0) {
     bufsize_t char_len = cmark_utf8proc_iterate(str, len, &c);
 
     if (char_len >= 0) {
-#include "case_fold_switch.inc"
+      S_case_fold_char(c, dest);
     } else {
       encode_unknown(dest);
       char_len = -char_len;
@@ -0,0 +1,39 @@
+#ifndef CMARK_WORK_H
+#define CMARK_WORK_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counts of the units of work done by the loops that have been
+ * quadratic in the past, for the complexity fuzzing harness, which
+ * compares them to the size of its input.  They are only kept when
+ * the library is compiled with CMARK_COUNT_WORK; the counters are
+ * global and not thread-safe, so that build is for fuzzing only.
+ */
+#ifdef CMARK_COUNT_WORK
+
+typedef struct {
+  size_t scanned_bytes;   /* bytes read by the re2c scanners */
+  size_t delimiter_steps; /* iterations over the emphasis delimiter stack */
+  size_t bracket_steps;   /* bytes and nodes visited behind a ']' */
+  size_t output_bytes;    /* bytes written by the renderers */
+} cmark_work_counters;
+
+extern cmark_work_counters cmark_work;
+
+#define CMARK_COUNT_WORK_UNITS(field, n) (cmark_work.field += (size_t)(n))
+
+#else
+
+#define CMARK_COUNT_WORK_UNITS(field, n) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,8 +7,9 @@
 #include "node.h"
 #include "buffer.h"
 #include "houdini.h"
-
-#define BUFFER_SIZE 100
+#include "cmark_clock.h"
+#include "work.h"
+#include "probes.h"
 
 // Functions to convert cmark_nodes to XML strings.
 
@@ -35,7 +36,6 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
   bool literal = false;
   cmark_delim_type delim;
   bool entering = (ev_type == CMARK_EVENT_ENTER);
-  char buffer[BUFFER_SIZE];
 
   if (entering) {
     indent(state);
@@ -43,10 +43,15 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
     cmark_strbuf_puts(xml, cmark_node_get_type_string(node));
 
     if (options & CMARK_OPT_SOURCEPOS && node->start_line != 0) {
-      snprintf(buffer, BUFFER_SIZE, " sourcepos=\"%d:%d-%d:%d\"",
-               node->start_line, node->start_column, node->end_line,
-               node->end_column);
-      cmark_strbuf_puts(xml, buffer);
+      cmark_strbuf_puts(xml, " sourcepos=\"");
+      cmark_strbuf_put_int(xml, node->start_line);
+      cmark_strbuf_putc(xml, ':');
+      cmark_strbuf_put_int(xml, node->start_column);
+      cmark_strbuf_putc(xml, '-');
+      cmark_strbuf_put_int(xml, node->end_line);
+      cmark_strbuf_putc(xml, ':');
+      cmark_strbuf_put_int(xml, node->end_column);
+      cmark_strbuf_putc(xml, '"');
     }
 
     literal = false;
@@ -69,9 +74,9 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
       switch (cmark_node_get_list_type(node)) {
       case CMARK_ORDERED_LIST:
         cmark_strbuf_puts(xml, " type=\"ordered\"");
-        snprintf(buffer, BUFFER_SIZE, " start=\"%d\"",
-                 cmark_node_get_list_start(node));
-        cmark_strbuf_puts(xml, buffer);
+        cmark_strbuf_puts(xml, " start=\"");
+        cmark_strbuf_put_int(xml, cmark_node_get_list_start(node));
+        cmark_strbuf_putc(xml, '"');
         delim = cmark_node_get_list_delim(node);
         if (delim == CMARK_PAREN_DELIM) {
           cmark_strbuf_puts(xml, " delim=\"paren\"");
@@ -85,13 +90,14 @@ static int S_render_node(cmark_node *node, cmark_event_type ev_type,
       default:
         break;
       }
-      snprintf(buffer, BUFFER_SIZE, " tight=\"%s\"",
-               (cmark_node_get_list_tight(node) ? "true" : "false"));
-      cmark_strbuf_puts(xml, buffer);
+      cmark_strbuf_puts(xml, cmark_node_get_list_tight(node)
+                                 ? " tight=\"true\""
+                                 : " tight=\"false\"");
       break;
     case CMARK_NODE_HEADING:
-      snprintf(buffer, BUFFER_SIZE, " level=\"%d\"", node->as.heading.level);
-      cmark_strbuf_puts(xml, buffer);
+      cmark_strbuf_puts(xml, " level=\"");
+      cmark_strbuf_put_int(xml, node->as.heading.level);
+      cmark_strbuf_putc(xml, '"');
       break;
     case CMARK_NODE_CODE_BLOCK:
       if (node->as.code.info.len > 0) {
@@ -152,9 +158,12 @@ char *cmark_render_xml(cmark_node *root, int options) {
   cmark_event_type ev_type;
   cmark_node *cur;
   struct render_state state = {&xml, 0};
+  cmark_profile *profile = cmark_node_profile(root);
+  uint64_t start = profile ? cmark_clock_ns() : 0;
 
   cmark_iter *iter = cmark_iter_new(root);
 
+  CMARK_PROBE1(render__start, CMARK_PHASE_RENDER_XML);
   cmark_strbuf_puts(state.xml, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
   cmark_strbuf_puts(state.xml,
                     "<!DOCTYPE document SYSTEM \"CommonMark.dtd\">\n");
@@ -162,8 +171,13 @@ char *cmark_render_xml(cmark_node *root, int options) {
     cur = cmark_iter_get_node(iter);
     S_render_node(cur, ev_type, &state, options);
   }
+  CMARK_PROBE2(render__done, CMARK_PHASE_RENDER_XML, xml.size);
+  CMARK_COUNT_WORK_UNITS(output_bytes, xml.size);
   result = (char *)cmark_strbuf_detach(&xml);
 
   cmark_iter_free(iter);
+  if (profile)
+    cmark_profile_add(profile, CMARK_PHASE_RENDER_XML, start,
+                      cmark_clock_ns());
   return result;
 }
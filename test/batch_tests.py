@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import os
+import argparse
+import sys
+import shutil
+import tempfile
+from subprocess import run, PIPE
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Run cmark --batch tests.')
+    parser.add_argument('--program', dest='program', required=True,
+            help='cmark executable to test')
+    args = parser.parse_args(sys.argv[1:])
+
+# input files, relative to the directory the batch is run in
+inputs = {
+    'top.md': '# Top\n\nSome *text*.\n',
+    'docs/guide.md': '- one\n- two\n\n> quoted\n',
+    'docs/api/ref.markdown': '[link][ref]\n\n[ref]: /url "title"\n',
+    'docs/api/deep/code.md': '```c\nint x;\n```\n',
+    'notes.txt': 'Plain text & <html>\n',
+}
+
+passed = 0
+failed = 0
+
+def check(description, ok, detail=''):
+    global passed, failed
+    if ok:
+        print(description, '[PASSED]')
+        passed += 1
+    else:
+        print(description, '[FAILED]')
+        if detail:
+            print(detail)
+        failed += 1
+
+program = os.path.abspath(args.program)
+
+def cmark(*argv, cwd):
+    return run([program] + list(argv), cwd=cwd, stdout=PIPE, stderr=PIPE)
+
+tmpdir = tempfile.mkdtemp()
+try:
+    for name, text in inputs.items():
+        path = os.path.join(tmpdir, name)
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, 'w', encoding='utf-8') as f:
+            f.write(text)
+
+    print("Testing --batch:")
+    # one of them named through "..", which is resolved
+    names = sorted(inputs)
+    names[names.index('top.md')] = 'docs/api/../../top.md'
+    p = cmark('--batch', '-j', '2', '-o', 'out', *names, cwd=tmpdir)
+    check('batch exits 0', p.returncode == 0, p.stderr.decode('utf-8'))
+
+    expected_outputs = set()
+    for name in sorted(inputs):
+        output = os.path.splitext(name)[0] + '.html'
+        expected_outputs.add(os.path.join('out', output))
+        expected = cmark('-t', 'html', name, cwd=tmpdir).stdout
+        try:
+            with open(os.path.join(tmpdir, 'out', output), 'rb') as f:
+                actual = f.read()
+        except OSError as e:
+            actual = str(e).encode('utf-8')
+        check('%s -> %s' % (name, output), actual == expected,
+              repr(actual))
+
+    written = set()
+    for root, dirs, files in os.walk(os.path.join(tmpdir, 'out')):
+        for f in files:
+            written.add(os.path.relpath(os.path.join(root, f), tmpdir))
+    check('no other files are written', written == expected_outputs,
+          repr(sorted(written)))
+
+    print("Testing --batch output paths:")
+    shutil.rmtree(os.path.join(tmpdir, 'out'))
+    p = cmark('--batch', '-j', '2', '-o', 'out', 'docs/guide.md',
+              'top.md', 'docs/api/../guide.md', cwd=tmpdir)
+    err = p.stderr.decode('utf-8')
+    check('clashing outputs fail', p.returncode != 0)
+    check('clash names both inputs',
+          'docs/guide.md and docs/api/../guide.md' in err and
+          'out/docs/guide.html' in err, err)
+    check('nothing is written on a clash',
+          not os.path.exists(os.path.join(tmpdir, 'out')))
+
+    with open(os.path.join(tmpdir, 'notes.md'), 'w') as f:
+        f.write('notes\n')
+    p = cmark('--batch', '-o', 'out', 'notes.md', 'notes.txt', cwd=tmpdir)
+    err = p.stderr.decode('utf-8')
+    check('same name with another suffix clashes', p.returncode != 0 and
+          'notes.md and notes.txt' in err, err)
+
+    p = cmark('--batch', '-o', 'out', 'docs/../../top.md', cwd=tmpdir)
+    err = p.stderr.decode('utf-8')
+    check('paths leaving the output directory fail',
+          p.returncode != 0 and 'no output path inside out' in err, err)
+finally:
+    shutil.rmtree(tmpdir)
+
+print("{} passed, {} failed".format(passed, failed))
+exit(0 if failed == 0 else 1)
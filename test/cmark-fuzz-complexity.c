@@ -0,0 +1,143 @@
+/* A libFuzzer harness that looks for inputs on which cmark does more
+ * than linear work.  The library is compiled with CMARK_COUNT_WORK, so
+ * that the loops which have been quadratic in the past count what they
+ * do (see work.h), and an input is reported as a crash when a count
+ * exceeds its limit below.  Run it through
+ * test/run-cmark-fuzz-complexity, which saves those inputs under
+ * test/afl_test_cases.
+ *
+ * The limits are a fixed number of units per byte of input, with room
+ * for the output that the formats themselves make grow faster than
+ * that: every reference link repeats its destination and title, and
+ * the XML and CommonMark renderers indent or prefix lines in
+ * proportion to their depth.  CMARK_FUZZ_WORK_SCALE in the environment
+ * multiplies all of them.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmark.h"
+#include "work.h"
+
+#ifndef CMARK_COUNT_WORK
+#error "cmark-fuzz-complexity must be compiled with CMARK_COUNT_WORK"
+#endif
+
+/* Units of work allowed on top of the limits, as even an empty document
+ * has some output. */
+#define WORK_ALLOWANCE 1024
+
+/* Bytes of output allowed, across all five renderers, for each level
+ * of nesting of each node. */
+#define OUTPUT_PER_LEVEL 16
+
+static size_t work_scale = 1;
+
+static const struct {
+  const char *name;
+  size_t offset;
+  size_t per_byte;
+} work_limits[] = {
+    {"bytes scanned", offsetof(cmark_work_counters, scanned_bytes), 64},
+    {"delimiter stack steps", offsetof(cmark_work_counters, delimiter_steps),
+     8},
+    {"bracket lookback steps", offsetof(cmark_work_counters, bracket_steps),
+     8},
+    {"bytes of output", offsetof(cmark_work_counters, output_bytes), 160},
+};
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  const char *scale = getenv("CMARK_FUZZ_WORK_SCALE");
+
+  (void)argc;
+  (void)argv;
+  if (scale != NULL && atoi(scale) > 0)
+    work_scale = (size_t)atoi(scale);
+  return 0;
+}
+
+/* Add up the depth of every node below 'root' and the length of every
+ * link destination and title. */
+static void measure_tree(cmark_node *root, size_t *nesting, size_t *copied) {
+  cmark_node *node = root;
+  size_t depth = 0;
+
+  *nesting = 0;
+  *copied = 0;
+  while (node != NULL) {
+    cmark_node_type type = cmark_node_get_type(node);
+
+    *nesting += depth;
+    if (type == CMARK_NODE_LINK || type == CMARK_NODE_IMAGE)
+      *copied += strlen(cmark_node_get_url(node)) +
+                 strlen(cmark_node_get_title(node));
+
+    if (cmark_node_first_child(node) != NULL) {
+      node = cmark_node_first_child(node);
+      depth++;
+      continue;
+    }
+    while (node != root && cmark_node_next(node) == NULL) {
+      node = cmark_node_parent(node);
+      depth--;
+    }
+    node = node == root ? NULL : cmark_node_next(node);
+  }
+}
+
+static void check_work(size_t size, size_t nesting, size_t copied) {
+  size_t i;
+
+  for (i = 0; i < sizeof(work_limits) / sizeof(work_limits[0]); i++) {
+    size_t work =
+        *(const size_t *)((const char *)&cmark_work + work_limits[i].offset);
+    size_t limit = work_limits[i].per_byte * size;
+
+    if (work_limits[i].offset == offsetof(cmark_work_counters, output_bytes))
+      limit += work_limits[i].per_byte * copied + OUTPUT_PER_LEVEL * nesting;
+    limit = WORK_ALLOWANCE + limit * work_scale;
+
+    if (work > limit) {
+      fprintf(stderr,
+              "cmark-fuzz-complexity: %zu %s for %zu bytes of input "
+              "(limit %zu)\n",
+              work, work_limits[i].name, size, limit);
+      abort();
+    }
+  }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  int options = 0;
+  if (size > sizeof(options)) {
+    size_t nesting, copied;
+
+    /* First 4 bytes of input are treated as options */
+    memcpy(&options, data, sizeof(options));
+
+    /* Mask off valid option bits */
+    options = options & (CMARK_OPT_SOURCEPOS | CMARK_OPT_HARDBREAKS | CMARK_OPT_SAFE | CMARK_OPT_NOBREAKS | CMARK_OPT_NORMALIZE | CMARK_OPT_VALIDATE_UTF8 | CMARK_OPT_SMART);
+
+    /* Remainder of input is the markdown */
+    const char *markdown = (const char *)(data + sizeof(options));
+    const size_t markdown_size = size - sizeof(options);
+
+    memset(&cmark_work, 0, sizeof(cmark_work));
+
+    cmark_node *doc = cmark_parse_document(markdown, markdown_size, options);
+
+    free(cmark_render_commonmark(doc, options, 80));
+    free(cmark_render_html(doc, options));
+    free(cmark_render_latex(doc, options, 80));
+    free(cmark_render_man(doc, options, 80));
+    free(cmark_render_xml(doc, options));
+
+    measure_tree(doc, &nesting, &copied);
+    cmark_node_free(doc);
+
+    check_work(markdown_size, nesting, copied);
+  }
+  return 0;
+}
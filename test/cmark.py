@@ -1,10 +1,12 @@
 #!/usr/bin/env python3
 # -*- coding: utf-8 -*-
 
-from ctypes import CDLL, c_char_p, c_size_t, c_int, c_void_p
+from ctypes import CDLL, Structure, byref, c_char_p, c_size_t, c_int, c_void_p
+from ctypes.util import find_library
 from subprocess import *
 import platform
 import os
+import time
 
 def pipe_through_prog(prog, text):
     p1 = Popen(prog.split(), stdout=PIPE, stdin=PIPE, stderr=PIPE)
@@ -20,6 +22,67 @@ def to_html(lib, text):
     result = markdown(textbytes, textlen, 0).decode('utf-8')
     return [0, result, '']
 
+class ParserLimits(Structure):
+    _fields_ = [('max_bytes', c_size_t),
+                ('max_nodes', c_size_t),
+                ('max_depth', c_int),
+                ('max_delimiters', c_size_t)]
+
+# indexed by cmark_parser_error
+limit_names = [None, 'bytes', 'nodes', 'depth', 'delimiters']
+
+def to_html_with_limits(lib, text, limits):
+    textbytes = text.encode('utf-8')
+    textlen = len(textbytes)
+    get_mem = lib.cmark_get_instrumented_mem_allocator
+    get_mem.restype = c_void_p
+    parser_new = lib.cmark_parser_new_with_mem
+    parser_new.restype = c_void_p
+    parser_new.argtypes = [c_int, c_void_p]
+    set_limits = lib.cmark_parser_set_limits
+    set_limits.argtypes = [c_void_p, c_void_p]
+    feed = lib.cmark_parser_feed
+    feed.argtypes = [c_void_p, c_char_p, c_size_t]
+    finish = lib.cmark_parser_finish
+    finish.restype = c_void_p
+    finish.argtypes = [c_void_p]
+    get_error = lib.cmark_parser_get_error
+    get_error.restype = c_int
+    get_error.argtypes = [c_void_p]
+    parser_free = lib.cmark_parser_free
+    parser_free.argtypes = [c_void_p]
+    render_html = lib.cmark_render_html
+    render_html.restype = c_char_p
+    render_html.argtypes = [c_void_p, c_int]
+    node_free = lib.cmark_node_free
+    node_free.argtypes = [c_void_p]
+    parser = parser_new(0, get_mem())
+    set_limits(parser, byref(ParserLimits(**limits)))
+    feed(parser, textbytes, textlen)
+    node = finish(parser)
+    error = get_error(parser)
+    result = render_html(node, 0).decode('utf-8')
+    node_free(node)
+    parser_free(parser)
+    if error:
+        return [1, result, 'Input exceeds the limit on %s' % limit_names[error]]
+    return [0, result, '']
+
+def limit_flags(limits):
+    return ''.join(' --%s %d' % (name.replace('_', '-'), value)
+                   for (name, value) in limits.items())
+
+def time_to_html(lib, libc, textbytes):
+    markdown = lib.cmark_markdown_to_html
+    markdown.restype = c_void_p
+    markdown.argtypes = [c_char_p, c_size_t, c_int]
+    libc.free.argtypes = [c_void_p]
+    start = time.perf_counter()
+    result = markdown(textbytes, len(textbytes), 0)
+    elapsed = time.perf_counter() - start
+    libc.free(result)
+    return elapsed
+
 def to_commonmark(lib, text):
     textbytes = text.encode('utf-8')
     textlen = len(textbytes)
@@ -39,6 +102,7 @@ class CMark:
         if prog:
             self.to_html = lambda x: pipe_through_prog(prog, x)
             self.to_commonmark = lambda x: pipe_through_prog(prog + ' -t commonmark', x)
+            self.to_html_with_limits = lambda x, limits: pipe_through_prog(prog + limit_flags(limits), x)
         else:
             sysname = platform.system()
             if sysname == 'Darwin':
@@ -57,4 +121,8 @@ class CMark:
             cmark = CDLL(libpath)
             self.to_html = lambda x: to_html(cmark, x)
             self.to_commonmark = lambda x: to_commonmark(cmark, x)
+            self.to_html_with_limits = lambda x, limits: to_html_with_limits(cmark, x, limits)
+            # seconds taken to convert utf-8 encoded input to HTML
+            libc = CDLL(find_library('msvcrt' if sysname == 'Windows' else 'c'))
+            self.time_to_html = lambda x: time_to_html(cmark, libc, x)
 
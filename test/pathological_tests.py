@@ -4,6 +4,9 @@
 import re
 import argparse
 import sys
+import os
+import glob
+import math
 import platform
 import multiprocessing
 import time
@@ -15,6 +18,17 @@ if __name__ == "__main__":
             help='program to test')
     parser.add_argument('--library-dir', dest='library_dir', nargs='?',
             default=None, help='directory containing dynamic library')
+    parser.add_argument('--scaling', action='store_true',
+            help='measure how the time taken grows with input size instead')
+    parser.add_argument('--margin', type=float, default=0.3,
+            help='fail a pattern in --scaling mode whose time grows faster '
+                 'than size to the power MARGIN more than that of plain '
+                 'paragraphs (default 0.3)')
+    parser.add_argument('--min-size', type=int, default=65536,
+            help='smallest input in --scaling mode, in bytes (default 65536)')
+    parser.add_argument('--steps', type=int, default=4,
+            help='number of sizes in --scaling mode, each twice the last '
+                 '(default 4)')
     args = parser.parse_args(sys.argv[1:])
 
 allowed_failures = {"many references": True}
@@ -48,6 +62,9 @@ pathological = {
     "link openers and emph closers":
                  (("[ a_" * 50000),
                   re.compile("(\[ a_){50000}")),
+    "emph openers before links":
+                 (("*[a](b)" * 30000),
+                  re.compile("(<em><a href=\"b\">a</a></em><a href=\"b\">a</a>){15000}")),
     "hard link/emph case":
                  ("**x [a*b**c*](d)",
                   re.compile("\\*\\*x <a href=\"d\">a<em>b\\*\\*c</em></a>")),
@@ -77,48 +94,213 @@ pathological = {
 #                  re.compile("(\[0\] ){4999}"))
     }
 
+# inputs that must be cut off by a parser limit: description ->
+# (input, limits, name of the limit that trips, regex for the partial output)
+limited = {
+    "node limit on many paragraphs":
+                 (("a\n\n" * 1000000), {'max_nodes': 1000}, 'nodes',
+                  re.compile("^(<p>a</p>\n){1001}$")),
+    "node limit on many inlines":
+                 (("*a* " * 1000000), {'max_nodes': 1000}, 'nodes',
+                  re.compile("^<p>[*a ]+</p>\n$")),
+    "depth limit on nested block quotes":
+                 ((("> " * 50000) + "a"), {'max_depth': 100}, 'depth',
+                  re.compile("^(<blockquote>\n){100}(</blockquote>\n){100}$")),
+    "depth limit on nested strong emph":
+                 (("*a **a " * 65000) + "b" + (" a** a*" * 65000),
+                  {'max_depth': 10}, 'depth',
+                  re.compile("^<p>(<em>a <strong>a ){4}<em></em> a</strong> a</em>")),
+    "delimiter limit on mismatched openers and closers":
+                 (("*a_ " * 50000), {'max_delimiters': 1000}, 'delimiters',
+                  re.compile("^<p>([*]a[_] ){49999}[*]a_</p>\n$")),
+    "memory limit on many paragraphs":
+                 (("a\n\n" * 1000000), {'max_bytes': 1000000}, 'bytes',
+                  re.compile("^(<p>a</p>\n)+$")),
+    }
+
+# the patterns above as functions of a repetition count, for --scaling
+scaling = {
+    "nested strong emph":
+                 lambda n: ("*a **a " * n) + "b" + (" a** a*" * n),
+    "many emph closers with no openers":
+                 lambda n: "a_ " * n,
+    "many emph openers with no closers":
+                 lambda n: "_a " * n,
+    "many link closers with no openers":
+                 lambda n: "a]" * n,
+    "many link openers with no closers":
+                 lambda n: "[a" * n,
+    "mismatched openers and closers":
+                 lambda n: "*a_ " * n,
+    "openers and closers multiple of 3":
+                 lambda n: "a**b" + ("c* " * n),
+    "link openers and emph closers":
+                 lambda n: "[ a_" * n,
+    "emph openers before links":
+                 lambda n: "*[a](b)" * n,
+    "nested brackets":
+                 lambda n: ("[" * n) + "a" + ("]" * n),
+    "nested block quotes":
+                 lambda n: ("> " * n) + "a",
+    "deeply nested lists":
+                 lambda n: "".join(map(lambda x: ("  " * x + "* a\n"), range(0,n))),
+    "backticks":
+                 lambda n: "".join(map(lambda x: ("e" + "`" * x), range(1,n))),
+    "unclosed links A":
+                 lambda n: "[a](<b" * n,
+    "unclosed links B":
+                 lambda n: "[a](b" * n,
+    "many references":
+                 lambda n: "".join(map(lambda x: ("[" + str(x) + "]: u\n"), range(1,n))) + "[0] " * n,
+    }
+
+# and the benchmark samples, repeated
+samples_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           '..', 'bench', 'samples')
+for path in sorted(glob.glob(os.path.join(samples_dir, '*.md'))):
+    with open(path, encoding='utf-8') as f:
+        scaling['sample ' + os.path.basename(path)] = \
+            (lambda text: lambda n: text * n)(f.read())
+
 whitespace_re = re.compile('/s+/')
 
-results = {'passed': [], 'errored': [], 'failed': [], 'ignored': []}
+# exit codes of the test processes
+PASSED, FAILED, ERRORED = 0, 1, 2
 
-def run_pathological_test(description, results):
+def run_pathological_test(description):
     (inp, regex) = pathological[description]
     [rc, actual, err] = cmark.to_html(inp)
-    extra = ""
     if rc != 0:
         print(description, '[ERRORED (return code %d)]' %rc)
         print(err)
-        if allowed_failures[description]:
-            results['ignored'].append(description)
-        else:
-            results['errored'].append(description)
+        exit(ERRORED)
     elif regex.search(actual):
         print(description, '[PASSED]')
-        results['passed'].append(description)
+        exit(PASSED)
     else:
         print(description, '[FAILED]')
         print(repr(actual))
-        if allowed_failures[description]:
-            results['ignored'].append(description)
-        else:
-            results['failed'].append(description)
-
-print("Testing pathological cases:")
-for description in pathological:
-    p = multiprocessing.Process(target=run_pathological_test,
-              args=(description, results,))
+        exit(FAILED)
+
+def run_limited_test(description):
+    (inp, limits, limit, regex) = limited[description]
+    [rc, actual, err] = cmark.to_html_with_limits(inp, limits)
+    if isinstance(err, bytes):
+        err = err.decode('utf-8')
+    if rc == 0 or ('limit on ' + limit) not in err:
+        print(description, '[FAILED (limit on %s did not trip)]' % limit)
+        print(err)
+        exit(FAILED)
+    elif regex.search(actual):
+        print(description, '[PASSED]')
+        exit(PASSED)
+    else:
+        print(description, '[FAILED]')
+        print(repr(actual[:1000]))
+        exit(FAILED)
+
+results = {'passed': [], 'errored': [], 'failed': [], 'ignored': []}
+
+# The fastest of several conversions, so that one slow run caused by the
+# rest of the system does not count.
+def best_time(textbytes):
+    best = None
+    total = 0.0
+    runs = 0
+    while runs < 3 or total < 0.2:
+        elapsed = cmark.time_to_html(textbytes)
+        best = elapsed if best is None else min(best, elapsed)
+        total += elapsed
+        runs += 1
+    return best
+
+# Fit t = c * size^k to the times taken for inputs of geometrically
+# increasing size and return k, which is 1 for linear growth.  Inputs
+# stop growing once one takes more than 2 seconds.
+def growth_exponent(generate):
+    n = 1
+    while len(generate(n).encode('utf-8')) < args.min_size:
+        n *= 2
+    best_time(generate(n).encode('utf-8'))  # warm up
+    xs = []
+    ys = []
+    for step in range(args.steps):
+        textbytes = generate(n << step).encode('utf-8')
+        elapsed = best_time(textbytes)
+        xs.append(math.log(len(textbytes)))
+        ys.append(math.log(elapsed))
+        if elapsed > 2.0:
+            break
+    if len(xs) < 2:
+        return None
+    mx = sum(xs) / len(xs)
+    my = sum(ys) / len(ys)
+    return (sum((x - mx) * (y - my) for (x, y) in zip(xs, ys)) /
+            sum((x - mx) ** 2 for x in xs))
+
+# Plain paragraphs take time linear in their size, so the exponent
+# measured for them is what linear growth looks like on this machine,
+# caches and all; the patterns are measured against it.
+def control(n):
+    return "Some *plain* text in a paragraph.\n\n" * n
+
+def run_scaling_test(description, limit):
+    k = growth_exponent(scaling[description])
+    if k is not None and k > limit:
+        # measure again before failing, as a busy system can make the
+        # larger inputs look slow
+        k = min(k, growth_exponent(scaling[description]) or k)
+    if k is None:
+        print(description, '[ERRORED (smallest input took too long)]')
+        outcome = 'errored'
+    elif k > limit:
+        print(description, '[FAILED (time grows as size^%.2f)]' % k)
+        outcome = 'failed'
+    else:
+        print(description, '[PASSED (size^%.2f)]' % k)
+        outcome = 'passed'
+    if outcome != 'passed' and allowed_failures.get(description):
+        outcome = 'ignored'
+    results[outcome].append(description)
+
+def run_in_process(target, description):
+    p = multiprocessing.Process(target=target, args=(description,))
     p.start()
     # wait 4 seconds or until it finishes
     p.join(4)
     # kill it if still active
     if p.is_alive():
         print(description, '[TIMEOUT]')
-        if allowed_failures[description]:
-            results['ignored'].append(description)
-        else:
-            results['errored'].append(description)
         p.terminate()
         p.join()
+        outcome = 'errored'
+    elif p.exitcode == PASSED:
+        outcome = 'passed'
+    elif p.exitcode == FAILED:
+        outcome = 'failed'
+    else:
+        outcome = 'errored'
+    if outcome != 'passed' and allowed_failures.get(description):
+        outcome = 'ignored'
+    results[outcome].append(description)
+
+if args.scaling:
+    if args.program:
+        print("--scaling needs the library, not --program")
+        exit(2)
+    print("Testing that time grows linearly with input size:")
+    linear = min(growth_exponent(control), growth_exponent(control))
+    print("plain paragraphs [size^%.2f]" % linear)
+    for description in scaling:
+        run_scaling_test(description, linear + args.margin)
+else:
+    print("Testing pathological cases:")
+    for description in pathological:
+        run_in_process(run_pathological_test, description)
+
+    print("Testing parser limits:")
+    for description in limited:
+        run_in_process(run_limited_test, description)
 
 passed  = len(results['passed'])
 failed  = len(results['failed'])
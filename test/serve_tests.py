@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import os
+import argparse
+import sys
+from subprocess import run, PIPE
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Run cmark --serve tests.')
+    parser.add_argument('--program', dest='program', required=True,
+            help='cmark executable to test')
+    args = parser.parse_args(sys.argv[1:])
+
+program = os.path.abspath(args.program)
+
+table = '| a | b |\n| - | - |\n| 1 | 2 |\n'
+
+# (options, body, expected response): 'ok' responses are compared with
+# the output of cmark run with the same options on the same body.
+requests = [
+    ('', '# Heading\n\nSome *text*.\n', 'ok'),
+    ('-e piped-tables', table, 'ok'),
+    ('', table, 'ok'),
+    ('--bogus', 'never parsed\n', ('error', 'Unknown option --bogus')),
+    ('--smart -t xml', '"quoted" -- text\n', 'ok'),
+    ('-e no-such-extension', 'x\n', ('error',
+                                     'Unknown extension no-such-extension')),
+    ('', '', 'ok'),
+    ('--sourcepos', '- a\n- b\n', 'ok'),
+]
+# and enough more of different sizes to keep several threads busy
+for i in range(60):
+    requests.append(('', ('para %d *em*\n\n' % i) * (1 + (i * 37) % 200),
+                     'ok'))
+
+passed = 0
+failed = 0
+
+def check(description, ok, detail=''):
+    global passed, failed
+    if ok:
+        print(description, '[PASSED]')
+        passed += 1
+    else:
+        print(description, '[FAILED]')
+        if detail:
+            print(detail)
+        failed += 1
+
+def frame(options, body):
+    data = body.encode('utf-8')
+    return ('%d %s\n' % (len(data), options)).encode('utf-8') + data
+
+def expected_response(options, body, expected):
+    if expected != 'ok':
+        return expected
+    p = run([program] + options.split(), input=body.encode('utf-8'),
+            stdout=PIPE, stderr=PIPE)
+    return ('ok', p.stdout.decode('utf-8'))
+
+# Split the output of --serve into (status, body) pairs.
+def responses(out):
+    result = []
+    while out:
+        header, _, out = out.partition(b'\n')
+        status, length = header.decode('utf-8').split(' ')
+        length = int(length)
+        result.append((status, out[:length].decode('utf-8')))
+        out = out[length:]
+    return result
+
+def serve(stream, jobs):
+    argv = [program, '--serve']
+    if jobs > 1:
+        argv += ['-j', str(jobs)]
+    p = run(argv, input=stream, stdout=PIPE, stderr=PIPE)
+    return (p.returncode, responses(p.stdout))
+
+expected = [expected_response(*r) for r in requests]
+stream = b''.join(frame(options, body) for (options, body, _) in requests)
+
+for jobs in (1, 4):
+    print("Testing --serve with %d thread(s):" % jobs)
+    rc, actual = serve(stream, jobs)
+    check('valid stream exits 0', rc == 0, 'return code %d' % rc)
+    check('one response per request', len(actual) == len(expected),
+          '%d responses' % len(actual))
+    for i, (want, got) in enumerate(zip(expected, actual)):
+        if want != got:
+            check('response %d' % i, False, repr(got)[:500])
+            break
+    else:
+        check('responses in request order', len(actual) == len(expected))
+
+    # a truncated body ends the stream after the responses before it
+    rc, actual = serve(stream + b'100\nshort', jobs)
+    check('truncated body fails', rc != 0, 'return code %d' % rc)
+    check('truncated body is reported',
+          actual[:-1] == expected and
+          actual[-1:] == [('error', 'Truncated request body')],
+          repr(actual[-2:]))
+
+    rc, actual = serve(frame('', 'a\n') + b'x2 --smart\nab', jobs)
+    check('invalid length is reported', rc != 0 and actual == [
+        ('ok', '<p>a</p>\n'), ('error', 'Invalid request length x2')],
+          repr(actual))
+
+print("{} passed, {} failed".format(passed, failed))
+exit(0 if failed == 0 else 1)
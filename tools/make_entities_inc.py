@@ -1,5 +1,7 @@
-# Creates C data structures for binary lookup table of entities,
-# using python's html5 entity data.
+# Creates C data structures for the entity lookup table, using
+# python's html5 entity data.  Entities are looked up through a
+# minimal perfect hash (hash and displace), so that resolving a
+# name costs at most two hashes and a single string comparison.
 # Usage: python3 tools/make_entities_inc.py > src/entities.inc
 
 import html
@@ -11,8 +13,61 @@ entities5 = html.entities.html5
 # without a semicolon.
 entities = sorted([(k[:-1], entities5[k].encode('utf-8')) for k in entities5.keys() if k[-1] == ';'])
 
+# FNV-1a variant; must match S_entity_hash in src/houdini_html_u.c.
+def entity_hash(seed, key):
+  h = seed if seed else 0x01000193
+  for c in key.encode('ascii'):
+    h = ((h * 0x01000193) ^ c) & 0xffffffff
+  return h
+
+# Builds the displacement table.  For every bucket
+# entity_hash(0, key) % n, the table holds either a seed d such
+# that entity_hash(d, key) % n places every key of that bucket in a
+# free slot, or -(index + 1) when the bucket has a single key that
+# is stored at 'index' directly.
+def make_perfect_hash(keys):
+  n = len(keys)
+  buckets = [[] for _ in range(n)]
+  for i, key in enumerate(keys):
+    buckets[entity_hash(0, key) % n].append(i)
+
+  displacements = [0] * n
+  slots = [None] * n
+  order = sorted(range(n), key=lambda b: -len(buckets[b]))
+
+  for b in order:
+    if len(buckets[b]) <= 1:
+      break
+    seed = 1
+    while True:
+      placed = []
+      for i in buckets[b]:
+        slot = entity_hash(seed, keys[i]) % n
+        if slots[slot] is not None or slot in placed:
+          break
+        placed.append(slot)
+      else:
+        break
+      seed += 1
+    displacements[b] = seed
+    for i, slot in zip(buckets[b], placed):
+      slots[slot] = i
+
+  free = [s for s in range(n) if slots[s] is None]
+  for b in order:
+    if len(buckets[b]) == 1:
+      slot = free.pop()
+      slots[slot] = buckets[b][0]
+      displacements[b] = -slot - 1
+
+  return displacements, slots
+
+keys = [ent for (ent, bs) in entities]
+displacements, slots = make_perfect_hash(keys)
+assert all(-32768 <= d <= 32767 for d in displacements)
+
 # Print out the header:
-print("""/* Autogenerated by tools/make_headers_inc.py */
+print("""/* Autogenerated by tools/make_entities_inc.py */
 
 struct cmark_entity_node {
 	unsigned char *entity;
@@ -24,9 +79,19 @@ struct cmark_entity_node {
 
 print("#define CMARK_NUM_ENTITIES " + str(len(entities)));
 
+# The entity table is emitted in hash slot order, so that the
+# perfect hash yields an index into it directly.
 print("\nstatic const struct cmark_entity_node cmark_entities[] = {");
 
-for (ent, bs) in entities:
+for i in slots:
+  (ent, bs) = entities[i]
   print('{(unsigned char*)"' + ent + '", {' + ', '.join(map(str, bs)) + ', 0}},')
 
 print("};")
+
+print("\nstatic const int16_t cmark_entity_displacements[] = {");
+
+for i in range(0, len(displacements), 12):
+  print('  ' + ', '.join(map(str, displacements[i:i + 12])) + ',')
+
+print("};")
@@ -1,22 +1,93 @@
-binmode STDOUT;
-print("    switch (c) {\n");
-my $lastchar = "";
+# Generates a two-level lookup table for Unicode case folding from
+# CaseFolding.txt.  Code points are split into blocks of 128; the
+# first level maps a block number to one of the distinct blocks, and
+# each block entry indexes the list of distinct foldings.
+# Usage: perl tools/mkcasefold.pl < data/CaseFolding.txt > src/case_fold.inc
+
+use strict;
+use warnings;
+
+my $shift = 7;
+my $block_size = 1 << $shift;
+
+my %folds;
+my $max = 0;
 while (<STDIN>) {
   if (/^[A-F0-9]/ and / [CF]; /) {
     my ($char, $type, $subst) = m/([A-F0-9]+); ([CF]); ([^;]+)/;
-    if ($char eq $lastchar) {
-      break;
-    }
-    my @subst = $subst =~ m/(\w+)/g;
-    printf("      case 0x%s:\n", $char);
-    foreach (@subst) {
-      printf("        bufpush(0x%s);\n", $_);
+    my $c = hex($char);
+    my @subst = map { hex($_) } ($subst =~ m/(\w+)/g);
+    $folds{$c} = \@subst;
+    $max = $c if $c > $max;
+  }
+}
+
+my $limit = (($max >> $shift) + 1) << $shift;
+
+# Distinct foldings: entry 0 is the identity.  Single code point
+# foldings are stored as a delta so that runs like A-Z share an entry;
+# multiple code point foldings are spelled out.
+my @values = ("{0, {0, 0, 0}}");
+my %value_index = ($values[0] => 0);
+my @entries;
+for (my $c = 0; $c < $limit; $c++) {
+  my $value = $values[0];
+  if (exists $folds{$c}) {
+    my @subst = @{$folds{$c}};
+    if (@subst == 1) {
+      $value = sprintf("{%d, {0, 0, 0}}", $subst[0] - $c);
+    } else {
+      die "folding of $c too long" if @subst > 3;
+      die "folding of $c outside BMP" if grep { $_ > 0xFFFF } @subst;
+      push @subst, 0 while @subst < 3;
+      $value = sprintf("{0, {0x%04X, 0x%04X, 0x%04X}}", @subst);
     }
-    printf("        break;\n");
-    $lastchar = $char;
   }
+  if (!exists $value_index{$value}) {
+    $value_index{$value} = scalar @values;
+    push @values, $value;
+  }
+  push @entries, $value_index{$value};
+}
+die "too many distinct foldings" if @values > 256;
+
+my @blocks = (join(", ", (0) x $block_size));
+my %block_index = ($blocks[0] => 0);
+my @stage1;
+for (my $b = 0; $b < $limit / $block_size; $b++) {
+  my $block = join(", ", @entries[$b * $block_size .. ($b + 1) * $block_size - 1]);
+  if (!exists $block_index{$block}) {
+    $block_index{$block} = scalar @blocks;
+    push @blocks, $block;
+  }
+  push @stage1, $block_index{$block};
 }
-printf("      default:\n");
-printf("        bufpush(c);\n");
-print("    }\n");
+die "too many distinct blocks" if @blocks > 256;
 
+sub print_list {
+  my @list = @_;
+  while (my @line = splice(@list, 0, 16)) {
+    print("    ", join(", ", @line), ",\n");
+  }
+}
+
+print("/* Autogenerated by tools/mkcasefold.pl */\n\n");
+printf("#define CMARK_CASE_FOLD_SHIFT %d\n", $shift);
+printf("#define CMARK_CASE_FOLD_LIMIT 0x%X\n\n", $limit);
+print("struct cmark_case_fold {\n");
+print("  int32_t delta;\n");
+print("  uint16_t full[3];\n");
+print("};\n\n");
+print("static const struct cmark_case_fold cmark_case_folds[] = {\n");
+print("    $_,\n") foreach @values;
+print("};\n\n");
+printf("static const uint8_t cmark_case_fold_blocks[][%d] = {\n", $block_size);
+foreach (@blocks) {
+  print("  {\n");
+  print_list(split(/, /, $_));
+  print("  },\n");
+}
+print("};\n\n");
+print("static const uint8_t cmark_case_fold_index[] = {\n");
+print_list(@stage1);
+print("};\n");